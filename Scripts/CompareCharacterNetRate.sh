@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# Character bandwidth at the old 66 Hz with raw replicated aim vs 20 Hz through the simulated proxy snapshot buffer,
+# over the latency harness (same clients, lag and loss for both runs).
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/CompareCharacterNetRate.sh [clients] [pktlag ms] [pktloss %] [seconds]
+#
+# Every process appends a row to Saved/Profiling/MPShooter/NetBandwidth.csv: the server's has the bandwidth, the
+# clients' the snapshot delay and how often aim had to be extrapolated. MPShooter.NetBandwidth waits for the join (the server
+# for all CLIENTS, each client for its own connection) before it measures, so MEASURE has to fit in what's left of the run:
+# the harness starts clients 15 s after the server, and the server stops DURATION seconds after it started.
+set -euo pipefail
+
+CLIENTS=${1:-4}
+PKTLAG=${2:-0}
+PKTLOSS=${3:-0}
+DURATION=${4:-90}
+MEASURE=$((DURATION - 35)) # clients start at 15 s, plus up to 20 s to load in and connect
+if ((MEASURE < 10)); then
+	echo "seconds must be at least 45" >&2
+	exit 1
+fi
+
+ROOT="$(cd "$(dirname "$0")" && pwd)"
+
+LABEL="66hz_raw" EXTRA_EXEC="MPShooter.CharacterNetRate 66, MPShooter.AimSnapshots 0, MPShooter.NetBandwidth $MEASURE 66hz_raw $CLIENTS" \
+	"$ROOT/RunLatencyHarness.sh" "$CLIENTS" "$PKTLAG" "$PKTLOSS" "$DURATION"
+LABEL="20hz_snapshots" EXTRA_EXEC="MPShooter.CharacterNetRate 20, MPShooter.AimSnapshots 1, MPShooter.NetBandwidth $MEASURE 20hz_snapshots $CLIENTS" \
+	"$ROOT/RunLatencyHarness.sh" "$CLIENTS" "$PKTLAG" "$PKTLOSS" "$DURATION"
@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+# Generic replication vs Iris over the latency harness, same clients, lag and loss for both runs. Needs a target built
+# with bUseIris = true. Server CPU comes from "stat MPShooter" / Governor.csv, bandwidth from
+# Saved/Profiling/MPShooter/NetBandwidth.csv (the Iris column tells the rows apart). The bandwidth is measured once every
+# client has joined, see CompareCharacterNetRate.sh.
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/CompareIris.sh [clients] [pktlag ms] [pktloss %] [seconds]
+set -euo pipefail
+
+CLIENTS=${1:-4}
+PKTLAG=${2:-0}
+PKTLOSS=${3:-0}
+DURATION=${4:-90}
+MEASURE=$((DURATION - 35)) # clients start at 15 s, plus up to 20 s to load in and connect
+if ((MEASURE < 10)); then
+	echo "seconds must be at least 45" >&2
+	exit 1
+fi
+
+ROOT="$(cd "$(dirname "$0")" && pwd)"
+
+for IRIS in 0 1; do
+	LABEL="iris$IRIS" EXTRA_ARGS="-UseIrisReplication=$IRIS" EXTRA_EXEC="MPShooter.NetBandwidth $MEASURE iris$IRIS $CLIENTS" \
+		"$ROOT/RunLatencyHarness.sh" "$CLIENTS" "$PKTLAG" "$PKTLOSS" "$DURATION"
+done
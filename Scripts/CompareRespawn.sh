@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+# Respawn cost with and without the pawn pool: a bot server runs once with MPShooter.UsePawnPool 1 and once with 0, and
+# MPShooter.RespawnReport appends respawn time and respawn frame time (the hitch) per path to
+# Saved/Profiling/MPShooter/Respawn.csv. The first death of each bot always spawns, so the pooled run has a few spawned rows too.
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/CompareRespawn.sh [bots] [seconds]
+set -euo pipefail
+
+BOTS=${1:-32}
+DURATION=${2:-300}
+PORT=${PORT:-7777}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+
+for POOL in 1 0; do
+	timeout --signal=INT $((DURATION + 60)) "$UE_EDITOR" "$PROJECT" "$MAP" -server -port="$PORT" -Bots="$BOTS" -unattended -nosound -log \
+		-ExecCmds="MPShooter.UsePawnPool $POOL, MPShooter.RespawnReport $DURATION pool$POOL" -abslog="$ROOT/Saved/Logs/Respawn_pool$POOL.log" || true
+done
+
+tail -n 4 "$ROOT/Saved/Profiling/MPShooter/Respawn.csv" 2>/dev/null || true
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+# Server replication time with 500 pickups in the level, weapon dormancy on vs off. One local dedicated server and N idle
+# headless clients per run; the server waits for all of them to join before it starts measuring. Results are appended to
+# Saved/Profiling/MPShooter/WeaponDormancy.csv (one row per run, DormancyEnable tells them apart).
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/CompareWeaponDormancy.sh [clients] [weapons] [seconds]
+set -euo pipefail
+
+CLIENTS=${1:-4}
+WEAPONS=${2:-500}
+MEASURE=${3:-30}
+PORT=${PORT:-7777}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+
+for DORMANCY in 1 0; do
+	LABEL="dormancy$DORMANCY"
+	"$UE_EDITOR" "$PROJECT" "$MAP" -server -port="$PORT" -unattended -nosound -log -abslog="$ROOT/Saved/Logs/WeaponDormancy_$LABEL.log" \
+		-ExecCmds="net.DormancyEnable $DORMANCY, MPShooter.BenchWeaponDormancy $WEAPONS $MEASURE $CLIENTS $LABEL" &
+	SERVER_PID=$!
+	trap 'kill $SERVER_PID ${CLIENT_PIDS[*]:-} 2>/dev/null || true' EXIT
+	sleep 15 # map load
+
+	CLIENT_PIDS=()
+	for ((i = 0; i < CLIENTS; i++)); do
+		"$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -nullrhi -windowed -resx=640 -resy=360 -unattended -nosound &
+		CLIENT_PIDS+=($!)
+	done
+
+	# join, measure, and some slack; the row is written when the measurement ends
+	sleep $((MEASURE + 45))
+	kill "$SERVER_PID" "${CLIENT_PIDS[@]}" 2>/dev/null || true
+	wait || true
+	trap - EXIT
+done
+
+tail -n 4 "$ROOT/Saved/Profiling/MPShooter/WeaponDormancy.csv" 2>/dev/null || true
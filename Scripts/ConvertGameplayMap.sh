@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Converts the gameplay map to World Partition (as <Map>_WP next to the original) and measures load time and
+# resident memory of both versions on a dedicated server and one client.
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/ConvertGameplayMap.sh [map package]
+#
+# Point GM_Lobby's GameplayMap at the _WP map afterwards. Results: Saved/Profiling/MPShooter/MapLoad.csv
+# on each process (not cleared between runs).
+set -euo pipefail
+
+MAP=${1:-/Game/Maps/BlasterMap}
+PORT=${PORT:-7777}
+SETTLE=${SETTLE:-30}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+OUT="$ROOT/Saved/MapLoad"
+mkdir -p "$OUT"
+
+if [[ ! -f "$ROOT/Content/${MAP#/Game/}_WP.umap" ]]; then
+	"$UE_EDITOR" "$PROJECT" "$MAP" -run=WorldPartitionConvertCommandlet -AllowCommandletRendering -ConversionSuffix \
+		-SCCProvider=None -unattended -abslog="$OUT/Convert.log"
+fi
+
+for TARGET in "$MAP" "${MAP}_WP"; do
+	NAME=$(basename "$TARGET")
+	"$UE_EDITOR" "$PROJECT" "$TARGET" -server -port="$PORT" -unattended -nosound -log \
+		-ini:Engine:[ConsoleVariables]:wp.Runtime.EnableServerStreaming=1 -abslog="$OUT/Server_$NAME.log" &
+	SERVER_PID=$!
+	sleep 15
+	timeout "$SETTLE" "$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -nullrhi -windowed -resx=640 -resy=360 -unattended -nosound -log \
+		-abslog="$OUT/Client_$NAME.log" || true
+	kill "$SERVER_PID" 2>/dev/null || true
+	wait "$SERVER_PID" 2>/dev/null || true
+done
+
+grep -h "Map load" "$OUT"/Server_*.log "$OUT"/Client_*.log || true
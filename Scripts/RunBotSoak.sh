@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+# Bot soak: a dedicated server with N bots and no clients. Bot cost per frame (average / max, decisions per frame, decisions
+# that missed the budget) is appended to Saved/Profiling/MPShooter/Bots.csv every REPORT seconds; the goal is under 1 ms
+# average with 64 bots. Game thread and the rest of the server from "stat MPShooter" / Governor.csv as usual.
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/RunBotSoak.sh [bots] [seconds]
+set -euo pipefail
+
+BOTS=${1:-64}
+DURATION=${2:-300}
+REPORT=${REPORT:-30}
+PORT=${PORT:-7777}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+
+timeout --signal=INT "$DURATION" "$UE_EDITOR" "$PROJECT" "$MAP" -server -port="$PORT" -Bots="$BOTS" -unattended -nosound -log \
+	-ExecCmds="MPShooter.Bots.ReportInterval $REPORT${EXTRA_EXEC:+, $EXTRA_EXEC}" -abslog="$ROOT/Saved/Logs/BotSoak.log" || true
+
+tail -n 20 "$ROOT/Saved/Profiling/MPShooter/Bots.csv" 2>/dev/null || true
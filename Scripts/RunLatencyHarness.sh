@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+# Fire-to-impact latency harness: one local dedicated server and N headless clients over loopback.
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/RunLatencyHarness.sh [clients] [pktlag ms] [pktloss %] [seconds]
+#
+# Map, project and weapon come from the environment (MAP, PROJECT); EXTRA_EXEC adds console commands on every
+# process (comma separated) and EXTRA_ARGS command line arguments. Results land in Saved/LatencyHarness and
+# a summary row is appended to Saved/LatencyHarness/Summary.csv (not cleared between runs, so runs can be compared).
+set -euo pipefail
+
+CLIENTS=${1:-4}
+PKTLAG=${2:-0}
+PKTLOSS=${3:-0}
+DURATION=${4:-60}
+FIRE_INTERVAL=${FIRE_INTERVAL:-0.25}
+PORT=${PORT:-7777}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+OUT="$ROOT/Saved/LatencyHarness"
+LABEL=${LABEL:-"lag${PKTLAG}_loss${PKTLOSS}_clients${CLIENTS}"}
+
+mkdir -p "$OUT"
+rm -f "$OUT"/Server_*.csv "$OUT"/Client_*.csv
+
+# Packet emulation only affects outgoing packets, so it is set on both ends: lag and loss are per direction.
+HARNESS_ARGS=(${EXTRA_ARGS:-} -LatencyHarness -HarnessDuration="$DURATION" -HarnessFireInterval="$FIRE_INTERVAL" -unattended -nosound -log
+	-ExecCmds="Net PktLag=$PKTLAG, Net PktLoss=$PKTLOSS${EXTRA_EXEC:+, $EXTRA_EXEC}")
+
+"$UE_EDITOR" "$PROJECT" "$MAP" -server -port="$PORT" "${HARNESS_ARGS[@]}" -abslog="$OUT/Server.log" &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null || true' EXIT
+sleep 15 # map load
+
+CLIENT_PIDS=()
+for ((i = 0; i < CLIENTS; i++)); do
+	"$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -nullrhi -windowed -resx=640 -resy=360 "${HARNESS_ARGS[@]}" \
+		-abslog="$OUT/Client_$i.log" &
+	CLIENT_PIDS+=($!)
+done
+
+wait "${CLIENT_PIDS[@]}" || true
+wait "$SERVER_PID" || true
+trap - EXIT
+
+"$UE_EDITOR" "$PROJECT" -run=LatencyHarnessReport -Dir="$OUT" -Label="$LABEL" -CSV="$OUT/Summary.csv" -unattended -nullrhi
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+# Nameplate cost before/after: a local dedicated server with 63 bots and one rendering client. The client waits for all 64
+# characters, measures with the HUD's batched nameplates, then with the old per-character widget components, and appends
+# both rows to Saved/Profiling/MPShooter/Nameplates.csv.
+#
+#   UE_EDITOR=/path/to/UnrealEditor WIDGET=/Game/Path/WBP_Overhead.WBP_Overhead_C ./Scripts/RunNameplateBench.sh [seconds]
+set -euo pipefail
+
+DURATION=${1:-20}
+BOTS=${BOTS:-63}
+PORT=${PORT:-7777}
+WIDGET=${WIDGET:?set WIDGET to the overhead widget blueprint class the characters used to carry}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+
+"$UE_EDITOR" "$PROJECT" "$MAP" -server -port="$PORT" -Bots="$BOTS" -unattended -nosound -log -abslog="$ROOT/Saved/Logs/NameplateServer.log" &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null || true' EXIT
+sleep 15 # map load
+
+# vsync off and a fixed resolution, so frame times aren't capped or resolution bound. ExecCmds all run at startup, so the
+# client is stopped by the timeout (up to 180 s waiting for the characters plus both phases), not by a quit.
+timeout --signal=INT $((DURATION * 2 + 240)) "$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -windowed -resx=1920 -resy=1080 -unattended -nosound \
+	-ExecCmds="r.VSync 0, t.MaxFPS 0, MPShooter.BenchNameplates $DURATION $((BOTS + 1)) $WIDGET" -abslog="$ROOT/Saved/Logs/NameplateClient.log" || true
+
+tail -n 2 "$ROOT/Saved/Profiling/MPShooter/Nameplates.csv" 2>/dev/null || true
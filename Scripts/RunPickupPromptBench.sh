@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+# Pickup prompt cost before/after: one standalone rendering game spawns 300 weapons, measures with the HUD's shared pickup
+# prompt, then with the old per-weapon widget components, and appends both rows to Saved/Profiling/MPShooter/PickupPrompts.csv.
+#
+#   UE_EDITOR=/path/to/UnrealEditor WIDGET=/Game/Path/WBP_PickupWidget.WBP_PickupWidget_C ./Scripts/RunPickupPromptBench.sh [seconds]
+set -euo pipefail
+
+DURATION=${1:-20}
+WEAPONS=${WEAPONS:-300}
+WIDGET=${WIDGET:?set WIDGET to the pickup widget blueprint class the weapons used to carry}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+
+# vsync off and a fixed resolution, so frame times aren't capped or resolution bound. ExecCmds all run at startup, so the
+# game is stopped by the timeout (map load plus both phases), not by a quit.
+timeout --signal=INT $((DURATION * 2 + 120)) "$UE_EDITOR" "$PROJECT" "$MAP" -game -windowed -resx=1920 -resy=1080 -unattended -nosound \
+	-ExecCmds="r.VSync 0, t.MaxFPS 0, MPShooter.BenchPickupPrompts $DURATION $WEAPONS $WIDGET" -abslog="$ROOT/Saved/Logs/PickupPromptBench.log" || true
+
+tail -n 2 "$ROOT/Saved/Profiling/MPShooter/PickupPrompts.csv" 2>/dev/null || true
@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+# Dedicated server that comes back mid-match: whenever the server process dies (crash, kill, OOM) it is started again with
+# -RestoreSnapshot, which skips the lobby, loads the gameplay map the last snapshot was taken on and puts the match back.
+# Players rejoin on the same port. A clean exit (status 0) ends the loop. To patch a running server, run the
+# MPShooter.Snapshot.Save console command, kill the process, swap the build and let the loop start it again.
+# Snapshot cost and restore times are in Saved/Profiling/MPShooter/Snapshot.csv.
+#
+#   UE_EDITOR=/path/to/UnrealEditor ./Scripts/RunRecoverableServer.sh [snapshot interval s]
+set -uo pipefail
+
+INTERVAL=${1:-10}
+PORT=${PORT:-7777}
+MAX_RESTARTS=${MAX_RESTARTS:-10}
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PROJECT=${PROJECT:-"$ROOT/MPShooter.uproject"}
+MAP=${MAP:-/Game/Maps/BlasterMap}
+UE_EDITOR=${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}
+
+RESTORE=""
+for ((RUN = 0; RUN <= MAX_RESTARTS; RUN++)); do
+	"$UE_EDITOR" "$PROJECT" "$MAP" -server -port="$PORT" $RESTORE ${EXTRA_ARGS:-} -unattended -nosound -log \
+		-ExecCmds="MPShooter.Snapshot.Interval $INTERVAL${EXTRA_EXEC:+, $EXTRA_EXEC}" -abslog="$ROOT/Saved/Logs/RecoverableServer_$RUN.log"
+	STATUS=$?
+	[ "$STATUS" -eq 0 ] && break
+	echo "Server exited with $STATUS, restarting from the last snapshot"
+	RESTORE=-RestoreSnapshot
+done
+
+tail -n 20 "$ROOT/Saved/Profiling/MPShooter/Snapshot.csv" 2>/dev/null || true
@@ -2,8 +2,83 @@
 
 
 #include "GM_Lobby.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
 #include "GameFramework/GameStateBase.h"
+#include "HAL/IConsoleManager.h"
+#include "WorldPartition/WorldPartition.h"
 
+// wp.Runtime.EnableServerStreaming is process wide. The lobby sets it for the map it travels to and puts the previous value back
+// once that map's World Partition has read it, so later worlds (and the editor, in PIE) get the value they had before.
+namespace LobbyServerStreaming
+{
+	static TOptional<int32> SavedValue; // the value before the lobby set it
+	static FString MatchPackage; // the map it was set for, without PIE prefix
+	static FDelegateHandle WorldInitHandle;
+	static FDelegateHandle TravelFailureHandle;
+
+	static void Restore()
+	{
+		FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitHandle);
+		WorldInitHandle.Reset();
+		if (GEngine)
+		{
+			GEngine->OnTravelFailure().Remove(TravelFailureHandle);
+		}
+		TravelFailureHandle.Reset();
+		if (!SavedValue.IsSet()) return;
+
+		if (IConsoleVariable* ServerStreaming = IConsoleManager::Get().FindConsoleVariable(TEXT("wp.Runtime.EnableServerStreaming")))
+		{
+			ServerStreaming->Set(SavedValue.GetValue(), ECVF_SetByCode);
+		}
+		SavedValue.Reset();
+	}
+
+	static void OnWorldInitializedActors(const FActorsInitializedParams& Params)
+	{
+		UWorld* World = Params.World;
+		if (World == nullptr || UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()) != MatchPackage) return; // the transition map
+
+		if (UWorldPartition* WorldPartition = World->GetWorldPartition())
+		{
+			WorldPartition->IsServerStreamingEnabled(); // reads the cvar once and keeps the result for the world's lifetime
+		}
+		Restore();
+	}
+
+	static void OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString)
+	{
+		Restore(); // the match map never loaded
+	}
+
+	static void Set(bool bEnabled, const FString& Package)
+	{
+		IConsoleVariable* ServerStreaming = IConsoleManager::Get().FindConsoleVariable(TEXT("wp.Runtime.EnableServerStreaming"));
+		if (ServerStreaming == nullptr) return;
+
+		if (!SavedValue.IsSet())
+		{
+			SavedValue = ServerStreaming->GetInt();
+		}
+		MatchPackage = Package;
+		ServerStreaming->Set(bEnabled ? 1 : 0, ECVF_SetByCode); // read when the destination world initializes, no effect on maps without World Partition
+		if (!WorldInitHandle.IsValid())
+		{
+			WorldInitHandle = FWorldDelegates::OnWorldInitializedActors.AddStatic(&OnWorldInitializedActors);
+		}
+		if (!TravelFailureHandle.IsValid() && GEngine)
+		{
+			TravelFailureHandle = GEngine->OnTravelFailure().AddStatic(&OnTravelFailure);
+		}
+	}
+}
+
+AGM_Lobby::AGM_Lobby()
+{
+	GameplayMap = TSoftObjectPtr<UWorld>(FSoftObjectPath(TEXT("/Game/Maps/BlasterMap.BlasterMap")));
+	bServerStreaming = true;
+}
 
 void AGM_Lobby::PostLogin(APlayerController* NewPlayer)
 {
@@ -16,7 +91,11 @@ void AGM_Lobby::PostLogin(APlayerController* NewPlayer)
 		if (World)
 		{
 			bUseSeamlessTravel = true;
-			World->ServerTravel(FString("/Game/Maps/BlasterMap?listen"));
+			LobbyServerStreaming::Set(bServerStreaming, GameplayMap.GetLongPackageName());
+			if (!World->ServerTravel(GameplayMap.GetLongPackageName() + TEXT("?listen")))
+			{
+				LobbyServerStreaming::Restore();
+			}
 		}
 	}
 }
@@ -16,5 +16,16 @@ class MPSHOOTER_API AGM_Lobby : public AGameMode
 
 public:
 
+	AGM_Lobby();
 	virtual void PostLogin(APlayerController* NewPlayer) override;	
+
+private:
+
+	// Where the lobby travels to. Point it at the World Partition version of the map once it's converted (Scripts/ConvertGameplayMap.sh).
+	UPROPERTY(EditDefaultsOnly, Category = Travel)
+	TSoftObjectPtr<UWorld> GameplayMap;
+
+	// Server loads cells around every character instead of the whole map (wp.Runtime.EnableServerStreaming, for the gameplay map only)
+	UPROPERTY(EditDefaultsOnly, Category = Travel)
+	bool bServerStreaming;
 };
@@ -4,6 +4,7 @@
 #include "OverheadWidget.h"
 
 #include "Components/TextBlock.h"
+#include "Instrumentation/MPShooterMemory.h"
 
 
 void UOverheadWidget::NativeDestruct()
@@ -12,8 +13,9 @@ void UOverheadWidget::NativeDestruct()
 	Super::NativeDestruct();
 }
 
-void UOverheadWidget::SetDisplayText(FString TextToDisplay)
+void UOverheadWidget::SetDisplayText(const FString& TextToDisplay)
 {
+	LLM_SCOPE_BYTAG(MPShooter_HUD);
 	if (DisplayText)
 	{
 		DisplayText->SetText(FText::FromString(TextToDisplay));
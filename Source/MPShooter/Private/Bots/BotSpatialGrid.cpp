@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Bots/BotSpatialGrid.h"
+#include "Algo/Sort.h"
+
+void FBotSpatialGrid::Reset(float InCellSize)
+{
+	Entries.Reset();
+	InvCellSize = 1.f / FMath::Max(InCellSize, 1.f);
+}
+
+void FBotSpatialGrid::Add(int32 Id, const FVector& Location)
+{
+	Entries.Add({ MakeKey(GetCell(Location)), Id, Location });
+}
+
+void FBotSpatialGrid::Build()
+{
+	Algo::SortBy(Entries, &FEntry::Key);
+}
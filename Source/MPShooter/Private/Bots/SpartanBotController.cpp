@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Bots/SpartanBotController.h"
+
+ASpartanBotController::ASpartanBotController()
+{
+	bWantsPlayerState = true;
+	bSetControlRotationFromPawnOrientation = false; // the bot subsystem aims through SetControlRotation, like mouse look
+	bStartAILogicOnPossess = false;
+	PrimaryActorTick.bCanEverTick = false; // AAIController's tick would only update focus, which we don't use
+}
@@ -0,0 +1,549 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Bots/SpartanBotSubsystem.h"
+#include "Bots/SpartanBotController.h"
+#include "Character/SpartanCharacter.h"
+#include "SpartanComponents/CombatComponent.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "MPShooterGameModeBase.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Misc/CommandLine.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bots"), STAT_MPShooter_Bots, STATGROUP_MPShooter);
+DECLARE_CYCLE_STAT(TEXT("Bot Think"), STAT_MPShooter_BotThink, STATGROUP_MPShooter);
+DECLARE_CYCLE_STAT(TEXT("Bot Visibility"), STAT_MPShooter_BotVisibility, STATGROUP_MPShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bot Thinks"), STAT_MPShooter_BotThinks, STATGROUP_MPShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bot Thinks Overdue"), STAT_MPShooter_BotThinksOverdue, STATGROUP_MPShooter);
+
+static TAutoConsoleVariable<float> CVarBotThinkBudgetMs(
+	TEXT("MPShooter.Bots.ThinkBudgetMs"),
+	0.5f,
+	TEXT("Game thread time per frame for all bots' decisions together. Bots that don't fit wait for the next frame, in turn."));
+
+static TAutoConsoleVariable<float> CVarBotThinkInterval(
+	TEXT("MPShooter.Bots.ThinkInterval"),
+	0.3f,
+	TEXT("Seconds between one bot's decisions (target, pickup, path); aiming, moving and firing still happen every frame."));
+
+static TAutoConsoleVariable<float> CVarBotSightRadius(
+	TEXT("MPShooter.Bots.SightRadius"),
+	8000.f,
+	TEXT("How far (cm) bots look for targets."));
+
+static TAutoConsoleVariable<float> CVarBotFireInterval(
+	TEXT("MPShooter.Bots.FireInterval"),
+	0.15f,
+	TEXT("Average seconds between a bot's trigger presses while it has a target in its sights."));
+
+static TAutoConsoleVariable<float> CVarBotAimError(
+	TEXT("MPShooter.Bots.AimError"),
+	2.f,
+	TEXT("Largest aim offset (degrees, pitch and yaw) a bot picks at each decision."));
+
+static TAutoConsoleVariable<float> CVarBotReportInterval(
+	TEXT("MPShooter.Bots.ReportInterval"),
+	0.f,
+	TEXT("Seconds between rows appended to Profiling/MPShooter/Bots.csv, 0 for only on MPShooter.Bots.Report."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdAddBots(
+	TEXT("MPShooter.Bots.Add"),
+	TEXT("Server: adds N bots (default 1)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USpartanBotSubsystem* BotSubsystem = World ? World->GetSubsystem<USpartanBotSubsystem>() : nullptr)
+		{
+			BotSubsystem->AddBots(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdRemoveBots(
+	TEXT("MPShooter.Bots.Remove"),
+	TEXT("Server: removes N bots (default all)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USpartanBotSubsystem* BotSubsystem = World ? World->GetSubsystem<USpartanBotSubsystem>() : nullptr)
+		{
+			BotSubsystem->RemoveBots(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : BotSubsystem->NumBots());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdBotReport(
+	TEXT("MPShooter.Bots.Report"),
+	TEXT("Server: prints the bots' average / max cost per frame since the last report and appends it to Profiling/MPShooter/Bots.csv. Optional label."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USpartanBotSubsystem* BotSubsystem = World ? World->GetSubsystem<USpartanBotSubsystem>() : nullptr)
+		{
+			BotSubsystem->WriteReport(Args.Num() > 0 ? Args[0] : TEXT(""));
+		}
+	}));
+
+namespace SpartanBots
+{
+	static constexpr float GridCellSize = 2000.f;
+	static constexpr double PickupGridInterval = 1.0; // weapons only move when picked up or dropped
+	static constexpr float PickupSearchRadius = 20000.f;
+	static constexpr float EngageRadius = 2500.f; // in sight and this close: strafe around instead of closing in
+	static constexpr float StrafeRadius = 600.f;
+	static constexpr float RoamRadius = 5000.f;
+	static constexpr float RepathDistance = 300.f; // the target moved this far from the end of our path
+	static constexpr float PathAcceptRadius = 80.f;
+	static constexpr float TurnRate = 540.f; // degrees / s
+	static constexpr float FireConeDegrees = 6.f;
+	static constexpr float TargetHeight = 40.f; // chest, above the capsule center
+}
+
+bool USpartanBotSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_Client; // bots only exist on the server
+}
+
+TStatId USpartanBotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USpartanBotSubsystem, STATGROUP_Tickables);
+}
+
+void USpartanBotSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LastReportTime = FPlatformTime::Seconds();
+	int32 CommandLineBots = 0;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-Bots="), CommandLineBots) && CommandLineBots > 0 && InWorld.GetAuthGameMode<AMPShooterGameModeBase>())
+	{
+		AddBots(CommandLineBots); // the gameplay map only, not the lobby
+	}
+}
+
+void USpartanBotSubsystem::Deinitialize()
+{
+	Bots.Reset(); // the controllers go with the world
+	Super::Deinitialize();
+}
+
+void USpartanBotSubsystem::AddBots(int32 Count)
+{
+	UWorld* World = GetWorld();
+	AMPShooterGameModeBase* GameMode = World ? World->GetAuthGameMode<AMPShooterGameModeBase>() : nullptr;
+	if (GameMode == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MPShooter.Bots: bots need the server's gameplay game mode"));
+		return;
+	}
+
+	const double Now = World->GetTimeSeconds();
+	const float ThinkInterval = CVarBotThinkInterval.GetValueOnGameThread();
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		ASpartanBotController* Controller = World->SpawnActor<ASpartanBotController>(SpawnParams);
+		if (Controller == nullptr) continue;
+		if (Controller->PlayerState)
+		{
+			Controller->PlayerState->SetPlayerName(FString::Printf(TEXT("Bot %02d"), Bots.Num() + 1));
+		}
+		GameMode->RestartPlayer(Controller); // player start and pawn class like any player
+
+		FBot& Bot = Bots.AddDefaulted_GetRef();
+		Bot.Controller = Controller;
+		Bot.NextThinkTime = Now + ThinkInterval * Index / Count; // first decisions spread over one interval
+	}
+	UE_LOG(LogTemp, Display, TEXT("MPShooter.Bots: %d bots"), Bots.Num());
+}
+
+void USpartanBotSubsystem::RemoveBots(int32 Count)
+{
+	for (int32 Removed = 0; Removed < Count && Bots.Num() > 0; ++Removed)
+	{
+		ASpartanBotController* Controller = Bots.Pop(EAllowShrinking::No).Controller.Get();
+		if (Controller == nullptr) continue;
+
+		if (ASpartanCharacter* Character = Cast<ASpartanCharacter>(Controller->GetPawn()))
+		{
+			if (Character->GetCombat())
+			{
+				Character->GetCombat()->DropAllWeapons();
+			}
+			Controller->UnPossess();
+			Character->Destroy();
+		}
+		Controller->Destroy(); // and its PlayerState; a pending respawn finds no controller and does nothing
+	}
+	NextThinkBot = 0;
+	UE_LOG(LogTemp, Display, TEXT("MPShooter.Bots: %d bots"), Bots.Num());
+}
+
+void USpartanBotSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (Bots.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_Bots);
+	const double StartTime = FPlatformTime::Seconds();
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	Bots.RemoveAll([](const FBot& Bot) { return !Bot.Controller.IsValid(); });
+	if (Bots.Num() == 0) return;
+	NextThinkBot %= Bots.Num();
+
+	BuildGrids(Now);
+
+	// 1. Decisions for the bots that are due, round robin from where the last frame ran out of budget.
+	VisibilityTraces.Reset();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MPShooter_BotThink);
+		const double Deadline = StartTime + CVarBotThinkBudgetMs.GetValueOnGameThread() / 1000.0;
+		int32 ThinksThisFrame = 0;
+		int32 Visited = 0;
+		for (; Visited < Bots.Num(); ++Visited)
+		{
+			const int32 BotIndex = (NextThinkBot + Visited) % Bots.Num();
+			FBot& Bot = Bots[BotIndex];
+			if (Bot.NextThinkTime > Now) continue;
+
+			ASpartanCharacter* Character = Cast<ASpartanCharacter>(Bot.Controller->GetPawn());
+			if (Character == nullptr || Character->IsEliminated()) continue; // thinks as soon as it's back
+			if (ThinksThisFrame > 0 && FPlatformTime::Seconds() >= Deadline) break; // always at least one, so nobody starves
+
+			Think(BotIndex, Character, Now);
+			++ThinksThisFrame;
+		}
+		const int32 FirstSkipped = Visited;
+		int32 OverdueThisFrame = 0;
+		for (; Visited < Bots.Num(); ++Visited)
+		{
+			OverdueThisFrame += Bots[(NextThinkBot + Visited) % Bots.Num()].NextThinkTime <= Now ? 1 : 0;
+		}
+		NextThinkBot = (NextThinkBot + FirstSkipped) % Bots.Num();
+		Thinks += ThinksThisFrame;
+		OverdueThinks += OverdueThisFrame;
+		INC_DWORD_STAT_BY(STAT_MPShooter_BotThinks, ThinksThisFrame);
+		INC_DWORD_STAT_BY(STAT_MPShooter_BotThinksOverdue, OverdueThisFrame);
+	}
+
+	// 2. Line of sight for this frame's decisions, as one batch.
+	RunVisibilityTraces();
+
+	// 3. Input for every bot, every frame.
+	for (FBot& Bot : Bots)
+	{
+		if (ASpartanCharacter* Character = Cast<ASpartanCharacter>(Bot.Controller->GetPawn()))
+		{
+			Act(Bot, Character, DeltaTime, Now);
+		}
+	}
+
+	const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	FrameMsSum += FrameMs;
+	FrameMsMax = FMath::Max(FrameMsMax, FrameMs);
+	++FramesMeasured;
+
+	const float ReportInterval = CVarBotReportInterval.GetValueOnGameThread();
+	if (ReportInterval > 0.f && FPlatformTime::Seconds() - LastReportTime >= ReportInterval)
+	{
+		WriteReport(TEXT("interval"));
+	}
+}
+
+void USpartanBotSubsystem::BuildGrids(double Now)
+{
+	using namespace SpartanBots;
+	UWorld* World = GetWorld();
+
+	CharacterGrid.Reset(GridCellSize);
+	GridCharacters.Reset();
+	for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+	{
+		if (It->IsEliminated() || It->IsHidden()) continue; // dead or in the pawn pool
+		CharacterGrid.Add(GridCharacters.Num(), It->GetActorLocation());
+		GridCharacters.Add(*It);
+	}
+	CharacterGrid.Build();
+
+	if (Now >= NextPickupGridTime)
+	{
+		NextPickupGridTime = Now + PickupGridInterval;
+		PickupGrid.Reset(GridCellSize);
+		GridPickups.Reset();
+		for (TActorIterator<AWeapon> It(World); It; ++It)
+		{
+			if (!It->CanBePickedUp()) continue;
+			PickupGrid.Add(GridPickups.Num(), It->GetActorLocation());
+			GridPickups.Add(*It);
+		}
+		PickupGrid.Build();
+	}
+}
+
+void USpartanBotSubsystem::Think(int32 BotIndex, ASpartanCharacter* Character, double Now)
+{
+	using namespace SpartanBots;
+	FBot& Bot = Bots[BotIndex];
+	Bot.NextThinkTime = Now + CVarBotThinkInterval.GetValueOnGameThread() * FMath::FRandRange(0.8f, 1.2f); // don't all come due together again
+	const float AimError = CVarBotAimError.GetValueOnGameThread();
+	Bot.AimNoise = FRotator(FMath::FRandRange(-AimError, AimError), FMath::FRandRange(-AimError, AimError), 0.f);
+
+	const FVector Location = Character->GetActorLocation();
+	const bool bPathDone = Bot.PathIndex >= Bot.Path.Num();
+	FVector Destination;
+
+	// Unarmed: nearest weapon lying around
+	if (!Character->IsWeaponEquipped())
+	{
+		Bot.Target = nullptr;
+		Bot.bTargetVisible = false;
+		AWeapon* Pickup = Bot.Pickup.Get();
+		if (Pickup == nullptr || !Pickup->CanBePickedUp())
+		{
+			Pickup = nullptr;
+			float BestDistSquared = TNumericLimits<float>::Max();
+			PickupGrid.Query(Location, PickupSearchRadius, [this, &Pickup, &BestDistSquared](int32 Id, const FVector&, float DistSquared)
+			{
+				AWeapon* Weapon = GridPickups[Id].Get();
+				if (Weapon && Weapon->CanBePickedUp() && DistSquared < BestDistSquared)
+				{
+					BestDistSquared = DistSquared;
+					Pickup = Weapon;
+				}
+			});
+			Bot.Pickup = Pickup;
+			if (Pickup)
+			{
+				FindPath(Bot, Character, Pickup->GetActorLocation());
+			}
+		}
+		if (Pickup == nullptr && bPathDone && FindRoamDestination(Character, RoamRadius, Destination))
+		{
+			FindPath(Bot, Character, Destination);
+		}
+		return;
+	}
+	Bot.Pickup = nullptr;
+
+	// Armed: keep a target we can still see, otherwise the nearest living one
+	const float SightRadius = CVarBotSightRadius.GetValueOnGameThread();
+	ASpartanCharacter* Target = Bot.Target.Get();
+	if (Target == nullptr || Target->IsEliminated() || !Bot.bTargetVisible || FVector::DistSquared2D(Location, Target->GetActorLocation()) > FMath::Square(SightRadius))
+	{
+		Target = nullptr;
+		float BestDistSquared = TNumericLimits<float>::Max();
+		CharacterGrid.Query(Location, SightRadius, [this, Character, &Target, &BestDistSquared](int32 Id, const FVector&, float DistSquared)
+		{
+			ASpartanCharacter* Other = GridCharacters[Id].Get();
+			if (Other && Other != Character && DistSquared < BestDistSquared)
+			{
+				BestDistSquared = DistSquared;
+				Target = Other;
+			}
+		});
+	}
+	if (Target != Bot.Target.Get())
+	{
+		Bot.bTargetVisible = false; // until this think's trace says otherwise
+		Bot.LastSeenTargetLocation = Target ? Target->GetActorLocation() : FVector::ZeroVector;
+	}
+	Bot.Target = Target;
+
+	if (Target)
+	{
+		FVisibilityTrace& Trace = VisibilityTraces.AddDefaulted_GetRef();
+		Trace.BotIndex = BotIndex;
+		Trace.Start = Character->GetPawnViewLocation();
+		Trace.End = Target->GetActorLocation() + FVector(0.f, 0.f, TargetHeight);
+		Trace.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(BotVisibility), false, Character);
+		Trace.QueryParams.AddIgnoredActor(Target);
+		Trace.QueryParams.AddIgnoredActor(Character->GetEquippedWeapon());
+	}
+
+	// Where to go, from what the last think saw: strafe when close and in sight, otherwise head for the target (bots hear
+	// everyone inside their sight radius), and with nobody around wander the navmesh.
+	if (Target && Bot.bTargetVisible && FVector::DistSquared(Location, Target->GetActorLocation()) < FMath::Square(EngageRadius))
+	{
+		if (bPathDone && FindRoamDestination(Character, StrafeRadius, Destination))
+		{
+			FindPath(Bot, Character, Destination);
+		}
+	}
+	else if (Target)
+	{
+		Destination = Bot.bTargetVisible ? Target->GetActorLocation() : Bot.LastSeenTargetLocation;
+		if (Bot.Path.Num() == 0 || FVector::DistSquared(Bot.Path.Last(), Destination) > FMath::Square(RepathDistance))
+		{
+			FindPath(Bot, Character, Destination);
+		}
+	}
+	else if (bPathDone && FindRoamDestination(Character, RoamRadius, Destination))
+	{
+		FindPath(Bot, Character, Destination);
+	}
+}
+
+void USpartanBotSubsystem::RunVisibilityTraces()
+{
+	if (VisibilityTraces.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_BotVisibility);
+	UWorld* World = GetWorld();
+	ParallelFor(VisibilityTraces.Num(), [this, World](int32 Index)
+	{
+		FVisibilityTrace& Trace = VisibilityTraces[Index];
+		Trace.bVisible = !World->LineTraceTestByChannel(Trace.Start, Trace.End, ECollisionChannel::ECC_Visibility, Trace.QueryParams);
+	});
+
+	for (const FVisibilityTrace& Trace : VisibilityTraces)
+	{
+		FBot& Bot = Bots[Trace.BotIndex];
+		Bot.bTargetVisible = Trace.bVisible;
+		if (Trace.bVisible && Bot.Target.IsValid())
+		{
+			Bot.LastSeenTargetLocation = Bot.Target->GetActorLocation();
+		}
+	}
+}
+
+void USpartanBotSubsystem::Act(FBot& Bot, ASpartanCharacter* Character, float DeltaTime, double Now)
+{
+	using namespace SpartanBots;
+	AController* Controller = Bot.Controller.Get();
+
+	if (Bot.bFireHeld) // a tap: released the frame after the press
+	{
+		Character->FireButtonReleased();
+		Bot.bFireHeld = false;
+	}
+	if (Character->IsEliminated()) return;
+
+	const FVector Location = Character->GetActorLocation();
+	ASpartanCharacter* Target = Bot.bTargetVisible ? Bot.Target.Get() : nullptr;
+	if (Target && Target->IsEliminated())
+	{
+		Target = nullptr;
+	}
+
+	while (Bot.PathIndex < Bot.Path.Num() && FVector::DistSquared2D(Location, Bot.Path[Bot.PathIndex]) < FMath::Square(PathAcceptRadius))
+	{
+		++Bot.PathIndex;
+	}
+	const FVector MoveDirection = Bot.PathIndex < Bot.Path.Num() ? (Bot.Path[Bot.PathIndex] - Location).GetSafeNormal2D() : FVector::ZeroVector;
+
+	// Look: at the target while it's in sight, else where we're going. A bot's mouse is SetControlRotation at a capped turn rate.
+	const FRotator ControlRotation = Controller->GetControlRotation();
+	FRotator DesiredAim = ControlRotation;
+	if (Target)
+	{
+		DesiredAim = (Target->GetActorLocation() + FVector(0.f, 0.f, TargetHeight) - Character->GetPawnViewLocation()).Rotation() + Bot.AimNoise;
+	}
+	else if (!MoveDirection.IsNearlyZero())
+	{
+		DesiredAim = FRotator(0.f, MoveDirection.Rotation().Yaw, 0.f);
+	}
+	const FRotator Aim = FMath::RInterpConstantTo(ControlRotation, DesiredAim, DeltaTime, TurnRate);
+	Controller->SetControlRotation(Aim);
+
+	// Move: the move action's value, X right and Y forward relative to where we look
+	if (!MoveDirection.IsNearlyZero())
+	{
+		const FRotationMatrix YawMatrix(FRotator(0.f, Aim.Yaw, 0.f));
+		Character->Move(FInputActionValue(FVector2D(FVector::DotProduct(MoveDirection, YawMatrix.GetUnitAxis(EAxis::Y)), FVector::DotProduct(MoveDirection, YawMatrix.GetUnitAxis(EAxis::X)))));
+	}
+
+	if (!Character->IsWeaponEquipped())
+	{
+		if (Character->OverlappingWeapon)
+		{
+			Character->EquipButtonPressed();
+		}
+		return;
+	}
+
+	// Aim down sights while there's someone to shoot
+	if (Character->bIsAiming() != (Target != nullptr))
+	{
+		Character->AimButtonPressed();
+	}
+
+	if (Target && Now >= Bot.NextShotTime)
+	{
+		const float AimErrorDegrees = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(Aim.Vector(), DesiredAim.Vector()), -1.f, 1.f)));
+		if (AimErrorDegrees <= FireConeDegrees)
+		{
+			Character->FireButtonPressed();
+			Bot.bFireHeld = true;
+			Bot.NextShotTime = Now + CVarBotFireInterval.GetValueOnGameThread() * FMath::FRandRange(0.7f, 1.3f);
+		}
+	}
+}
+
+void USpartanBotSubsystem::FindPath(FBot& Bot, ASpartanCharacter* Character, const FVector& Destination)
+{
+	Bot.Path.Reset();
+	Bot.PathIndex = 0;
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetNavDataForProps(Character->GetNavAgentPropertiesRef(), Character->GetNavAgentLocation()) : nullptr;
+	if (NavData)
+	{
+		// Synchronous, but only from a think, so it's inside the think budget
+		FPathFindingQuery Query(Character, *NavData, Character->GetNavAgentLocation(), Destination);
+		const FPathFindingResult Result = NavSys->FindPathSync(Query);
+		if (Result.IsSuccessful() && Result.Path.IsValid())
+		{
+			for (const FNavPathPoint& Point : Result.Path->GetPathPoints())
+			{
+				Bot.Path.Add(Point.Location);
+			}
+			Bot.PathIndex = Bot.Path.Num() > 1 ? 1 : 0; // the first point is where we are
+			return;
+		}
+	}
+	Bot.Path.Add(Destination); // no navmesh: straight at it
+}
+
+bool USpartanBotSubsystem::FindRoamDestination(const ASpartanCharacter* Character, float Radius, FVector& OutDestination) const
+{
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation NavLocation;
+	if (NavSys && NavSys->GetRandomReachablePointInRadius(Character->GetNavAgentLocation(), Radius, NavLocation))
+	{
+		OutDestination = NavLocation.Location;
+		return true;
+	}
+	OutDestination = Character->GetActorLocation() + FMath::VRand().GetSafeNormal2D() * Radius;
+	return true;
+}
+
+void USpartanBotSubsystem::WriteReport(const FString& Label)
+{
+	LastReportTime = FPlatformTime::Seconds();
+	const int32 Frames = FMath::Max(FramesMeasured, 1);
+	const double AvgMs = FrameMsSum / Frames;
+	const double ThinksPerFrame = double(Thinks) / Frames;
+	const float BudgetMs = CVarBotThinkBudgetMs.GetValueOnGameThread();
+	const float ThinkInterval = CVarBotThinkInterval.GetValueOnGameThread();
+
+	UE_LOG(LogTemp, Display, TEXT("Bots [%s] %d bots over %d frames: %.3f ms avg, %.3f ms max per frame, %.2f decisions per frame, %d overdue (budget %.2f ms, interval %.2f s)"),
+		*Label, Bots.Num(), FramesMeasured, AvgMs, FrameMsMax, ThinksPerFrame, OverdueThinks, BudgetMs, ThinkInterval);
+
+	FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("Bots.csv")), TEXT("Time,Label,Bots,Frames,AvgMs,MaxMs,ThinksPerFrame,Overdue,ThinkBudgetMs,ThinkInterval"),
+		FString::Printf(TEXT("%s,%s,%d,%d,%.4f,%.4f,%.3f,%d,%.2f,%.2f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Label,
+		Bots.Num(), FramesMeasured, AvgMs, FrameMsMax, ThinksPerFrame, OverdueThinks, BudgetMs, ThinkInterval));
+
+	FrameMsSum = 0.0;
+	FrameMsMax = 0.0;
+	FramesMeasured = 0;
+	Thinks = 0;
+	OverdueThinks = 0;
+}
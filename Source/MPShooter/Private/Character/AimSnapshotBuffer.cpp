@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/AimSnapshotBuffer.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarAimSnapshotMinDelay(
+	TEXT("MPShooter.AimSnapshots.MinDelay"),
+	0.03f,
+	TEXT("Shortest playout delay (seconds) for simulated proxy aim."));
+
+static TAutoConsoleVariable<float> CVarAimSnapshotMaxDelay(
+	TEXT("MPShooter.AimSnapshots.MaxDelay"),
+	0.25f,
+	TEXT("Longest playout delay (seconds) for simulated proxy aim."));
+
+static TAutoConsoleVariable<float> CVarAimSnapshotMaxExtrapolation(
+	TEXT("MPShooter.AimSnapshots.MaxExtrapolation"),
+	0.1f,
+	TEXT("How far (seconds) past the newest snapshot simulated proxy aim keeps its last rate of turn before holding still."));
+
+void FAimSnapshotBuffer::Add(double RemoteTime, double LocalTime, float Yaw, float Pitch)
+{
+	if (Num > 0)
+	{
+		FSnapshot& Newest = Snapshots[(Head + Num - 1) % Capacity];
+		if (RemoteTime < Newest.RemoteTime - 1.0) // the owner's timestamps started over
+		{
+			Reset();
+		}
+		else if (RemoteTime <= Newest.RemoteTime) // no move since the last one, only the pitch changed
+		{
+			Newest.Pitch = Pitch;
+			return;
+		}
+	}
+
+	UpdateDelay(RemoteTime, LocalTime);
+
+	if (Num == Capacity)
+	{
+		Head = (Head + 1) % Capacity;
+		Num--;
+	}
+	Snapshots[(Head + Num) % Capacity] = { RemoteTime, Yaw, Pitch };
+	Num++;
+}
+
+void FAimSnapshotBuffer::UpdateDelay(double RemoteTime, double LocalTime)
+{
+	const double Offset = LocalTime - RemoteTime;
+	if (Num == 0)
+	{
+		ClockOffset = Offset;
+		LastLocalArrival = LocalTime;
+		Delay = CVarAimSnapshotMinDelay.GetValueOnGameThread();
+		return;
+	}
+
+	// The fastest snapshot sets the offset; anything slower only pulls it up a little at a time.
+	ClockOffset = Offset < ClockOffset ? Offset : ClockOffset + (Offset - ClockOffset) * 0.02;
+
+	const FSnapshot& Newest = Get(Num - 1);
+	const float RemoteInterval = float(RemoteTime - Newest.RemoteTime);
+	const float ArrivalInterval = float(LocalTime - LastLocalArrival);
+	LastLocalArrival = LocalTime;
+	IntervalMean = IntervalMean == 0.f ? RemoteInterval : FMath::Lerp(IntervalMean, RemoteInterval, 0.1f);
+	Jitter = FMath::Lerp(Jitter, FMath::Abs(ArrivalInterval - RemoteInterval), 0.1f);
+
+	// One interval behind the newest snapshot so there's usually a pair to interpolate between, plus room for late ones.
+	Delay = FMath::Clamp(IntervalMean + 2.f * Jitter, CVarAimSnapshotMinDelay.GetValueOnGameThread(), CVarAimSnapshotMaxDelay.GetValueOnGameThread());
+}
+
+bool FAimSnapshotBuffer::Sample(double LocalTime, float& OutYaw, float& OutPitch) const
+{
+	LastExtrapolation = 0.f;
+	if (Num == 0) return false;
+
+	const double RenderTime = LocalTime - ClockOffset - Delay;
+	const FSnapshot& Oldest = Get(0);
+	if (Num == 1 || RenderTime <= Oldest.RemoteTime)
+	{
+		OutYaw = Oldest.Yaw;
+		OutPitch = Oldest.Pitch;
+		if (Num == 1) return true;
+	}
+
+	const FSnapshot& Newest = Get(Num - 1);
+	if (RenderTime >= Newest.RemoteTime) // starved: keep turning at the last rate for a bit, then hold
+	{
+		const FSnapshot& Previous = Get(Num - 2);
+		const float Extrapolation = FMath::Min(float(RenderTime - Newest.RemoteTime), CVarAimSnapshotMaxExtrapolation.GetValueOnGameThread());
+		const float Interval = float(Newest.RemoteTime - Previous.RemoteTime);
+		const float Alpha = Interval > KINDA_SMALL_NUMBER ? Extrapolation / Interval : 0.f;
+		OutYaw = FRotator::NormalizeAxis(Newest.Yaw + FRotator::NormalizeAxis(Newest.Yaw - Previous.Yaw) * Alpha);
+		OutPitch = FMath::Clamp(Newest.Pitch + (Newest.Pitch - Previous.Pitch) * Alpha, -90.f, 90.f);
+		LastExtrapolation = float(RenderTime - Newest.RemoteTime);
+		return true;
+	}
+	if (RenderTime <= Oldest.RemoteTime) return true;
+
+	for (int32 Index = Num - 1; Index > 0; --Index)
+	{
+		const FSnapshot& From = Get(Index - 1);
+		if (From.RemoteTime <= RenderTime)
+		{
+			const FSnapshot& To = Get(Index);
+			const float Alpha = float((RenderTime - From.RemoteTime) / (To.RemoteTime - From.RemoteTime));
+			OutYaw = FRotator::NormalizeAxis(From.Yaw + FRotator::NormalizeAxis(To.Yaw - From.Yaw) * Alpha);
+			OutPitch = FMath::Lerp(From.Pitch, To.Pitch, Alpha);
+			break;
+		}
+	}
+	return true;
+}
+
+void FAimSnapshotBuffer::Reset()
+{
+	Head = 0;
+	Num = 0;
+	IntervalMean = 0.f;
+	Jitter = 0.f;
+	Delay = 0.f;
+	LastExtrapolation = 0.f;
+}
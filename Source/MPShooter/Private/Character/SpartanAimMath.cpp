@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/SpartanAimMath.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/KismetMathLibrary.h"
+
+namespace SpartanAimMathBench
+{
+	// The character / anim instance code as it was before FSpartanAimMath, kept to time against. Correctness is checked by the
+	// golden cases in the MPShooter.AimMath automation tests, not here.
+	struct FReferenceAim
+	{
+		float AO_Yaw = 0.f;
+		float Interp_AO_Yaw = 0.f;
+		float AO_Pitch = 0.f;
+		FRotator StartingAimRotation = FRotator::ZeroRotator;
+		ETurningInPlace TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+
+		void TurnInPlace(float DeltaTime, const FRotator& BaseAimRotation)
+		{
+			if (AO_Yaw > 70.f)
+			{
+				TurningInPlace = ETurningInPlace::ETIP_Right;
+			}
+			else if (AO_Yaw < -90.f)
+			{
+				TurningInPlace = ETurningInPlace::ETIP_Left;
+			}
+			if (TurningInPlace != ETurningInPlace::ETIP_NotTurning)
+			{
+				Interp_AO_Yaw = FMath::FInterpTo(Interp_AO_Yaw, 0.f, DeltaTime, 4.f);
+				AO_Yaw = Interp_AO_Yaw;
+				if (FMath::Abs(AO_Yaw) < 15.f)
+				{
+					TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+					StartingAimRotation = FRotator(0.f, BaseAimRotation.Yaw, 0.f);
+				}
+			}
+		}
+
+		void AimOffset(const FSpartanAimInput& Input)
+		{
+			const FRotator BaseAimRotation(Input.AimPitch, Input.AimYaw, 0.f);
+			FVector Velocity = Input.Velocity;
+			Velocity.Z = 0.f;
+			const float Speed = Velocity.Size();
+
+			if (Speed == 0.f && !Input.bIsInAir)
+			{
+				const FRotator CurrentAimRotation = FRotator(0.f, BaseAimRotation.Yaw, 0.f);
+				const FRotator DeltaAimRotation = UKismetMathLibrary::NormalizedDeltaRotator(CurrentAimRotation, StartingAimRotation);
+				AO_Yaw = DeltaAimRotation.Yaw;
+				if (TurningInPlace == ETurningInPlace::ETIP_NotTurning)
+				{
+					Interp_AO_Yaw = AO_Yaw;
+				}
+				TurnInPlace(Input.DeltaTime, BaseAimRotation);
+			}
+			if (Speed > 0.f || Input.bIsInAir)
+			{
+				StartingAimRotation = FRotator(0.f, BaseAimRotation.Yaw, 0.f);
+				AO_Yaw = 0.f;
+				TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+			}
+			AO_Pitch = BaseAimRotation.Pitch;
+			if (AO_Pitch > 90.f && Input.bRemotePitch)
+			{
+				AO_Pitch = FMath::GetMappedRangeValueClamped(FVector2D(270.f, 360.f), FVector2D(-90.f, 0.f), AO_Pitch);
+			}
+		}
+	};
+
+	struct FReferenceLocomotion
+	{
+		float Lean = 0.f;
+		FRotator DeltaRotation = FRotator::ZeroRotator;
+		float YawOffset = 0.f;
+		float CorrectiveRate = 1.f;
+
+		void UpdateLean(const FRotator& CharacterRotation, const FRotator& CharacterRotationLastFrame, float DeltaTime)
+		{
+			const FRotator Delta = UKismetMathLibrary::NormalizedDeltaRotator(CharacterRotation, CharacterRotationLastFrame);
+			const float Target = Delta.Yaw / DeltaTime;
+			const float Interp = FMath::FInterpTo(Lean, Target, DeltaTime, 6.f);
+			Lean = FMath::Clamp(Interp, -90.f, 90.f);
+		}
+
+		void CalculateYawOffset(const FRotator& AimRotation, const FVector& Velocity, float DeltaTime)
+		{
+			const FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(Velocity);
+			const FRotator DeltaRot = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation);
+			DeltaRotation = FMath::RInterpTo(DeltaRotation, DeltaRot, DeltaTime, 6.f);
+			YawOffset = DeltaRotation.Yaw;
+			CorrectiveRate = (FMath::Abs(YawOffset) > 45.f) ? FMath::Clamp(45.f / FMath::Abs(YawOffset), 0.5f, 1.0f) : 1.0f;
+		}
+	};
+
+	// One simulated frame of input. Standing still and in-air frames come in runs so turn in place actually triggers.
+	struct FFrame
+	{
+		FSpartanAimInput Aim;
+		float ActorYaw;
+	};
+
+	static void MakeFrames(TArray<FFrame>& OutFrames, int32 NumFrames)
+	{
+		FRandomStream Random(4242); // same inputs every run
+		OutFrames.SetNumUninitialized(NumFrames);
+		float AimYaw = 0.f;
+		float ActorYaw = 0.f;
+		int32 RunLeft = 0;
+		bool bStanding = true;
+		bool bInAir = false;
+		for (FFrame& Frame : OutFrames)
+		{
+			if (RunLeft-- <= 0)
+			{
+				RunLeft = Random.RandRange(5, 120);
+				bStanding = Random.FRand() < 0.5f;
+				bInAir = !bStanding && Random.FRand() < 0.2f;
+			}
+			AimYaw = FRotator::NormalizeAxis(AimYaw + Random.FRandRange(-8.f, 8.f));
+			ActorYaw = FRotator::NormalizeAxis(ActorYaw + Random.FRandRange(-4.f, 4.f));
+
+			FSpartanAimInput& Aim = Frame.Aim;
+			Aim.Velocity = bStanding ? FVector(0.f, 0.f, bInAir ? 300.f : 0.f) : FVector(Random.FRandRange(-600.f, 600.f), Random.FRandRange(-600.f, 600.f), bInAir ? Random.FRandRange(-400.f, 400.f) : 0.f);
+			Aim.bIsInAir = bInAir;
+			Aim.AimYaw = AimYaw;
+			Aim.bRemotePitch = Random.FRand() < 0.5f;
+			const float Pitch = Random.FRandRange(-89.f, 89.f);
+			Aim.AimPitch = (Aim.bRemotePitch && Pitch < 0.f) ? Pitch + 360.f : Pitch; // what a simulated proxy sees
+			Aim.DeltaTime = Random.FRandRange(1.f / 240.f, 1.f / 20.f);
+			Frame.ActorYaw = ActorYaw;
+		}
+	}
+
+}
+
+static FAutoConsoleCommand CmdBenchAimMath(
+	TEXT("MPShooter.BenchAimMath"),
+	TEXT("Benchmark: runs N frames (default 1000000) of deterministic random input through FSpartanAimMath and the old character/anim instance code, and prints the time for each."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace SpartanAimMathBench;
+		const int32 NumFrames = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000, 2);
+
+		TArray<FFrame> Frames;
+		MakeFrames(Frames, NumFrames);
+
+		float Checksum = 0.f; // both sides consume their results, so neither loop can be optimized away
+		double StartTime = FPlatformTime::Seconds();
+		{
+			FSpartanAimState Aim;
+			FSpartanLocomotionState Locomotion;
+			float Lean = 0.f;
+			float LastActorYaw = 0.f;
+			for (int32 Index = 0; Index < NumFrames; ++Index)
+			{
+				const FFrame& Frame = Frames[Index];
+				Aim = FSpartanAimMath::UpdateAimOffset(Aim, Frame.Aim);
+				Lean = FSpartanAimMath::UpdateLean(Lean, Frame.ActorYaw, LastActorYaw, Frame.Aim.DeltaTime);
+				FSpartanAimMath::UpdateYawOffset(Locomotion, FRotator(Frame.Aim.AimPitch, Frame.Aim.AimYaw, 0.f), Frame.Aim.Velocity, Frame.Aim.DeltaTime);
+				LastActorYaw = Frame.ActorYaw;
+				Checksum += Aim.AO_Yaw + Aim.AO_Pitch + Lean + Locomotion.YawOffset;
+			}
+		}
+		const double LibraryMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		double ReferenceMs = 0.0;
+		float ReferenceChecksum = 0.f;
+		{
+			FReferenceAim Aim;
+			FReferenceLocomotion Locomotion;
+			FRotator LastActorRotation = FRotator::ZeroRotator;
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Index = 0; Index < NumFrames; ++Index)
+			{
+				const FFrame& Frame = Frames[Index];
+				const FRotator ActorRotation(0.f, Frame.ActorYaw, 0.f);
+				Aim.AimOffset(Frame.Aim);
+				Locomotion.UpdateLean(ActorRotation, LastActorRotation, Frame.Aim.DeltaTime);
+				Locomotion.CalculateYawOffset(FRotator(Frame.Aim.AimPitch, Frame.Aim.AimYaw, 0.f), Frame.Aim.Velocity, Frame.Aim.DeltaTime);
+				LastActorRotation = ActorRotation;
+				ReferenceChecksum += Aim.AO_Yaw + Aim.AO_Pitch + Locomotion.Lean + Locomotion.YawOffset;
+			}
+			ReferenceMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Aim math, %d frames: library %.3f ms (%.1f ns/frame), reference %.3f ms (%.1f ns/frame) [checksums %.1f, %.1f]"),
+			NumFrames, LibraryMs, LibraryMs * 1.0e6 / NumFrames, ReferenceMs, ReferenceMs * 1.0e6 / NumFrames, Checksum, ReferenceChecksum);
+	}));
@@ -4,17 +4,21 @@
 #include "Character/SpartanAnimInstance.h"
 #include "Character/SpartanCharacter.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "MPShooter/Weapon/Weapon.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Instrumentation/MPShooterMemory.h"
 
 void USpartanAnimInstance::NativeInitializeAnimation()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Animation);
 	Super::NativeInitializeAnimation();
 	SpartanCharacter = Cast<ASpartanCharacter>(TryGetPawnOwner());
 }
 
 void USpartanAnimInstance::NativeUpdateAnimation(float DeltaTime)
 {
+	LLM_SCOPE_BYTAG(MPShooter_Animation);
+	MPSHOOTER_PERF_SCOPE(AnimUpdate);
 	Super::NativeUpdateAnimation(DeltaTime);
 	if (SpartanCharacter == nullptr)
 	{
@@ -27,6 +31,7 @@ void USpartanAnimInstance::NativeUpdateAnimation(float DeltaTime)
 		UpdateWeaponState();
 		UpdateCharacterLean(DeltaTime);
 		CalculateYawOffset(DeltaTime);
+		UpdateRecoil(DeltaTime);
 		UpdateIKState();
 
 		// Call Getters from SpartanCharacter to get Yaw and Pitch for use in ABP.
@@ -36,6 +41,26 @@ void USpartanAnimInstance::NativeUpdateAnimation(float DeltaTime)
 	}
 }
 
+void USpartanAnimInstance::ResetForRespawn()
+{
+	Lean = 0.f;
+	YawOffset = 0.f;
+	Locomotion = FSpartanLocomotionState();
+	CorrectiveRate = 1.f;
+	AO_Yaw = 0.f;
+	AO_Pitch = 0.f;
+	TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+	Recoil = FSpartanRecoilState();
+	RecoilPitch = 0.f;
+	RecoilYaw = 0.f;
+	RecoilAlpha = 0.f;
+	if (SpartanCharacter)
+	{
+		CharacterRotation = SpartanCharacter->GetActorRotation();
+		CharacterRotationLastFrame = CharacterRotation;
+	}
+}
+
 void USpartanAnimInstance::UpdateIKState()
 {
 
@@ -80,20 +105,39 @@ void USpartanAnimInstance::UpdateWeaponState()
 void USpartanAnimInstance::UpdateCharacterLean(float DeltaTime)
 {
 	CharacterRotationLastFrame = CharacterRotation;
-	CharacterRotation = SpartanCharacter->GetActorRotation();
-	const FRotator Delta = UKismetMathLibrary::NormalizedDeltaRotator(CharacterRotation, CharacterRotationLastFrame);
-	const float Target = Delta.Yaw / DeltaTime; // Scale Delta up (since its a small value), and tie it to DeltaTime.
-	const float Interp = FMath::FInterpTo(Lean, Target, DeltaTime, 6.f); // Interp to remove jankiness in lean motion (rapidly moving from one anim to another (left/right strafe)
-	Lean = FMath::Clamp(Interp, -90.f, 90.f);
+	CharacterRotation = SpartanCharacter->GetRenderActorRotation(); // simulated proxies: interpolated, the replicated rotation steps at the net rate
+	Lean = FSpartanAimMath::UpdateLean(Lean, CharacterRotation.Yaw, CharacterRotationLastFrame.Yaw, DeltaTime);
 }
 
 void USpartanAnimInstance::CalculateYawOffset(float DeltaTime)
 {
-	FRotator AimRotation = SpartanCharacter->GetBaseAimRotation();
-	FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(SpartanCharacter->GetVelocity());
-	FRotator DeltaRot = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation);
-	DeltaRotation = FMath::RInterpTo(DeltaRotation, DeltaRot, DeltaTime, 6.f);
-	YawOffset = DeltaRotation.Yaw;
-	CorrectiveRate = (FMath::Abs(YawOffset) > 45.f) ? FMath::Clamp(45.f / FMath::Abs(YawOffset), 0.5f, 1.0f) : 1.0f;
-	
+	FSpartanAimMath::UpdateYawOffset(Locomotion, SpartanCharacter->GetRenderAimRotation(), SpartanCharacter->GetVelocity(), DeltaTime);
+	YawOffset = Locomotion.YawOffset;
+	CorrectiveRate = Locomotion.CorrectiveRate;
+}
+
+void USpartanAnimInstance::AddRecoilImpulse(bool bAimingShot)
+{
+	const FVector2D& Kick = bAimingShot ? AimingRecoilKick : HipFireRecoilKick;
+	FSpartanAimMath::AddRecoilImpulse(Recoil, FVector2D(Kick.X, Kick.Y * FMath::FRandRange(-1.f, 1.f)), RecoilFrequency);
+}
+
+void USpartanAnimInstance::CancelRecoil()
+{
+	Recoil.Velocity = FVector2D::ZeroVector;
+}
+
+void USpartanAnimInstance::UpdateRecoil(float DeltaTime)
+{
+	if (Recoil.Offset.IsNearlyZero(KINDA_SMALL_NUMBER) && Recoil.Velocity.IsNearlyZero(KINDA_SMALL_NUMBER))
+	{
+		Recoil = FSpartanRecoilState(); // at rest, skip the exp and keep the ABP's inputs exactly zero
+	}
+	else
+	{
+		FSpartanAimMath::UpdateRecoil(Recoil, RecoilFrequency, MaxRecoilOffset, DeltaTime);
+	}
+	RecoilPitch = Recoil.Offset.X;
+	RecoilYaw = Recoil.Offset.Y;
+	RecoilAlpha = FMath::Clamp(FMath::Abs(RecoilPitch) / MaxRecoilOffset, 0.f, 1.f);
 }
@@ -9,19 +9,65 @@
 #include "Net/UnrealNetwork.h"
 #include "MPShooter/Weapon/Weapon.h"
 #include "SpartanComponents/CombatComponent.h"
+#include "SpartanComponents/SpartanMovementComponent.h"
 #include "Components/CapsuleComponent.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "Components/WorldPartitionStreamingSourceComponent.h"
+#include "WorldPartition/WorldPartition.h"
+#include "WorldPartition/WorldPartitionRuntimeSpatialHash.h"
 #include "Character/SpartanAnimInstance.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "Instrumentation/MatchJournal.h"
+#include "Instrumentation/AllocationTrackerSubsystem.h"
+#include "HUD/SpartanHUD.h"
+#include "GameState/MPShooterGameState.h"
+#include "Engine/DamageEvents.h"
+#include "GameFramework/PlayerState.h"
+#include "MPShooterGameModeBase.h"
+#include "Server/ServerTickGovernorSubsystem.h"
+#include "Networking/MPShooterIris.h"
 
 #include "Camera/CameraComponent.h"
-#include "Components/WidgetComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 
+static TAutoConsoleVariable<int32> CVarAimSnapshots(
+	TEXT("MPShooter.AimSnapshots"),
+	1,
+	TEXT("Simulated proxies render aim and rotation from the snapshot buffer (1) or straight from the latest replicated values (0)."));
 
-ASpartanCharacter::ASpartanCharacter()
+static TAutoConsoleVariable<int32> CVarProceduralRecoil(
+	TEXT("MPShooter.ProceduralRecoil"),
+	0,
+	TEXT("Shots kick the anim instance's additive recoil spring (1) or restart FireWeaponMontage every shot (0). Leave it at 0 until the anim blueprint reads RecoilPitch / RecoilYaw / RecoilAlpha, or shots show no recoil at all."));
+
+static TAutoConsoleVariable<float> CVarCharacterNetRate(
+	TEXT("MPShooter.CharacterNetRate"),
+	0.f,
+	TEXT("Server: overrides the characters' base NetUpdateFrequency for those spawned afterwards (0 = class default), before the server governor's scale. For comparing against the old 66 Hz."));
+
+// Largest loading range of the map's runtime streaming grids, 0 without World Partition or a spatial hash
+static float GetRuntimeGridLoadingRange(const UWorld* World)
+{
+	const UWorldPartition* WorldPartition = World ? World->GetWorldPartition() : nullptr;
+	const UWorldPartitionRuntimeSpatialHash* SpatialHash = WorldPartition ? Cast<UWorldPartitionRuntimeSpatialHash>(WorldPartition->RuntimeHash) : nullptr;
+	if (SpatialHash == nullptr) return 0.f;
+
+	float LoadingRange = 0.f;
+	for (const FSpatialHashStreamingGrid& Grid : SpatialHash->GetStreamingGrids())
+	{
+		LoadingRange = FMath::Max(LoadingRange, Grid.LoadingRange);
+	}
+	return LoadingRange;
+}
+
+
+ASpartanCharacter::ASpartanCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USpartanMovementComponent>(ACharacter::CharacterMovementComponentName)) // Aiming is part of the saved moves
 {
+	LLM_SCOPE_BYTAG(MPShooter_Characters);
 	PrimaryActorTick.bCanEverTick = true;
+	bReplicateUsingRegisteredSubObjectList = true; // required by Iris, no difference on the generic path
 
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(GetMesh());
@@ -31,9 +77,13 @@ ASpartanCharacter::ASpartanCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
 	FollowCamera->bUsePawnControlRotation = false;
 	GetCharacterMovement()->NavAgentProps.bCanCrouch = true;
-	TurningInPlace = ETurningInPlace::ETIP_NotTurning; //Set Default Value for ETIP
-	NetUpdateFrequency = 66.f; // Sets the net update per second for the class
-	MinNetUpdateFrequency = 33.f;  // sets the net update per second for less frequently updated things
+	GetCharacterMovement()->bNetworkAlwaysReplicateTransformUpdateTimestamp = true; // AimSnapshots are stamped with it; only Linear smoothing sends it otherwise
+	SetNetUpdateFrequency(20.f); // Sets the net update per second for the class. Simulated proxies smooth aim through AimSnapshots, movement through the CMC.
+	SetMinNetUpdateFrequency(10.f);  // sets the net update per second for less frequently updated things
+	RenderAimRotation = FRotator::ZeroRotator;
+	bRenderAimFromSnapshots = false;
+	bEliminated = false;
+	RespawnCount = 0;
 
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
@@ -42,17 +92,19 @@ ASpartanCharacter::ASpartanCharacter()
 	GetCharacterMovement()->bOrientRotationToMovement = true;
 	GetCharacterMovement()->RotationRate = FRotator(0.f, 0.f, 750.f); //Sets Rotation Rate of character when orient rotation to movement is true (rate at which the character spins around)
 
-	OverheadWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("OverheadWidget"));
-	OverheadWidget->SetupAttachment(RootComponent);
-
 	Combat = CreateDefaultSubobject<UCombatComponent>(TEXT("CombatComponent"));
 	Combat->SetIsReplicated(true);
+
+	StreamingSource = CreateDefaultSubobject<UWorldPartitionStreamingSourceComponent>(TEXT("StreamingSource"));
+	StreamingLoadingRange = 15000.f; // the engine's default net cull distance, so relevancy doesn't change on maps without World Partition
 }
 
 void ASpartanCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
+	DOREPLIFETIME(ASpartanCharacter, bEliminated);
+	DOREPLIFETIME(ASpartanCharacter, RespawnCount);
 	DOREPLIFETIME_CONDITION(ASpartanCharacter, OverlappingWeapon, COND_OwnerOnly); // (B) Requires Net/UnrealNetwork.h header.  Overlapping is Null until we set it, in the Weapon class on overlap, which means we need a public setter.
 																					// Owner only makes it replicate from server, only to client that owns the overlapping pawn.
 
@@ -60,8 +112,33 @@ void ASpartanCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 
 void ASpartanCharacter::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Characters);
 	Super::BeginPlay();
 
+	if (HasAuthority())
+	{
+		ApplyServerFidelity(UServerTickGovernorSubsystem::GetCurrentFidelity(GetWorld()));
+		MPShooterIris::ConfigureActor(this, MPShooterIris::EReplicatedClass::Character);
+	}
+
+	// Same range for what the server keeps loaded around us and who we replicate to: the runtime grid's, which clients also stream
+	// around their player controller with, or StreamingLoadingRange on maps without one
+	const float GridLoadingRange = GetRuntimeGridLoadingRange(GetWorld());
+	const float LoadingRange = GridLoadingRange > 0.f ? GridLoadingRange : StreamingLoadingRange;
+	NetCullDistanceSquared = FMath::Square(LoadingRange);
+	FStreamingSourceShape Shape;
+	Shape.bUseGridLoadingRange = GridLoadingRange > 0.f;
+	Shape.Radius = LoadingRange;
+	StreamingSource->Shapes = { Shape };
+	if (HasAuthority())
+	{
+		StreamingSource->EnableStreamingSource();
+	}
+	else
+	{
+		StreamingSource->DisableStreamingSource(); // the local player controller is the client's source
+	}
+
 	if (APlayerController* PlayerController = Cast<APlayerController>(GetController()))
 	{
 		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
@@ -74,8 +151,12 @@ void ASpartanCharacter::BeginPlay()
 
 void ASpartanCharacter::Tick(float DeltaTime)
 {
+	LLM_SCOPE_BYTAG(MPShooter_Characters);
+	MPSHOOTER_PERF_SCOPE(CharacterTick);
+	MPSHOOTER_UOBJECT_BUDGET_SCOPE(CharacterTick, 0); // steady state movement and aiming never construct UObjects
 	Super::Tick(DeltaTime);
 
+	UpdateRenderAim();
 	AimOffset(DeltaTime);
 	
 }
@@ -90,6 +171,7 @@ void ASpartanCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 		EnhancedInputComponent->BindAction(MouseLookAction, ETriggerEvent::Triggered, this, &ASpartanCharacter::MouseLook);
 		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &ASpartanCharacter::Jump);
 		EnhancedInputComponent->BindAction(EquipAction, ETriggerEvent::Triggered, this, &ASpartanCharacter::EquipButtonPressed);
+		EnhancedInputComponent->BindAction(SwapWeaponAction, ETriggerEvent::Started, this, &ASpartanCharacter::SwapWeaponButtonPressed);
 		EnhancedInputComponent->BindAction(CrouchAction, ETriggerEvent::Started, this, &ASpartanCharacter::CrouchButtonPressed);
 		EnhancedInputComponent->BindAction(AimAction, ETriggerEvent::Started, this, &ASpartanCharacter::AimButtonPressed);
 		EnhancedInputComponent->BindAction(FireAction, ETriggerEvent::Started, this, &ASpartanCharacter::FireButtonPressed);
@@ -104,6 +186,162 @@ void ASpartanCharacter::PostInitializeComponents()
 	{
 		Combat->Character = this;
 	}
+	MeshRelativeTransform = GetMesh()->GetRelativeTransform();
+	MeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+}
+
+float ASpartanCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+
+	AMPShooterGameState* MPShooterGameState = GetWorld()->GetGameState<AMPShooterGameState>();
+	if (!HasAuthority() || MPShooterGameState == nullptr || ActualDamage <= 0.f) return 0.f;
+
+	APlayerState* InstigatorPlayerState = EventInstigator ? EventInstigator->GetPlayerState<APlayerState>() : nullptr;
+	bool bKilled = false;
+	const float DamageDealt = MPShooterGameState->ApplyDamage(GetPlayerState(), InstigatorPlayerState, ActualDamage, bKilled);
+
+	ASpartanCharacter* InstigatorCharacter = EventInstigator ? Cast<ASpartanCharacter>(EventInstigator->GetPawn()) : nullptr;
+	if (DamageDealt > 0.f && InstigatorCharacter && InstigatorCharacter != this && InstigatorCharacter->Combat)
+	{
+		InstigatorCharacter->Combat->AddHitMarker(DamageDealt, bKilled);
+	}
+	if (bKilled)
+	{
+		FMatchJournal::Record(EMatchJournalEvent::Kill, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(EventInstigator), GetActorLocation(), DamageDealt, FMatchJournal::GetPlayerId(this));
+		if (AMPShooterGameModeBase* GameMode = GetWorld()->GetAuthGameMode<AMPShooterGameModeBase>())
+		{
+			GameMode->PlayerEliminated(this, GetController(), EventInstigator);
+		}
+	}
+	return DamageDealt;
+}
+
+void ASpartanCharacter::Elim()
+{
+	if (!HasAuthority() || bEliminated) return;
+
+	if (Combat)
+	{
+		Combat->DropAllWeapons();
+	}
+	bEliminated = true;
+	ApplyEliminated();
+}
+
+void ASpartanCharacter::OnRep_Eliminated()
+{
+	if (bEliminated)
+	{
+		ApplyEliminated();
+	}
+}
+
+void ASpartanCharacter::ApplyEliminated()
+{
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.f);
+	}
+	GetMesh()->SetCollisionProfileName(FName("Ragdoll"));
+	GetMesh()->SetSimulatePhysics(true);
+	if (IsLocallyControlled())
+	{
+		UpdatePickupPrompt();
+	}
+}
+
+void ASpartanCharacter::ApplyServerFidelity(const FServerFidelity& Fidelity)
+{
+	const float BaseNetRate = CVarCharacterNetRate.GetValueOnGameThread() > 0.f ? CVarCharacterNetRate.GetValueOnGameThread() : GetDefault<ASpartanCharacter>(GetClass())->GetNetUpdateFrequency();
+	SetNetUpdateFrequency(BaseNetRate * Fidelity.NetRateScale);
+	SetMinNetUpdateFrequency(GetNetUpdateFrequency() * 0.5f);
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		GetMesh()->SetComponentTickInterval(Fidelity.AnimTickInterval); // nobody watches, the pose only has to keep up with hits and montages
+	}
+}
+
+void ASpartanCharacter::EnterPool()
+{
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	if (Combat)
+	{
+		Combat->SetComponentTickEnabled(false);
+	}
+	StreamingSource->DisableStreamingSource(); // nobody here, let the cells go
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll); // sends the hidden state, then costs nothing while pooled
+}
+
+void ASpartanCharacter::LeavePool(const FTransform& SpawnTransform)
+{
+	LLM_SCOPE_BYTAG(MPShooter_Characters);
+	SetNetDormancy(DORM_Awake);
+	// Nothing from the last life carries over: the pickup it died next to (the end overlap never comes with collision off; cleared
+	// before collision is back, so a pickup at the spawn point still counts), its aim (bAiming, the movement's aim flag, AO and turn
+	// in place) and its pending shots through ResetForRespawn
+	SetOverlappingWeapon(nullptr);
+	TeleportTo(SpawnTransform.GetLocation(), SpawnTransform.Rotator(), false, true);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	if (Combat)
+	{
+		Combat->SetComponentTickEnabled(true);
+	}
+	StreamingSource->EnableStreamingSource();
+
+	bEliminated = false;
+	RespawnCount++;
+	ResetForRespawn();
+	ForceNetUpdate();
+}
+
+void ASpartanCharacter::OnRep_RespawnCount()
+{
+	ResetForRespawn();
+}
+
+void ASpartanCharacter::ResetForRespawn()
+{
+	// Put the ragdoll back on the capsule
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	GetMesh()->SetRelativeTransform(MeshRelativeTransform);
+	GetMesh()->SetCollisionProfileName(MeshCollisionProfile);
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	if (bIsCrouched)
+	{
+		UnCrouch();
+	}
+
+	AimState = FSpartanAimState();
+	AimState.StartingAimYaw = GetActorRotation().Yaw;
+	AimSnapshots.Reset(); // teleported, don't interpolate from where we died
+	RenderAimRotation = GetBaseAimRotation();
+	bRenderAimFromSnapshots = false;
+
+	if (Combat)
+	{
+		Combat->ResetCombatState();
+	}
+	if (USpartanAnimInstance* SpartanAnimInstance = Cast<USpartanAnimInstance>(GetMesh()->GetAnimInstance()))
+	{
+		SpartanAnimInstance->StopAllMontages(0.f);
+		SpartanAnimInstance->ResetForRespawn();
+	}
 }
 
 void ASpartanCharacter::PlayFireMontage(bool bAiming)
@@ -111,6 +349,15 @@ void ASpartanCharacter::PlayFireMontage(bool bAiming)
 	if (Combat == nullptr || Combat->EquippedWeapon == nullptr) return;
 	
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (CVarProceduralRecoil.GetValueOnGameThread() != 0)
+	{
+		// No montage instance and blend restarted per shot, per visible shooter, on every client
+		if (USpartanAnimInstance* SpartanAnimInstance = Cast<USpartanAnimInstance>(AnimInstance))
+		{
+			SpartanAnimInstance->AddRecoilImpulse(bAiming);
+			return;
+		}
+	}
 	if (AnimInstance && FireWeaponMontage)
 	{
 		
@@ -121,6 +368,19 @@ void ASpartanCharacter::PlayFireMontage(bool bAiming)
 	}
 }
 
+void ASpartanCharacter::StopFireMontage()
+{
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (USpartanAnimInstance* SpartanAnimInstance = Cast<USpartanAnimInstance>(AnimInstance))
+	{
+		SpartanAnimInstance->CancelRecoil(); // either path may have played the shot if the cvar changed in between
+	}
+	if (AnimInstance && FireWeaponMontage)
+	{
+		AnimInstance->Montage_Stop(0.1f, FireWeaponMontage);
+	}
+}
+
 void ASpartanCharacter::Move(const FInputActionValue& Value)
 {
 	const FVector2D MovementVector = Value.Get<FVector2D>();
@@ -161,6 +421,14 @@ void ASpartanCharacter::ServerEquipButtomPressed_Implementation()
 		Combat->EquipWeapon(OverlappingWeapon);
 }
 
+void ASpartanCharacter::SwapWeaponButtonPressed()
+{
+	if (Combat && !bEliminated)
+	{
+		Combat->SwapWeapons();
+	}
+}
+
 void ASpartanCharacter::CrouchButtonPressed()
 {
 	if (bIsCrouched)
@@ -214,102 +482,74 @@ void ASpartanCharacter::Jump()
 	}
 }
 
-void ASpartanCharacter::AimOffset(float DeltaTime) // Set Aim Offset Parameters and Params for TurningInPlace
+void ASpartanCharacter::PostNetReceive()
 {
-	if (Combat && Combat->EquippedWeapon == nullptr) return; // early out if we dont have a weapon
-	FVector Velocity = GetVelocity(); // Calculated Speed (we took code from Anim.cpp)
-	Velocity.Z = 0.f;
-	float Speed = Velocity.Size();
-
-	bool bIsInAir = GetCharacterMovement()->IsFalling();
+	Super::PostNetReceive();
+	if (GetLocalRole() != ROLE_SimulatedProxy) return;
+
+	// Called for every bunch; the buffer ignores ones without a new movement timestamp apart from the pitch.
+	AimSnapshots.Add(
+		GetReplicatedServerLastTransformUpdateTimeStamp(),
+		GetWorld()->GetTimeSeconds(),
+		GetActorRotation().Yaw,
+		FRotator::NormalizeAxis(GetBaseAimRotation().Pitch)); // RemoteViewPitch is compressed to [0, 360)
+}
 
-	if (Speed == 0.f && !bIsInAir) // standing still, not jumping
+void ASpartanCharacter::UpdateRenderAim()
+{
+	bRenderAimFromSnapshots = false;
+	if (GetLocalRole() == ROLE_SimulatedProxy && CVarAimSnapshots.GetValueOnGameThread() != 0)
 	{
-		FRotator CurrentAimRotation = FRotator(0.f, GetBaseAimRotation().Yaw, 0.f); // Gets us the delta between Starting Im Rotation and current aim rotation
-		FRotator DeltaAimRotation = UKismetMathLibrary::NormalizedDeltaRotator(CurrentAimRotation, StartingAimRotation);
-		AO_Yaw = DeltaAimRotation.Yaw;
-		if (TurningInPlace == ETurningInPlace::ETIP_NotTurning) // Used for TIP
+		float Yaw, Pitch;
+		if (AimSnapshots.Sample(GetWorld()->GetTimeSeconds(), Yaw, Pitch))
 		{
-			Interp_AO_Yaw = AO_Yaw; // If we are not turning, InterpYaw = AO_Yaw.  See below for next step(XX)
+			RenderAimRotation = FRotator(Pitch, Yaw, 0.f);
+			bRenderAimFromSnapshots = true;
+			return;
 		}
-		bUseControllerRotationYaw = true; // Set true when standing still so that TurnInPlace functionality can happen.
-
-		TurnInPlace(DeltaTime); // Set function here because we are already checking standing still/not jumping
-
-	}
-	if (Speed > 0.f || bIsInAir) // we use this to store our "starting base yaw" when we stop moving, so we can compare it to our rotation yaw while idle.
-	{
-		StartingAimRotation = FRotator(0.f, GetBaseAimRotation().Yaw, 0.f); // Stored every frame while we have a weapon or are in the air (not idle)
-		AO_Yaw = 0.f; // keep AO_Yaw at 0 every frame while we are moving.
-		bUseControllerRotationYaw = true;
-
-		TurningInPlace = ETurningInPlace::ETIP_NotTurning; // Set TIP so we dont use TIP functionality
-
-	}
-	// set Pitch
-	AO_Pitch = GetBaseAimRotation().Pitch;
-	if (AO_Pitch > 90.f && !IsLocallyControlled()) // correct for bitwise operations in pitch inhereint in charactermovementcomponent between server/clients
-	{
-		// Map pitch from {270, 360) to [-90, 0)  -  From lesson 59 in multiplayer tutorial "Pitch in Multiplayer"
-		FVector2D InRange(270.f, 360.f);
-		FVector2D OutRange(-90.f, 0.f);
-		AO_Pitch = FMath::GetMappedRangeValueClamped(InRange, OutRange, AO_Pitch);
-
 	}
+	RenderAimRotation = GetBaseAimRotation();
+}
 
-} 
-
-void ASpartanCharacter::TurnInPlace(float DeltaTime)
+void ASpartanCharacter::AimOffset(float DeltaTime) // Set Aim Offset Parameters and Params for TurningInPlace
 {
-	if (AO_Yaw > 70.f)
-	{
-		TurningInPlace = ETurningInPlace::ETIP_Right;
-	}
-	else if (AO_Yaw < -90.f)
-	{
-		TurningInPlace = ETurningInPlace::ETIP_Left;
-	}
-	if (TurningInPlace != ETurningInPlace::ETIP_NotTurning)
-	{
-		Interp_AO_Yaw = FMath::FInterpTo(Interp_AO_Yaw, 0.f, DeltaTime, 4.f); // 4.f (Interp Speed) controls the speed at which we turn.
-		AO_Yaw = Interp_AO_Yaw; // (XX) If we are turning, we reset AO_Yaw to the interpolated value.
-		if (FMath::Abs(AO_Yaw) < 15.f) //  check to see if we've turned enough, and if we have, set TIP to NotTurning.
-		{
-			TurningInPlace = ETurningInPlace::ETIP_NotTurning;
-			StartingAimRotation = FRotator(0.f, GetBaseAimRotation().Yaw, 0.f); // Now, we have turned enough and can reset our Starting Aim Rotation. 
-		}
-	}
+	if (Combat && Combat->EquippedWeapon == nullptr) return; // early out if we dont have a weapon
 
+	const FRotator& AimRotation = RenderAimRotation;
+	FSpartanAimInput Input;
+	Input.Velocity = GetVelocity();
+	Input.bIsInAir = GetCharacterMovement()->IsFalling();
+	Input.AimYaw = AimRotation.Yaw;
+	Input.AimPitch = AimRotation.Pitch;
+	Input.bRemotePitch = !IsLocallyControlled(); // correct for the pitch compression in charactermovementcomponent between server/clients
+	Input.DeltaTime = DeltaTime;
+	AimState = FSpartanAimMath::UpdateAimOffset(AimState, Input);
+	bUseControllerRotationYaw = true; // With a weapon we always face the aim; standing still, TurnInPlace covers the body catching up.
 }
 
 void ASpartanCharacter::SetOverlappingWeapon(AWeapon* Weapon)
 {
-	if (OverlappingWeapon)
-	{
-		OverlappingWeapon->ShowPickupWidget(false);
-	}
 	OverlappingWeapon = Weapon;
-	if (IsLocallyControlled())  // Allows the server to show the widget
+	if (IsLocallyControlled())  // Allows the server to show the prompt
 	{
-		if (OverlappingWeapon)
-		{
-			OverlappingWeapon->ShowPickupWidget(true); 
-		}
+		UpdatePickupPrompt();
 	}
 }
 
 void ASpartanCharacter::OnRep_OverlappingWeapon(AWeapon* LastWeapon)
 {
+	UpdatePickupPrompt(); // The HUD's shared prompt moves from LastWeapon to OverlappingWeapon (or hides if null).
+}
 
-	if (OverlappingWeapon)
-	{
-		OverlappingWeapon->ShowPickupWidget(true);
-	}
-	if (LastWeapon)
+void ASpartanCharacter::UpdatePickupPrompt()
+{
+	APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if (PlayerController == nullptr || !PlayerController->IsLocalController()) return;
+
+	if (ASpartanHUD* SpartanHUD = Cast<ASpartanHUD>(PlayerController->GetHUD()))
 	{
-		LastWeapon->ShowPickupWidget(false);  // (E3) Functionality to hide widget.
+		SpartanHUD->SetPickupPromptTarget(OverlappingWeapon);
 	}
-
 }
 
 bool ASpartanCharacter::IsWeaponEquipped()
@@ -322,6 +562,20 @@ bool ASpartanCharacter::bIsAiming()
 	return (Combat && Combat->bAiming);
 }
 
+void ASpartanCharacter::OnServerAimingChanged(bool bAiming)
+{
+	if (Combat)
+	{
+		FMatchJournal::Record(bAiming ? EMatchJournalEvent::AimStart : EMatchJournalEvent::AimStop, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(this), GetActorLocation());
+		Combat->bAiming = bAiming;
+	}
+}
+
+USpartanMovementComponent* ASpartanCharacter::GetSpartanMovement() const
+{
+	return Cast<USpartanMovementComponent>(GetCharacterMovement());
+}
+
 AWeapon* ASpartanCharacter::GetEquippedWeapon()  // Getter for FABRIK IK in AnimInstance
 {
 	if (Combat == nullptr) return nullptr;
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/SpartanPawnPoolSubsystem.h"
+#include "Character/SpartanCharacter.h"
+#include "Engine/World.h"
+
+bool USpartanPawnPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void USpartanPawnPoolSubsystem::Release(ASpartanCharacter* Character)
+{
+	if (Character == nullptr || PooledCharacters.Contains(Character)) return;
+
+	Character->EnterPool();
+	PooledCharacters.Add(Character);
+}
+
+ASpartanCharacter* USpartanPawnPoolSubsystem::Acquire(TSubclassOf<ASpartanCharacter> CharacterClass)
+{
+	for (int32 Index = PooledCharacters.Num() - 1; Index >= 0; --Index)
+	{
+		ASpartanCharacter* Character = PooledCharacters[Index];
+		if (!IsValid(Character))
+		{
+			PooledCharacters.RemoveAtSwap(Index);
+			continue;
+		}
+		if (CharacterClass == nullptr || Character->IsA(CharacterClass))
+		{
+			PooledCharacters.RemoveAtSwap(Index);
+			return Character;
+		}
+	}
+	return nullptr;
+}
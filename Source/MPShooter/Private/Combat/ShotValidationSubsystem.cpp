@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/ShotValidationSubsystem.h"
+#include "SpartanComponents/CombatComponent.h"
+#include "Character/SpartanCharacter.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Shot Validation"), STAT_MPShooter_ShotValidation, STATGROUP_MPShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots Validated"), STAT_MPShooter_ShotsValidated, STATGROUP_MPShooter);
+
+static TAutoConsoleVariable<int32> CVarShotValidationParallel(
+	TEXT("MPShooter.ShotValidation.Parallel"),
+	1,
+	TEXT("Run the per-frame shot validation traces on the task graph (1) or serially on the game thread (0)."));
+
+static TAutoConsoleVariable<float> CVarShotValidationTolerance(
+	TEXT("MPShooter.ShotValidation.Tolerance"),
+	100.f,
+	TEXT("How far (cm) short of the claimed hit point the server's trace may be blocked and still accept the shot."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdBenchShotValidation(
+	TEXT("MPShooter.BenchShotValidation"),
+	TEXT("Validates N synthetic shots (default 500) serially and in parallel and prints the time for each."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr) return;
+		const int32 NumShots = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 500;
+
+		TArray<FVector> Origins;
+		for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+		{
+			Origins.Add(It->GetActorLocation());
+		}
+		if (Origins.Num() == 0)
+		{
+			Origins.Add(FVector::ZeroVector);
+		}
+
+		FRandomStream Random(1234); // same shots every run
+		TArray<FShotValidationJob> Jobs;
+		Jobs.SetNum(NumShots);
+		for (int32 Index = 0; Index < NumShots; ++Index)
+		{
+			FShotValidationJob& Job = Jobs[Index];
+			Job.TraceStart = Origins[Index % Origins.Num()] + FVector(0.f, 0.f, 60.f);
+			Job.TraceEnd = Job.TraceStart + Random.GetUnitVector() * Random.FRandRange(500.f, 10000.f);
+			Job.bPrecheckPassed = true;
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		UShotValidationSubsystem::RunValidationTraces(World, Jobs, false);
+		const double SerialMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		UShotValidationSubsystem::RunValidationTraces(World, Jobs, true);
+		const double ParallelMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		UE_LOG(LogTemp, Display, TEXT("Shot validation, %d shots: serial %.3f ms, parallel %.3f ms"), NumShots, SerialMs, ParallelMs);
+	}));
+
+bool UShotValidationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_Client; // shots are only validated where ServerFire runs
+}
+
+TStatId UShotValidationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShotValidationSubsystem, STATGROUP_Tickables);
+}
+
+void UShotValidationSubsystem::QueueShot(UCombatComponent* Combat, const FVector_NetQuantize& TraceHitTarget, uint16 PredictionKey)
+{
+	QueuedShots.Add({ Combat, TraceHitTarget, PredictionKey });
+}
+
+void UShotValidationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (QueuedShots.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_ShotValidation);
+	INC_DWORD_STAT_BY(STAT_MPShooter_ShotsValidated, QueuedShots.Num());
+
+	// 1. Snapshot everything the traces need on the game thread.
+	Jobs.Reset();
+	Jobs.SetNum(QueuedShots.Num());
+	for (int32 Index = 0; Index < QueuedShots.Num(); ++Index)
+	{
+		const FQueuedShot& Shot = QueuedShots[Index];
+		FShotValidationJob& Job = Jobs[Index];
+		PrepareJob(Shot.Combat.Get(), Shot.TraceHitTarget, Job);
+	}
+
+	// 2. Traces, in parallel.
+	RunValidationTraces(GetWorld(), Jobs, CVarShotValidationParallel.GetValueOnGameThread() != 0);
+
+	// 3. Apply in arrival order so results don't depend on which task finished first.
+	TArray<FQueuedShot> ShotsToApply = MoveTemp(QueuedShots); // applying can queue more (listen server host), those wait for next frame
+	QueuedShots.Reset();
+	for (int32 Index = 0; Index < ShotsToApply.Num(); ++Index)
+	{
+		if (UCombatComponent* Combat = ShotsToApply[Index].Combat.Get())
+		{
+			Combat->ApplyValidatedShot(ShotsToApply[Index].TraceHitTarget, ShotsToApply[Index].PredictionKey, Jobs[Index].bAccepted);
+		}
+	}
+}
+
+void UShotValidationSubsystem::RunValidationTraces(UWorld* World, TArray<FShotValidationJob>& Jobs, bool bParallel)
+{
+	if (World == nullptr) return;
+
+	const float Tolerance = GetTolerance();
+	ParallelFor(Jobs.Num(), [World, Tolerance, &Jobs](int32 Index)
+	{
+		TraceJob(World, Jobs[Index], Tolerance);
+	}, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+bool UShotValidationSubsystem::PrepareJob(const UCombatComponent* Combat, const FVector& TraceHitTarget, FShotValidationJob& Job)
+{
+	Job.bPrecheckPassed = false;
+	if (Combat == nullptr || !Combat->IsFireInRange(TraceHitTarget)) return false;
+
+	Job.TraceStart = Combat->EquippedWeapon->GetMuzzleLocation();
+	Job.TraceEnd = TraceHitTarget;
+	Job.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(ShotValidation), false, Combat->Character);
+	Job.QueryParams.AddIgnoredActor(Combat->EquippedWeapon);
+	Job.bPrecheckPassed = true;
+	return true;
+}
+
+void UShotValidationSubsystem::TraceJob(const UWorld* World, FShotValidationJob& Job, float Tolerance)
+{
+	if (World == nullptr || !Job.bPrecheckPassed)
+	{
+		Job.bAccepted = false;
+		return;
+	}
+
+	FHitResult Hit;
+	const bool bBlocked = World->LineTraceSingleByChannel(Hit, Job.TraceStart, Job.TraceEnd, ECollisionChannel::ECC_Visibility, Job.QueryParams);
+	const float ClaimedDistance = FVector::Dist(Job.TraceStart, Job.TraceEnd);
+	Job.bAccepted = !bBlocked || Hit.Distance >= ClaimedDistance - Tolerance; // something solid between muzzle and the claimed hit means no
+}
+
+float UShotValidationSubsystem::GetTolerance()
+{
+	return CVarShotValidationTolerance.GetValueOnAnyThread();
+}
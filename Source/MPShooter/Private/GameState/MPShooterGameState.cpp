@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameState/MPShooterGameState.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
+
+FPlayerCombatStats* FPlayerCombatStatsArray::Find(const APlayerState* PlayerState)
+{
+	return Items.FindByPredicate([PlayerState](const FPlayerCombatStats& Stats) { return Stats.PlayerState == PlayerState; });
+}
+
+const FPlayerCombatStats* FPlayerCombatStatsArray::Find(const APlayerState* PlayerState) const
+{
+	return Items.FindByPredicate([PlayerState](const FPlayerCombatStats& Stats) { return Stats.PlayerState == PlayerState; });
+}
+
+AMPShooterGameState::AMPShooterGameState()
+{
+	MaxHealth = 100.f;
+	StartingArmor = 0.f;
+	ArmorAbsorption = 0.5f;
+}
+
+void AMPShooterGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AMPShooterGameState, CombatStats);
+}
+
+void AMPShooterGameState::AddPlayerState(APlayerState* PlayerState)
+{
+	Super::AddPlayerState(PlayerState);
+
+	if (HasAuthority() && PlayerState && CombatStats.Find(PlayerState) == nullptr)
+	{
+		FPlayerCombatStats& Stats = CombatStats.Items.AddDefaulted_GetRef();
+		Stats.PlayerState = PlayerState;
+		Stats.Health = MaxHealth;
+		Stats.Armor = StartingArmor;
+		CombatStats.MarkItemDirty(Stats);
+	}
+}
+
+void AMPShooterGameState::RemovePlayerState(APlayerState* PlayerState)
+{
+	if (HasAuthority())
+	{
+		const int32 Removed = CombatStats.Items.RemoveAll([PlayerState](const FPlayerCombatStats& Stats) { return Stats.PlayerState == PlayerState; });
+		if (Removed > 0)
+		{
+			CombatStats.MarkArrayDirty();
+		}
+	}
+
+	Super::RemovePlayerState(PlayerState);
+}
+
+float AMPShooterGameState::ApplyDamage(APlayerState* Victim, APlayerState* DamageInstigator, float Damage, bool& bOutKilled)
+{
+	bOutKilled = false;
+	FPlayerCombatStats* VictimStats = CombatStats.Find(Victim);
+	if (!HasAuthority() || VictimStats == nullptr || VictimStats->Health <= 0.f || Damage <= 0.f) return 0.f;
+
+	const float Absorbed = FMath::Min(VictimStats->Armor, Damage * ArmorAbsorption);
+	VictimStats->Armor -= Absorbed;
+	const float HealthDamage = FMath::Min(VictimStats->Health, Damage - Absorbed);
+	VictimStats->Health -= HealthDamage;
+	CombatStats.MarkItemDirty(*VictimStats);
+
+	if (VictimStats->Health <= 0.f)
+	{
+		bOutKilled = true;
+		VictimStats->Deaths++;
+		if (DamageInstigator && DamageInstigator != Victim)
+		{
+			if (FPlayerCombatStats* InstigatorStats = CombatStats.Find(DamageInstigator)) // VictimStats is still valid, Find doesn't resize
+			{
+				InstigatorStats->Kills++;
+				CombatStats.MarkItemDirty(*InstigatorStats);
+			}
+		}
+	}
+	return HealthDamage;
+}
+
+void AMPShooterGameState::ResetPlayerHealth(APlayerState* PlayerState)
+{
+	FPlayerCombatStats* Stats = CombatStats.Find(PlayerState);
+	if (!HasAuthority() || Stats == nullptr) return;
+
+	Stats->Health = MaxHealth;
+	Stats->Armor = StartingArmor;
+	CombatStats.MarkItemDirty(*Stats);
+}
+
+void AMPShooterGameState::RestoreScore(APlayerState* PlayerState, int32 Kills, int32 Deaths)
+{
+	FPlayerCombatStats* Stats = CombatStats.Find(PlayerState);
+	if (!HasAuthority() || Stats == nullptr) return;
+
+	Stats->Kills = Kills;
+	Stats->Deaths = Deaths;
+	CombatStats.MarkItemDirty(*Stats);
+}
+
+void AMPShooterGameState::RestoreHealth(APlayerState* PlayerState, float Health, float Armor)
+{
+	FPlayerCombatStats* Stats = CombatStats.Find(PlayerState);
+	if (!HasAuthority() || Stats == nullptr) return;
+
+	Stats->Health = FMath::Clamp(Health, 1.f, MaxHealth); // a snapshot only keeps the living
+	Stats->Armor = FMath::Max(Armor, 0.f);
+	CombatStats.MarkItemDirty(*Stats);
+}
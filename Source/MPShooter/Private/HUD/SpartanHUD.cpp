@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HUD/SpartanHUD.h"
+#include "Character/SpartanCharacter.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "Blueprint/UserWidget.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "EngineUtils.h"
+#include "CanvasItem.h"
+#include "GameFramework/PlayerState.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "GameState/MPShooterGameState.h"
+#include "SpartanComponents/CombatComponent.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarHUDNameplates(
+	TEXT("MPShooter.HUDNameplates"),
+	1,
+	TEXT("0 stops the HUD drawing nameplates (MPShooter.BenchNameplates turns them off while it measures widget components)."));
+
+ASpartanHUD::ASpartanHUD()
+{
+	LLM_SCOPE_BYTAG(MPShooter_HUD);
+	NameplateColor = FLinearColor::White;
+	NameplateMaxDistance = 5000.f;
+	NameplateHeightOffset = 30.f;
+	NameplateOcclusionGrace = 0.2f;
+	NameplateTextRefreshInterval = 0.5f;
+	bShowNetRole = false;
+
+	PickupPromptText = FText::FromString(TEXT("E - Pick Up"));
+	PickupPromptOffset = FVector(0.f, 0.f, 40.f);
+
+	HitMarkerDuration = 0.25f;
+	HitMarkerSize = 10.f;
+}
+
+void ASpartanHUD::DrawHUD()
+{
+	LLM_SCOPE_BYTAG(MPShooter_HUD);
+	Super::DrawHUD();
+
+	if (CVarHUDNameplates.GetValueOnGameThread() != 0)
+	{
+		DrawNameplates();
+	}
+	UpdatePickupPrompt();
+	DrawCombatStatus();
+}
+
+void ASpartanHUD::DrawCombatStatus()
+{
+	if (PlayerOwner == nullptr || Canvas == nullptr) return;
+
+	const AMPShooterGameState* MPShooterGameState = GetWorld()->GetGameState<AMPShooterGameState>();
+	const FPlayerCombatStats* Stats = MPShooterGameState ? MPShooterGameState->GetCombatStats(PlayerOwner->PlayerState) : nullptr;
+	if (Stats)
+	{
+		const FString StatusString = FString::Printf(TEXT("Health %.0f  Armor %.0f  K %d  D %d"), Stats->Health, Stats->Armor, Stats->Kills, Stats->Deaths);
+		DrawText(StatusString, FLinearColor::White, 20.f, Canvas->ClipY - 40.f, GEngine->GetSmallFont());
+	}
+
+	const ASpartanCharacter* SpartanCharacter = Cast<ASpartanCharacter>(PlayerOwner->GetPawn());
+	const UCombatComponent* Combat = SpartanCharacter ? SpartanCharacter->GetCombat() : nullptr;
+	if (Combat && Combat->GetLastHitMarkerTime() >= 0.f && GetWorld()->GetTimeSeconds() - Combat->GetLastHitMarkerTime() < HitMarkerDuration)
+	{
+		const FLinearColor MarkerColor = Combat->GetLastHitMarkers().NumKills > 0 ? FLinearColor::Red : FLinearColor::White;
+		const float CenterX = Canvas->ClipX * 0.5f;
+		const float CenterY = Canvas->ClipY * 0.5f;
+		const float Inner = HitMarkerSize * 0.4f;
+		DrawLine(CenterX - HitMarkerSize, CenterY - HitMarkerSize, CenterX - Inner, CenterY - Inner, MarkerColor, 2.f);
+		DrawLine(CenterX + HitMarkerSize, CenterY - HitMarkerSize, CenterX + Inner, CenterY - Inner, MarkerColor, 2.f);
+		DrawLine(CenterX - HitMarkerSize, CenterY + HitMarkerSize, CenterX - Inner, CenterY + Inner, MarkerColor, 2.f);
+		DrawLine(CenterX + HitMarkerSize, CenterY + HitMarkerSize, CenterX + Inner, CenterY + Inner, MarkerColor, 2.f);
+	}
+}
+
+void ASpartanHUD::SetPickupPromptTarget(AWeapon* Weapon)
+{
+	PickupPromptTarget = Weapon;
+	if (Weapon && PickupPrompt == nullptr && PickupPromptClass && PlayerOwner)
+	{
+		PickupPrompt = CreateWidget<UUserWidget>(PlayerOwner, PickupPromptClass);
+		if (PickupPrompt)
+		{
+			PickupPrompt->SetAlignmentInViewport(FVector2D(0.5f, 1.f));
+			PickupPrompt->AddToPlayerScreen();
+		}
+	}
+	if (PickupPrompt && Weapon == nullptr)
+	{
+		PickupPrompt->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
+
+void ASpartanHUD::UpdatePickupPrompt()
+{
+	LLM_SCOPE_BYTAG(MPShooter_HUD);
+	AWeapon* Weapon = PickupPromptTarget.Get();
+	bool bVisible = Weapon && Weapon->CanBePickedUp();
+	FVector ScreenLocation = FVector::ZeroVector;
+	if (bVisible)
+	{
+		ScreenLocation = Project(Weapon->GetActorLocation() + PickupPromptOffset);
+		bVisible = ScreenLocation.Z > 0.f; // in front of the camera
+	}
+
+	if (PickupPrompt)
+	{
+		PickupPrompt->SetVisibility(bVisible ? ESlateVisibility::HitTestInvisible : ESlateVisibility::Collapsed);
+		if (bVisible)
+		{
+			PickupPrompt->SetPositionInViewport(FVector2D(ScreenLocation.X, ScreenLocation.Y), true); // Project gives pixels, the viewport position is in DPI scaled units
+		}
+	}
+	else if (bVisible)
+	{
+		float TextWidth = 0.f;
+		float TextHeight = 0.f;
+		UFont* Font = NameplateFont ? NameplateFont : GEngine->GetSmallFont();
+		const FString PromptString = PickupPromptText.ToString();
+		GetTextSize(PromptString, TextWidth, TextHeight, Font);
+		DrawText(PromptString, FLinearColor::White, ScreenLocation.X - TextWidth * 0.5f, ScreenLocation.Y - TextHeight, Font);
+	}
+}
+
+void ASpartanHUD::DrawNameplates()
+{
+	MPSHOOTER_PERF_SCOPE(HUD);
+	if (PlayerOwner == nullptr || Canvas == nullptr) return;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerOwner->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	const FVector ViewDirection = ViewRotation.Vector();
+	const float MaxDistanceSquared = FMath::Square(NameplateMaxDistance);
+	const float Now = GetWorld()->GetTimeSeconds();
+	const APawn* OwnPawn = PlayerOwner->GetPawn();
+
+	// Pass 1: cull and project every character once.
+	VisibleNameplates.Reset();
+	for (TActorIterator<ASpartanCharacter> It(GetWorld()); It; ++It)
+	{
+		ASpartanCharacter* Character = *It;
+		if (Character == OwnPawn || Character->IsHidden()) continue;
+
+		const FVector NameplateLocation = Character->GetActorLocation() + FVector(0.f, 0.f, Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + NameplateHeightOffset);
+		const FVector ToNameplate = NameplateLocation - ViewLocation;
+		const float DistanceSquared = ToNameplate.SizeSquared();
+		if (DistanceSquared > MaxDistanceSquared) continue; // distance cull
+		if ((ToNameplate | ViewDirection) <= 0.f) continue; // behind the camera
+		if (!Character->WasRecentlyRendered(NameplateOcclusionGrace)) continue; // occluded (uses the renderer's occlusion results)
+
+		FNameplateEntry& Entry = NameplateCache.FindOrAdd(Character);
+		Entry.LastSeenFrame = GFrameCounter;
+		if (Now >= Entry.NextRefreshTime)
+		{
+			RefreshNameplateText(Character, Entry);
+			Entry.NextRefreshTime = Now + NameplateTextRefreshInterval;
+		}
+
+		const FVector ScreenLocation = Canvas->Project(NameplateLocation);
+		VisibleNameplates.Add({ FVector2D(ScreenLocation.X, ScreenLocation.Y), DistanceSquared, Entry.TextWidth, Entry.Text });
+	}
+
+	// Pass 2: far to near, so closer nameplates are drawn on top, all in one run of canvas items.
+	VisibleNameplates.Sort([](const FVisibleNameplate& A, const FVisibleNameplate& B) { return A.DistanceSquared > B.DistanceSquared; });
+	UFont* Font = NameplateFont ? NameplateFont : GEngine->GetSmallFont();
+	FCanvasTextItem TextItem(FVector2D::ZeroVector, FText::GetEmpty(), Font, NameplateColor);
+	TextItem.EnableShadow(FLinearColor::Black);
+	for (const FVisibleNameplate& Nameplate : VisibleNameplates)
+	{
+		TextItem.Position = FVector2D(Nameplate.ScreenPosition.X - Nameplate.TextWidth * 0.5f, Nameplate.ScreenPosition.Y);
+		TextItem.Text = Nameplate.Text;
+		Canvas->DrawItem(TextItem);
+	}
+
+	// Drop entries for characters that are gone, once a second or so.
+	if (GFrameCounter % 60 == 0)
+	{
+		for (auto It = NameplateCache.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid() || GFrameCounter - It.Value().LastSeenFrame > 600)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+void ASpartanHUD::RefreshNameplateText(ASpartanCharacter* Character, FNameplateEntry& Entry)
+{
+	FString NewString;
+	BuildNameplateString(Character, NewString);
+	if (NewString.Equals(Entry.SourceString, ESearchCase::CaseSensitive)) return; // text unchanged, keep the cached FText
+
+	Entry.SourceString = MoveTemp(NewString);
+	Entry.Text = FText::FromString(Entry.SourceString);
+	float TextHeight = 0.f;
+	Canvas->TextSize(NameplateFont ? NameplateFont : GEngine->GetSmallFont(), Entry.SourceString, Entry.TextWidth, TextHeight);
+}
+
+void ASpartanHUD::BuildNameplateString(ASpartanCharacter* Character, FString& OutString) const
+{
+	if (bShowNetRole)
+	{
+		OutString = FString::Printf(TEXT("Remote Role: %s"), *UEnum::GetValueAsString(Character->GetRemoteRole()));
+		return;
+	}
+	const APlayerState* PlayerState = Character->GetPlayerState();
+	OutString = PlayerState ? PlayerState->GetPlayerName() : FString();
+}
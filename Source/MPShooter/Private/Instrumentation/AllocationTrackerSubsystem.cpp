@@ -0,0 +1,364 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/AllocationTrackerSubsystem.h"
+#include "Weapon/Projectile.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Misc/CommandLine.h"
+#include "Tasks/Task.h"
+#include "UObject/UObjectBase.h"
+
+static TAutoConsoleVariable<int32> CVarAllocBudgetAssert(
+	TEXT("MPShooter.AllocBudgetAssert"),
+	0,
+	TEXT("1: a UObject allocation budget violation fires an ensure (fails automation tests) instead of just logging."));
+
+static TAutoConsoleVariable<int32> CVarAllocFrameWarn(
+	TEXT("MPShooter.AllocFrameWarn"),
+	200,
+	TEXT("Log frames that construct more UObjects than this while allocation tracking is on (0 = never)."));
+
+static FAutoConsoleCommand CmdTrackAllocations(
+	TEXT("MPShooter.TrackAllocations"),
+	TEXT("Turns UObject allocation tracking on (1) or off (0)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (UAllocationTrackerSubsystem* Tracker = UAllocationTrackerSubsystem::Get())
+		{
+			Tracker->SetTracking(Args.Num() == 0 || FCString::Atoi(*Args[0]) != 0);
+		}
+	}));
+
+static FAutoConsoleCommand CmdAllocReport(
+	TEXT("MPShooter.AllocReport"),
+	TEXT("Prints UObject constructions per class, GC pauses and allocation budget violations. 'reset' clears them."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		UAllocationTrackerSubsystem* Tracker = UAllocationTrackerSubsystem::Get();
+		if (Tracker == nullptr) return;
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			Tracker->Reset();
+			FUObjectAllocationBudgetScope::ResetViolations();
+			return;
+		}
+		Tracker->DumpReport();
+		FUObjectAllocationBudgetScope::DumpViolations();
+	}));
+
+UAllocationTrackerSubsystem* UAllocationTrackerSubsystem::Instance = nullptr;
+
+void UAllocationTrackerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (Instance == nullptr) // PIE: the first game instance tracks for everyone, listeners are global
+	{
+		Instance = this;
+		if (FParse::Param(FCommandLine::Get(), TEXT("TrackAllocations")))
+		{
+			SetTracking(true);
+		}
+	}
+}
+
+void UAllocationTrackerSubsystem::Deinitialize()
+{
+	if (Instance == this)
+	{
+		SetTracking(false);
+		Instance = nullptr;
+	}
+	GCCsvTask.Wait(); // the last GC row makes it to disk
+
+	Super::Deinitialize();
+}
+
+void UAllocationTrackerSubsystem::SetTracking(bool bEnable)
+{
+	if (bTracking == bEnable) return;
+	bTracking = bEnable;
+
+	if (bEnable)
+	{
+		GUObjectArray.AddUObjectCreateListener(this);
+		GUObjectArray.AddUObjectDeleteListener(this);
+		FrameTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UAllocationTrackerSubsystem::TickFrame));
+		PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UAllocationTrackerSubsystem::OnPreGarbageCollect);
+		PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UAllocationTrackerSubsystem::OnPostGarbageCollect);
+	}
+	else
+	{
+		GUObjectArray.RemoveUObjectCreateListener(this);
+		GUObjectArray.RemoveUObjectDeleteListener(this);
+		FTSTicker::GetCoreTicker().RemoveTicker(FrameTickHandle);
+		FrameTickHandle.Reset();
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+		FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+	}
+	FUObjectAllocationBudgetScope::SetEnabled(bEnable);
+	UE_LOG(LogTemp, Log, TEXT("UObject allocation tracking %s"), bEnable ? TEXT("on") : TEXT("off"));
+}
+
+void UAllocationTrackerSubsystem::NotifyUObjectCreated(const UObjectBase* Object, int32 Index)
+{
+	FScopeLock Lock(&StatsLock);
+	const UClass* Class = Object->GetClass();
+	FClassAllocStats* Stats = ClassStats.Find(Class);
+	if (Stats == nullptr)
+	{
+		Stats = &ClassStats.Add(Class);
+		Stats->ClassName = Class ? Class->GetFName() : NAME_None;
+	}
+	Stats->Created++;
+	Stats->CreatedThisFrame++;
+	Stats->CreatedSinceGC++;
+	ObjectsCreatedThisFrame++;
+	ObjectsCreatedSinceGC++;
+	TotalObjectsCreated++;
+}
+
+void UAllocationTrackerSubsystem::NotifyUObjectDeleted(const UObjectBase* Object, int32 Index)
+{
+	FScopeLock Lock(&StatsLock);
+	if (FClassAllocStats* Stats = ClassStats.Find(Object->GetClass()))
+	{
+		Stats->Destroyed++;
+	}
+	ObjectsDestroyedThisFrame++;
+	ObjectsDestroyedSinceGC++;
+}
+
+void UAllocationTrackerSubsystem::OnUObjectArrayShutdown()
+{
+	bTracking = false;
+	GUObjectArray.RemoveUObjectCreateListener(this);
+	GUObjectArray.RemoveUObjectDeleteListener(this);
+}
+
+bool UAllocationTrackerSubsystem::TickFrame(float DeltaTime)
+{
+	FScopeLock Lock(&StatsLock);
+
+	const int32 WarnThreshold = CVarAllocFrameWarn.GetValueOnGameThread();
+	if (WarnThreshold > 0 && ObjectsCreatedThisFrame > (uint32)WarnThreshold)
+	{
+		FName TopClass = NAME_None;
+		uint32 TopCount = 0;
+		for (const TPair<const UClass*, FClassAllocStats>& Pair : ClassStats)
+		{
+			if (Pair.Value.CreatedThisFrame > TopCount)
+			{
+				TopCount = Pair.Value.CreatedThisFrame;
+				TopClass = Pair.Value.ClassName;
+			}
+		}
+		UE_LOG(LogTemp, Warning, TEXT("Frame %llu constructed %u UObjects (destroyed %u), most were %s x%u"), GFrameCounter, ObjectsCreatedThisFrame, ObjectsDestroyedThisFrame, *TopClass.ToString(), TopCount);
+	}
+
+	for (TPair<const UClass*, FClassAllocStats>& Pair : ClassStats)
+	{
+		Pair.Value.MaxCreatedInFrame = FMath::Max(Pair.Value.MaxCreatedInFrame, Pair.Value.CreatedThisFrame);
+		Pair.Value.CreatedThisFrame = 0;
+	}
+	MaxObjectsCreatedInFrame = FMath::Max(MaxObjectsCreatedInFrame, ObjectsCreatedThisFrame);
+	ObjectsCreatedThisFrame = 0;
+	ObjectsDestroyedThisFrame = 0;
+	FramesTracked++;
+	return true;
+}
+
+void UAllocationTrackerSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UAllocationTrackerSubsystem::OnPostGarbageCollect()
+{
+	const double PauseMs = (FPlatformTime::Seconds() - GCStartTime) * 1000.0;
+	NumGCs++;
+	GCPauseMsSum += PauseMs;
+	GCPauseMsMax = FMath::Max(GCPauseMsMax, PauseMs);
+
+	FScopeLock Lock(&StatsLock);
+
+	// What gameplay did since the last GC: projectiles are one per shot, plus the class that allocated most.
+	uint64 ProjectilesSinceGC = 0;
+	FName TopClass = NAME_None;
+	uint64 TopCount = 0;
+	for (TPair<const UClass*, FClassAllocStats>& Pair : ClassStats)
+	{
+		if (Pair.Key && Pair.Key->IsChildOf(AProjectile::StaticClass()))
+		{
+			ProjectilesSinceGC += Pair.Value.CreatedSinceGC;
+		}
+		if (Pair.Value.CreatedSinceGC > TopCount)
+		{
+			TopCount = Pair.Value.CreatedSinceGC;
+			TopClass = Pair.Value.ClassName;
+		}
+		Pair.Value.CreatedSinceGC = 0;
+	}
+	UE_LOG(LogTemp, Log, TEXT("GC %.2f ms: since last GC %llu UObjects constructed, %llu destroyed, %llu projectiles (shots), top class %s x%llu"),
+		PauseMs, ObjectsCreatedSinceGC, ObjectsDestroyedSinceGC, ProjectilesSinceGC, *TopClass.ToString(), TopCount);
+
+	// Still inside the GC's post delegates, the file write doesn't belong in the pause we just measured
+	FString Row = FString::Printf(TEXT("%s,%llu,%.3f,%llu,%llu,%llu,%s,%llu") LINE_TERMINATOR, *FMPShooterCsv::Now(), GFrameCounter, PauseMs,
+		ObjectsCreatedSinceGC, ObjectsDestroyedSinceGC, ProjectilesSinceGC, *TopClass.ToString(), TopCount);
+	GCCsvTask = UE::Tasks::Launch(TEXT("GCCsvWrite"),
+		[Row = MoveTemp(Row)]()
+		{
+			FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("GC.csv")), TEXT("Time,Frame,PauseMs,CreatedSinceGC,DestroyedSinceGC,ProjectilesSinceGC,TopClass,TopClassCount"), Row);
+		}, UE::Tasks::Prerequisites(GCCsvTask), UE::Tasks::ETaskPriority::BackgroundNormal); // after the previous row
+
+	ObjectsCreatedSinceGC = 0;
+	ObjectsDestroyedSinceGC = 0;
+}
+
+void UAllocationTrackerSubsystem::Reset()
+{
+	FScopeLock Lock(&StatsLock);
+	ClassStats.Reset();
+	ObjectsCreatedThisFrame = ObjectsDestroyedThisFrame = 0;
+	ObjectsCreatedSinceGC = ObjectsDestroyedSinceGC = 0;
+	FramesTracked = 0;
+	MaxObjectsCreatedInFrame = 0;
+	TotalObjectsCreated = 0;
+	NumGCs = 0;
+	GCPauseMsSum = GCPauseMsMax = 0.0;
+}
+
+void UAllocationTrackerSubsystem::DumpReport() const
+{
+	FScopeLock Lock(&StatsLock);
+
+	const double Frames = FMath::Max<double>(FramesTracked, 1.0);
+	UE_LOG(LogTemp, Display, TEXT("UObject allocations over %llu frames: %llu constructed (%.2f/frame, max %u in one frame). %u GCs, avg %.2f ms, max %.2f ms"),
+		FramesTracked, TotalObjectsCreated, TotalObjectsCreated / Frames, MaxObjectsCreatedInFrame, NumGCs, NumGCs > 0 ? GCPauseMsSum / NumGCs : 0.0, GCPauseMsMax);
+
+	TArray<const FClassAllocStats*> Sorted;
+	for (const TPair<const UClass*, FClassAllocStats>& Pair : ClassStats)
+	{
+		Sorted.Add(&Pair.Value);
+	}
+	Sorted.Sort([](const FClassAllocStats& A, const FClassAllocStats& B) { return A.Created > B.Created; });
+	for (int32 Index = 0; Index < FMath::Min(Sorted.Num(), 25); ++Index)
+	{
+		const FClassAllocStats& Stats = *Sorted[Index];
+		UE_LOG(LogTemp, Display, TEXT("  %-40s constructed %8llu (%.3f/frame, max %u/frame), destroyed %8llu"),
+			*Stats.ClassName.ToString(), Stats.Created, Stats.Created / Frames, Stats.MaxCreatedInFrame, Stats.Destroyed);
+	}
+}
+
+namespace AllocationBudget
+{
+	struct FViolations
+	{
+		uint32 Count = 0;
+		int32 Worst = 0;
+		int32 Budget = 0;
+	};
+	static TMap<FString, FViolations> Violations; // game thread only
+	static FUObjectAllocationBudgetScope* InnermostScope = nullptr; // game thread only
+	static bool bEnabled = false;
+}
+
+// Charges each construction to the innermost open scope. Separate from the tracker's own listener (that one counts every class
+// on every thread), so budgets don't depend on a game instance being around.
+class FUObjectBudgetListener : public FUObjectArray::FUObjectCreateListener
+{
+public:
+
+	virtual void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override
+	{
+		FUObjectAllocationBudgetScope* Scope = AllocationBudget::InnermostScope;
+		if (Scope == nullptr || !IsInGameThread()) return; // a task or the loading thread constructing at the same time isn't our path
+		if ((Object->GetFlags() & (RF_NeedLoad | RF_WasLoaded)) != 0) return; // the loader flushing packages on our frame, not our path either
+		Scope->Created++;
+	}
+
+	virtual void OnUObjectArrayShutdown() override
+	{
+		GUObjectArray.RemoveUObjectCreateListener(this);
+		AllocationBudget::bEnabled = false;
+	}
+};
+
+static FUObjectBudgetListener UObjectBudgetListener;
+
+void FUObjectAllocationBudgetScope::SetEnabled(bool bEnable)
+{
+	check(IsInGameThread());
+	if (AllocationBudget::bEnabled == bEnable) return;
+	AllocationBudget::bEnabled = bEnable;
+	if (bEnable)
+	{
+		GUObjectArray.AddUObjectCreateListener(&UObjectBudgetListener);
+	}
+	else
+	{
+		GUObjectArray.RemoveUObjectCreateListener(&UObjectBudgetListener);
+	}
+}
+
+bool FUObjectAllocationBudgetScope::IsEnabled()
+{
+	return AllocationBudget::bEnabled;
+}
+
+FUObjectAllocationBudgetScope::FUObjectAllocationBudgetScope(const TCHAR* InName, int32 InBudget)
+	: Name(InName)
+	, Budget(InBudget)
+	, bActive(AllocationBudget::bEnabled && IsInGameThread())
+{
+	if (bActive)
+	{
+		Outer = AllocationBudget::InnermostScope;
+		AllocationBudget::InnermostScope = this;
+	}
+}
+
+FUObjectAllocationBudgetScope::~FUObjectAllocationBudgetScope()
+{
+	if (!bActive) return;
+
+	AllocationBudget::InnermostScope = Outer;
+	if (Created <= Budget) return;
+
+	AllocationBudget::FViolations& Entry = AllocationBudget::Violations.FindOrAdd(Name);
+	Entry.Count++;
+	Entry.Worst = FMath::Max(Entry.Worst, Created);
+	Entry.Budget = Budget;
+	if (CVarAllocBudgetAssert.GetValueOnGameThread() != 0)
+	{
+		ensureAlwaysMsgf(false, TEXT("%s constructed %d UObjects, budget is %d"), Name, Created, Budget);
+	}
+	else if (Entry.Count == 1 || Entry.Count % 100 == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s constructed %d UObjects, budget is %d (%u violations so far)"), Name, Created, Budget, Entry.Count);
+	}
+}
+
+void FUObjectAllocationBudgetScope::ResetViolations()
+{
+	AllocationBudget::Violations.Reset();
+}
+
+uint32 FUObjectAllocationBudgetScope::GetViolations(const TCHAR* InName, int32* OutWorst)
+{
+	const AllocationBudget::FViolations* Entry = AllocationBudget::Violations.Find(InName);
+	if (OutWorst)
+	{
+		*OutWorst = Entry ? Entry->Worst : 0;
+	}
+	return Entry ? Entry->Count : 0;
+}
+
+void FUObjectAllocationBudgetScope::DumpViolations()
+{
+	for (const TPair<FString, AllocationBudget::FViolations>& Pair : AllocationBudget::Violations)
+	{
+		UE_LOG(LogTemp, Display, TEXT("  budget %s: %u violations, worst %d UObjects (budget %d)"), *Pair.Key, Pair.Value.Count, Pair.Value.Worst, Pair.Value.Budget);
+	}
+}
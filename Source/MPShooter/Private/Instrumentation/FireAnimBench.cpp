@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/SpartanCharacter.h"
+#include "Animation/AnimInstance.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+
+// Fire animation cost with everyone on full auto: the shots are only the cosmetic part (PlayFireMontage), nothing is traced or
+// replicated, so run it on a client or standalone with the characters in view. Once with MPShooter.ProceduralRecoil 1 and once with 0.
+// AnimUpdate only covers our NativeUpdateAnimation; for the montage / graph evaluation on the anim worker threads take a
+// "stat anim" or an Insights trace (-trace=cpu,anim) over the same run.
+namespace FireAnimBench
+{
+	struct FShooter
+	{
+		TWeakObjectPtr<ASpartanCharacter> Character;
+		double NextShotTime = 0.0;
+		bool bAiming = false;
+	};
+
+	struct FSession
+	{
+		TWeakObjectPtr<UWorld> World;
+		FString Label;
+		TArray<FShooter> Shooters;
+		double ShotInterval = 0.0;
+		double Elapsed = 0.0;
+		double Duration = 0.0;
+		int32 Frames = 0;
+		int32 Shots = 0;
+		uint64 TriggerCycles = 0;
+		double GameThreadMsSum = 0.0;
+		double AnimUpdateMsSum = 0.0;
+		uint32 AnimUpdateCalls = 0;
+		int64 MontageInstancesSum = 0;
+	};
+
+	static FSession Session;
+	static FTSTicker::FDelegateHandle TickHandle;
+
+	static void Finish()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+		FMPShooterPerfCounters::bEnabled = false;
+
+		const int32 ProceduralRecoil = IConsoleManager::Get().FindConsoleVariable(TEXT("MPShooter.ProceduralRecoil"))->GetInt();
+		const double Frames = FMath::Max(Session.Frames, 1);
+		const double Rpm = 60.0 / Session.ShotInterval;
+		const double GameThreadMs = Session.GameThreadMsSum / Frames;
+		const double AnimUpdateMs = Session.AnimUpdateMsSum / Frames;
+		const double AnimUpdateUs = Session.AnimUpdateCalls > 0 ? Session.AnimUpdateMsSum * 1000.0 / Session.AnimUpdateCalls : 0.0;
+		const double TriggerUs = Session.Shots > 0 ? FPlatformTime::ToMilliseconds64(Session.TriggerCycles) * 1000.0 / Session.Shots : 0.0;
+		const double MontageInstances = Session.MontageInstancesSum / Frames;
+
+		UE_LOG(LogTemp, Display, TEXT("Fire anim bench [%s] procedural recoil %d, %d shooters at %.0f RPM for %.1f s: game thread %.3f ms, AnimUpdate %.4f ms/frame (%.2f us/call), %d shots at %.2f us each, %.2f montage instances alive"),
+			*Session.Label, ProceduralRecoil, Session.Shooters.Num(), Rpm, Session.Elapsed, GameThreadMs, AnimUpdateMs, AnimUpdateUs, Session.Shots, TriggerUs, MontageInstances);
+
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("FireAnim.csv")), TEXT("Time,Label,ProceduralRecoil,Shooters,Rpm,Seconds,Frames,GameThreadMs,AnimUpdateMsPerFrame,AnimUpdateUsPerCall,Shots,TriggerUsPerShot,MontageInstances"),
+			FString::Printf(TEXT("%s,%s,%d,%d,%.0f,%.1f,%d,%.4f,%.4f,%.3f,%d,%.3f,%.2f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Session.Label,
+			ProceduralRecoil, Session.Shooters.Num(), Rpm, Session.Elapsed, Session.Frames, GameThreadMs, AnimUpdateMs, AnimUpdateUs, Session.Shots, TriggerUs, MontageInstances));
+	}
+
+	static bool Tick(float DeltaTime)
+	{
+		if (!Session.World.IsValid())
+		{
+			Finish();
+			return false;
+		}
+
+		// Counters cover the frame that just finished; the first tick only starts them.
+		if (FMPShooterPerfCounters::bEnabled)
+		{
+			Session.GameThreadMsSum += FPlatformTime::ToMilliseconds(GGameThreadTime);
+			Session.AnimUpdateMsSum += FPlatformTime::ToMilliseconds64(FMPShooterPerfCounters::Cycles[(int32)EMPShooterPerfScope::AnimUpdate]);
+			Session.AnimUpdateCalls += FMPShooterPerfCounters::Calls[(int32)EMPShooterPerfScope::AnimUpdate];
+			Session.Frames++;
+			Session.Elapsed += DeltaTime;
+		}
+		FMPShooterPerfCounters::Reset();
+		FMPShooterPerfCounters::bEnabled = true;
+
+		if (Session.Elapsed >= Session.Duration)
+		{
+			Finish();
+			return false;
+		}
+
+		for (FShooter& Shooter : Session.Shooters)
+		{
+			ASpartanCharacter* Character = Shooter.Character.Get();
+			if (Character == nullptr || Character->IsEliminated()) continue;
+
+			while (Shooter.NextShotTime <= Session.Elapsed) // a slow frame fires the shots it owes, like the weapon's own timer
+			{
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				Character->PlayFireMontage(Shooter.bAiming);
+				Session.TriggerCycles += FPlatformTime::Cycles64() - StartCycles;
+				Session.Shots++;
+				Shooter.NextShotTime += Session.ShotInterval;
+			}
+			const UAnimInstance* AnimInstance = Character->GetMesh()->GetAnimInstance();
+			Session.MontageInstancesSum += AnimInstance ? AnimInstance->MontageInstances.Num() : 0;
+		}
+		return true;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdBenchFireAnim(
+	TEXT("MPShooter.BenchFireAnim"),
+	TEXT("Plays the fire animation on up to N armed characters (default 16) at R rounds per minute (default 900) for S seconds (default 20), half of them aiming, and reports the anim update / game thread cost. Optional label as the fourth argument. Appends to Profiling/MPShooter/FireAnim.csv."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		using namespace FireAnimBench;
+		if (World == nullptr)
+		{
+			return;
+		}
+		if (TickHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		}
+
+		const int32 MaxShooters = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 16;
+		const float Rpm = Args.Num() > 1 ? FMath::Max(FCString::Atof(*Args[1]), 1.f) : 900.f;
+
+		Session = FSession();
+		Session.World = World;
+		Session.ShotInterval = 60.0 / Rpm;
+		Session.Duration = Args.Num() > 2 ? FMath::Max(FCString::Atof(*Args[2]), 1.f) : 20.0;
+		Session.Label = Args.Num() > 3 ? Args[3] : TEXT("");
+		for (TActorIterator<ASpartanCharacter> It(World); It && Session.Shooters.Num() < MaxShooters; ++It)
+		{
+			if (!It->IsWeaponEquipped() || It->IsEliminated()) continue;
+			FShooter& Shooter = Session.Shooters.AddDefaulted_GetRef();
+			Shooter.Character = *It;
+			Shooter.bAiming = Session.Shooters.Num() % 2 == 0;
+			Shooter.NextShotTime = Session.ShotInterval * (Session.Shooters.Num() - 1) / MaxShooters; // staggered, not all on one frame
+		}
+		if (Session.Shooters.Num() < MaxShooters)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchFireAnim: only %d armed characters in the world, wanted %d"), Session.Shooters.Num(), MaxShooters);
+		}
+		if (Session.Shooters.Num() == 0)
+		{
+			return;
+		}
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick));
+	}));
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/LatencyHarnessReportCommandlet.h"
+#include "Instrumentation/LatencyHarnessSubsystem.h"
+#include "Instrumentation/LatencyHistogram.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace LatencyHarnessReport
+{
+	struct FShotTimes
+	{
+		double Stage[(int32)ELatencyHarnessStage::Count] = {};
+		TArray<TPair<uint32, double>, TInlineAllocator<8>> Observers; // observer id, replicated time
+	};
+
+	struct FMeasure
+	{
+		const TCHAR* Name;
+		FLatencyHistogram Histogram;
+	};
+}
+
+ULatencyHarnessReportCommandlet::ULatencyHarnessReportCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 ULatencyHarnessReportCommandlet::Main(const FString& Params)
+{
+	using namespace LatencyHarnessReport;
+
+	FString Directory = ULatencyHarnessSubsystem::GetOutputDirectory();
+	FParse::Value(*Params, TEXT("Dir="), Directory);
+	FString Label = TEXT("default");
+	FParse::Value(*Params, TEXT("Label="), Label);
+
+	// Only the subsystem's stage files, <Role>_<pid>.csv: a -CSV= summary kept in the same directory isn't one
+	TArray<FString> Files;
+	for (const TCHAR* Pattern : { TEXT("Server_*.csv"), TEXT("Client_*.csv") })
+	{
+		TArray<FString> RoleFiles;
+		IFileManager::Get().FindFiles(RoleFiles, *(Directory / Pattern), true, false);
+		Files.Append(RoleFiles);
+	}
+	if (Files.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("LatencyHarnessReport: no stage files in %s"), *Directory);
+		return 1;
+	}
+
+	TMap<uint64, FShotTimes> Shots; // (shooter id << 16) | key
+	for (const FString& File : Files)
+	{
+		TArray<FString> Lines;
+		FFileHelper::LoadFileToStringArray(Lines, *(Directory / File));
+		for (int32 Index = 1; Index < Lines.Num(); ++Index) // skip the header
+		{
+			TArray<FString> Fields;
+			if (Lines[Index].ParseIntoArray(Fields, TEXT(",")) != 5) continue;
+			const int32 Stage = FCString::Atoi(*Fields[0]);
+			if (Stage < 0 || Stage >= (int32)ELatencyHarnessStage::Count) continue;
+			const uint64 ShotId = ((uint64)FCString::Strtoui64(*Fields[1], nullptr, 10) << 16) | (FCString::Atoi(*Fields[2]) & 0xFFFF);
+			const uint32 ObserverId = (uint32)FCString::Strtoui64(*Fields[3], nullptr, 10);
+			const double Time = FCString::Atod(*Fields[4]);
+
+			FShotTimes& Shot = Shots.FindOrAdd(ShotId);
+			if ((ELatencyHarnessStage)Stage == ELatencyHarnessStage::ObserverReplicated)
+			{
+				Shot.Observers.Emplace(ObserverId, Time);
+			}
+			else
+			{
+				Shot.Stage[Stage] = Time;
+			}
+		}
+	}
+
+	FMeasure Measures[] = {
+		{ TEXT("input -> ServerFire") },
+		{ TEXT("ServerFire -> projectile spawn") },
+		{ TEXT("spawn -> observer replicated") },
+		{ TEXT("input -> observer replicated") },
+		{ TEXT("input -> impact") },
+	};
+	int32 CompleteShots = 0;
+	int32 LostShots = 0;
+	for (const TPair<uint64, FShotTimes>& Pair : Shots)
+	{
+		const FShotTimes& Shot = Pair.Value;
+		const double Input = Shot.Stage[(int32)ELatencyHarnessStage::ClientInput];
+		const double Receipt = Shot.Stage[(int32)ELatencyHarnessStage::ServerFire];
+		const double Spawn = Shot.Stage[(int32)ELatencyHarnessStage::ProjectileSpawn];
+		const double Impact = Shot.Stage[(int32)ELatencyHarnessStage::Impact];
+		if (Input > 0.0 && Receipt == 0.0)
+		{
+			LostShots++; // never reached the server (packet loss, or the run ended)
+			continue;
+		}
+		if (Input > 0.0 && Receipt > 0.0)
+		{
+			Measures[0].Histogram.Add((Receipt - Input) * 1000.0);
+		}
+		if (Receipt > 0.0 && Spawn > 0.0)
+		{
+			Measures[1].Histogram.Add((Spawn - Receipt) * 1000.0);
+		}
+		const uint32 ShooterId = (uint32)(Pair.Key >> 16);
+		for (const TPair<uint32, double>& Observer : Shot.Observers)
+		{
+			if (Observer.Key == ShooterId) continue; // the shooter already saw its own predicted shot
+			if (Spawn > 0.0)
+			{
+				Measures[2].Histogram.Add((Observer.Value - Spawn) * 1000.0);
+			}
+			if (Input > 0.0)
+			{
+				Measures[3].Histogram.Add((Observer.Value - Input) * 1000.0);
+			}
+		}
+		if (Input > 0.0 && Impact > 0.0)
+		{
+			Measures[4].Histogram.Add((Impact - Input) * 1000.0);
+			CompleteShots++;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("LatencyHarnessReport [%s]: %d shots, %d reached impact, %d lost before the server"), *Label, Shots.Num(), CompleteShots, LostShots);
+	FString Row = FString::Printf(TEXT("%s,%s,%d,%d"), *FDateTime::Now().ToIso8601(), *Label, Shots.Num(), LostShots);
+	for (const FMeasure& Measure : Measures)
+	{
+		UE_LOG(LogTemp, Display, TEXT("  %-32s %s"), Measure.Name, *Measure.Histogram.ToString());
+		Row += FString::Printf(TEXT(",%.1f,%.1f,%.1f"), Measure.Histogram.GetPercentile(50.0), Measure.Histogram.GetPercentile(90.0), Measure.Histogram.GetPercentile(99.0));
+	}
+
+	FString CsvPath;
+	if (FParse::Value(*Params, TEXT("CSV="), CsvPath))
+	{
+		FString Header = TEXT("Date,Label,Shots,Lost");
+		for (const FMeasure& Measure : Measures)
+		{
+			Header += FString::Printf(TEXT(",%s p50,%s p90,%s p99"), Measure.Name, Measure.Name, Measure.Name);
+		}
+		FMPShooterCsv::Append(CsvPath, Header, Row + LINE_TERMINATOR);
+	}
+	return 0;
+}
@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/LatencyHarnessSubsystem.h"
+#include "Character/SpartanCharacter.h"
+#include "SpartanComponents/CombatComponent.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+ULatencyHarnessSubsystem* ULatencyHarnessSubsystem::Instance = nullptr;
+
+bool ULatencyHarnessSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && FParse::Param(FCommandLine::Get(), TEXT("LatencyHarness"));
+}
+
+void ULatencyHarnessSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Instance = this;
+	FParse::Value(FCommandLine::Get(), TEXT("-HarnessDuration="), Duration);
+	FParse::Value(FCommandLine::Get(), TEXT("-HarnessFireInterval="), FireInterval);
+	StartTime = FPlatformTime::Seconds();
+	LastFlushTime = StartTime;
+
+	const TCHAR* Role = IsRunningDedicatedServer() ? TEXT("Server") : TEXT("Client");
+	OutputPath = GetOutputDirectory() / FString::Printf(TEXT("%s_%u.csv"), Role, FPlatformProcess::GetCurrentProcessId());
+	FFileHelper::SaveStringToFile(TEXT("Stage,ShooterId,Key,ObserverId,Time") LINE_TERMINATOR, *OutputPath);
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ULatencyHarnessSubsystem::Tick));
+	UE_LOG(LogTemp, Display, TEXT("LatencyHarness: %s, %.0f s, fire every %.2f s, writing %s"), Role, Duration, FireInterval, *OutputPath);
+}
+
+void ULatencyHarnessSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	FlushEvents();
+	if (Instance == this)
+	{
+		Instance = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+void ULatencyHarnessSubsystem::RecordStage(ELatencyHarnessStage Stage, uint32 ShooterId, uint16 Key, uint32 ObserverId)
+{
+	if (Instance == nullptr || Key == 0) return; // unkeyed shots (listen host) can't be joined across processes
+	Instance->Events.Add({ FPlatformTime::Seconds(), ShooterId, ObserverId, Key, Stage });
+}
+
+FString ULatencyHarnessSubsystem::GetOutputDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("LatencyHarness");
+}
+
+bool ULatencyHarnessSubsystem::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastFlushTime > 5.0) // a client that gets killed still leaves most of its events behind
+	{
+		FlushEvents();
+		LastFlushTime = Now;
+	}
+
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (World && World->IsGameWorld())
+	{
+		if (World->GetNetMode() == NM_Client)
+		{
+			TickClient(World);
+		}
+		else
+		{
+			TickServer(World);
+		}
+	}
+
+	// Clients get a little longer so the server's last shots still reach them.
+	if (Now - StartTime > Duration + (IsRunningDedicatedServer() ? 0.f : 5.f))
+	{
+		FlushEvents();
+		FPlatformMisc::RequestExit(false);
+		return false;
+	}
+	return true;
+}
+
+void ULatencyHarnessSubsystem::TickServer(UWorld* World)
+{
+	// Arm anyone who doesn't have a weapon, copying the first weapon placed in the level.
+	TSubclassOf<AWeapon> WeaponClass;
+	for (TActorIterator<AWeapon> It(World); It; ++It)
+	{
+		WeaponClass = It->GetClass();
+		break;
+	}
+	if (WeaponClass == nullptr) return;
+
+	for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+	{
+		ASpartanCharacter* Character = *It;
+		if (Character->IsWeaponEquipped() || Character->IsEliminated() || Character->GetController() == nullptr || Character->GetCombat() == nullptr) continue;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		if (AWeapon* Weapon = World->SpawnActor<AWeapon>(WeaponClass, Character->GetActorTransform(), SpawnParams))
+		{
+			Character->GetCombat()->EquipWeapon(Weapon);
+		}
+	}
+}
+
+void ULatencyHarnessSubsystem::TickClient(UWorld* World)
+{
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	ASpartanCharacter* Character = PlayerController ? Cast<ASpartanCharacter>(PlayerController->GetPawn()) : nullptr;
+	if (Character == nullptr || Character->GetCombat() == nullptr || !Character->IsWeaponEquipped()) return;
+
+	if (bFireHeld) // release on the frame after the press, like a tap
+	{
+		Character->GetCombat()->FireButtonPressed(false);
+		bFireHeld = false;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastFireTime < FireInterval) return;
+
+	ASpartanCharacter* Target = nullptr;
+	float BestDistSquared = TNumericLimits<float>::Max();
+	for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+	{
+		if (*It == Character || It->IsEliminated()) continue;
+		const float DistSquared = FVector::DistSquared(It->GetActorLocation(), Character->GetActorLocation());
+		if (DistSquared < BestDistSquared)
+		{
+			BestDistSquared = DistSquared;
+			Target = *It;
+		}
+	}
+	if (Target)
+	{
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		PlayerController->SetControlRotation((Target->GetActorLocation() - ViewLocation).Rotation());
+	}
+
+	LastFireTime = Now;
+	Character->GetCombat()->FireButtonPressed(true);
+	bFireHeld = true;
+}
+
+void ULatencyHarnessSubsystem::FlushEvents()
+{
+	if (Events.Num() == 0) return;
+
+	FString Csv;
+	for (const FStageEvent& Event : Events)
+	{
+		Csv += FString::Printf(TEXT("%d,%u,%u,%u,%.6f") LINE_TERMINATOR, (int32)Event.Stage, Event.ShooterId, Event.Key, Event.ObserverId, Event.Time);
+	}
+	FFileHelper::SaveStringToFile(Csv, *OutputPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	Events.Reset();
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/LatencyHistogram.h"
+
+void FLatencyHistogram::Add(double Ms)
+{
+	Ms = FMath::Max(Ms, 0.0);
+	const int32 Bucket = FMath::Min(FMath::FloorToInt32(Ms / BucketMs), NumBuckets);
+	Buckets[Bucket]++;
+	Count++;
+	SumMs += Ms;
+	MaxMs = FMath::Max(MaxMs, Ms);
+}
+
+void FLatencyHistogram::Reset()
+{
+	FMemory::Memzero(Buckets);
+	Count = 0;
+	SumMs = 0.0;
+	MaxMs = 0.0;
+}
+
+double FLatencyHistogram::GetPercentile(double Percentile) const
+{
+	if (Count == 0) return 0.0;
+
+	const uint64 Target = FMath::Max<uint64>(1, FMath::CeilToInt64(Count * FMath::Clamp(Percentile, 0.0, 100.0) / 100.0));
+	uint64 Running = 0;
+	for (int32 Bucket = 0; Bucket <= NumBuckets; ++Bucket)
+	{
+		Running += Buckets[Bucket];
+		if (Running >= Target)
+		{
+			return Bucket == NumBuckets ? MaxMs : (Bucket + 1) * BucketMs;
+		}
+	}
+	return MaxMs;
+}
+
+FString FLatencyHistogram::ToString() const
+{
+	return FString::Printf(TEXT("n=%u avg=%.1fms p50=%.0fms p90=%.0fms p99=%.0fms max=%.1fms"),
+		Count, GetAverage(), GetPercentile(50.0), GetPercentile(90.0), GetPercentile(99.0), MaxMs);
+}
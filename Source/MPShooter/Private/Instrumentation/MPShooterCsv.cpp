@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/MPShooterCsv.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Templates/UniquePtr.h"
+
+namespace MPShooterCsv
+{
+	// Only as much as the header could take, reports like MemReport.csv grow for a whole soak
+	static FString ReadFirstLine(const FString& Path, int32 MaxChars)
+	{
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path, FILEREAD_Silent));
+		if (!Reader) return FString();
+
+		TArray<uint8> Bytes;
+		Bytes.SetNumUninitialized((int32)FMath::Min<int64>(Reader->TotalSize(), MaxChars + 3)); // ASCII, plus a UTF-8 BOM
+		Reader->Serialize(Bytes.GetData(), Bytes.Num());
+		int32 Start = 0;
+		if (Bytes.Num() >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF)
+		{
+			Start = 3;
+		}
+		int32 End = Start;
+		while (End < Bytes.Num() && Bytes[End] != '\r' && Bytes[End] != '\n')
+		{
+			End++;
+		}
+		FString Line;
+		Line.AppendChars(reinterpret_cast<const ANSICHAR*>(Bytes.GetData() + Start), End - Start);
+		return Line;
+	}
+}
+
+FString FMPShooterCsv::GetPath(const TCHAR* FileName)
+{
+	return FPaths::ProfilingDir() / TEXT("MPShooter") / FileName;
+}
+
+FString FMPShooterCsv::Now()
+{
+	return FDateTime::UtcNow().ToIso8601();
+}
+
+bool FMPShooterCsv::Append(const FString& Path, const FString& Header, const FString& Rows)
+{
+	bool bWriteHeader = !FPaths::FileExists(Path);
+	if (!bWriteHeader)
+	{
+		const FString ExistingHeader = MPShooterCsv::ReadFirstLine(Path, Header.Len() + 1);
+		if (ExistingHeader != Header)
+		{
+			const FString OldPath = FPaths::GetPath(Path) / FString::Printf(TEXT("%s.%s.csv"), *FPaths::GetBaseFilename(Path), *FDateTime::UtcNow().ToString(TEXT("%Y%m%d-%H%M%S")));
+			UE_LOG(LogTemp, Display, TEXT("%s has other columns, moved to %s"), *Path, *OldPath);
+			bWriteHeader = IFileManager::Get().Move(*OldPath, *Path, true, true) || !FPaths::FileExists(Path); // someone else may have moved it first
+		}
+	}
+
+	FString Csv;
+	if (bWriteHeader)
+	{
+		Csv += Header + LINE_TERMINATOR;
+	}
+	Csv += Rows;
+	if (!FFileHelper::SaveStringToFile(Csv, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write %s"), *Path);
+		return false;
+	}
+	return true;
+}
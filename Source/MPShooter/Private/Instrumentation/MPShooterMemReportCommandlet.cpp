@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/MPShooterMemReportCommandlet.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "Engine/World.h"
+#include "UObject/Package.h"
+
+UMPShooterMemReportCommandlet::UMPShooterMemReportCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMPShooterMemReportCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	if (FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+		if (MapPackage == nullptr || UWorld::FindWorldInPackage(MapPackage) == nullptr)
+		{
+			UE_LOG(LogTemp, Error, TEXT("MPShooterMemReport: could not load map %s"), *MapName);
+			return 1;
+		}
+	}
+
+	FString OutPath = FMPShooterMemoryReport::GetDefaultCsvPath();
+	FParse::Value(*Params, TEXT("Out="), OutPath);
+
+	TArray<FMPShooterMemoryReport::FRow> Rows;
+	FMPShooterMemoryReport::Gather(Rows);
+	if (!FMPShooterMemoryReport::AppendCsv(OutPath, Rows))
+	{
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("MPShooterMemReport: wrote %d rows to %s"), Rows.Num(), *OutPath);
+	return 0;
+}
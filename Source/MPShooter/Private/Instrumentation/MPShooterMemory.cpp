@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/MPShooterMemory.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Character/SpartanCharacter.h"
+#include "Character/SpartanAnimInstance.h"
+#include "SpartanComponents/CombatComponent.h"
+#include "SpartanComponents/SpartanMovementComponent.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "Weapon/Projectile.h"
+#include "MPShooter/HUD/OverheadWidget.h"
+#include "HUD/SpartanHUD.h"
+#include "Blueprint/UserWidget.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectIterator.h"
+
+LLM_DEFINE_TAG(MPShooter, TEXT("MPShooter"));
+LLM_DEFINE_TAG(MPShooter_Characters, TEXT("Characters"), TEXT("MPShooter"));
+LLM_DEFINE_TAG(MPShooter_Combat, TEXT("Combat"), TEXT("MPShooter"));
+LLM_DEFINE_TAG(MPShooter_Weapons, TEXT("Weapons"), TEXT("MPShooter"));
+LLM_DEFINE_TAG(MPShooter_Projectiles, TEXT("Projectiles"), TEXT("MPShooter"));
+LLM_DEFINE_TAG(MPShooter_HUD, TEXT("HUD"), TEXT("MPShooter"));
+LLM_DEFINE_TAG(MPShooter_Animation, TEXT("Animation"), TEXT("MPShooter"));
+
+namespace MPShooterMemory
+{
+	struct FTrackedClass
+	{
+		UClass* Class;
+		const TCHAR* Tag;
+	};
+
+	static void GetTrackedClasses(TArray<FTrackedClass>& OutClasses)
+	{
+		OutClasses = {
+			{ ASpartanCharacter::StaticClass(), TEXT("Characters") },
+			{ USpartanMovementComponent::StaticClass(), TEXT("Characters") },
+			{ UCombatComponent::StaticClass(), TEXT("Combat") },
+			{ AWeapon::StaticClass(), TEXT("Weapons") },
+			{ AProjectile::StaticClass(), TEXT("Projectiles") },
+			{ ASpartanHUD::StaticClass(), TEXT("HUD") },
+			{ UOverheadWidget::StaticClass(), TEXT("HUD") },
+			{ UUserWidget::StaticClass(), TEXT("HUD") }, // pickup prompt and any Blueprint widgets
+			{ USpartanAnimInstance::StaticClass(), TEXT("Animation") },
+		};
+	}
+
+	static FTSTicker::FDelegateHandle IntervalTickHandle;
+	static float ReportInterval = 0.f;
+
+	static bool TickReport(float DeltaTime)
+	{
+		TArray<FMPShooterMemoryReport::FRow> Rows;
+		FMPShooterMemoryReport::Gather(Rows);
+		FMPShooterMemoryReport::AppendCsv(FMPShooterMemoryReport::GetDefaultCsvPath(), Rows);
+		return true;
+	}
+
+	static void OnReportIntervalChanged(IConsoleVariable* Var)
+	{
+		if (IntervalTickHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(IntervalTickHandle);
+			IntervalTickHandle.Reset();
+		}
+		if (ReportInterval > 0.f)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.MemReportInterval %.0f: every row walks all UObjects on the game thread and hitches, use it for soak runs only"), ReportInterval);
+			IntervalTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickReport), ReportInterval);
+		}
+	}
+}
+
+static FAutoConsoleVariableRef CVarMemReportInterval(
+	TEXT("MPShooter.MemReportInterval"),
+	MPShooterMemory::ReportInterval,
+	TEXT("Seconds between memory report rows appended to the default CSV (0 = off). For soak runs only: each row hitches the game thread (every UObject is walked)."),
+	FConsoleVariableDelegate::CreateStatic(&MPShooterMemory::OnReportIntervalChanged));
+
+static FAutoConsoleCommand CmdMemReport(
+	TEXT("MPShooter.MemReport"),
+	TEXT("Writes LLM tag totals and per-class instance counts/bytes for MPShooter classes to CSV. Optional argument: output path. Run with -llm for tag totals."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString Path = Args.Num() > 0 ? Args[0] : FMPShooterMemoryReport::GetDefaultCsvPath();
+		TArray<FMPShooterMemoryReport::FRow> Rows;
+		FMPShooterMemoryReport::Gather(Rows);
+		for (const FMPShooterMemoryReport::FRow& Row : Rows)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%-5s %-12s %-32s %6d %10.2f KB"), *Row.Kind, *Row.Tag, *Row.Name, Row.Count, Row.Bytes / 1024.0);
+		}
+		if (FMPShooterMemoryReport::AppendCsv(Path, Rows))
+		{
+			UE_LOG(LogTemp, Display, TEXT("MemReport: wrote %d rows to %s"), Rows.Num(), *Path);
+		}
+	}));
+
+void FMPShooterMemoryReport::Gather(TArray<FRow>& OutRows)
+{
+	OutRows.Reset();
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& LLM = FLowLevelMemTracker::Get();
+	if (LLM.IsEnabled())
+	{
+		const FLLMTagDeclaration* Tags[] = {
+			&LLMTagDeclaration_MPShooter,
+			&LLMTagDeclaration_MPShooter_Characters,
+			&LLMTagDeclaration_MPShooter_Combat,
+			&LLMTagDeclaration_MPShooter_Weapons,
+			&LLMTagDeclaration_MPShooter_Projectiles,
+			&LLMTagDeclaration_MPShooter_HUD,
+			&LLMTagDeclaration_MPShooter_Animation,
+		};
+		for (const FLLMTagDeclaration* Tag : Tags)
+		{
+			FRow& Row = OutRows.AddDefaulted_GetRef();
+			Row.Kind = TEXT("Tag");
+			Row.Name = Tag->GetUniqueName().ToString();
+			Row.Tag = Row.Name;
+			Row.Bytes = LLM.GetTagAmountForTracker(ELLMTracker::Default, Tag->GetUniqueName(), ELLMTagSet::None);
+		}
+	}
+#endif
+
+	// Same measure as 'obj list': the object's own memory plus what it reports as exclusive resources.
+	TArray<MPShooterMemory::FTrackedClass> Classes;
+	MPShooterMemory::GetTrackedClasses(Classes);
+	const int32 FirstClassRow = OutRows.Num();
+	for (const MPShooterMemory::FTrackedClass& Tracked : Classes)
+	{
+		FRow& Row = OutRows.AddDefaulted_GetRef();
+		Row.Kind = TEXT("Class");
+		Row.Name = Tracked.Class->GetName();
+		Row.Tag = Tracked.Tag;
+	}
+	for (TObjectIterator<UObject> It(RF_ClassDefaultObject | RF_ArchetypeObject); It; ++It)
+	{
+		for (int32 Index = 0; Index < Classes.Num(); ++Index)
+		{
+			if (!It->IsA(Classes[Index].Class)) continue;
+			FArchiveCountMem CountMem(*It);
+			FRow& Row = OutRows[FirstClassRow + Index];
+			Row.Count++;
+			Row.Bytes += CountMem.GetMax() + It->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
+}
+
+bool FMPShooterMemoryReport::AppendCsv(const FString& Path, const TArray<FRow>& Rows)
+{
+	FString Csv;
+	const FString Timestamp = FMPShooterCsv::Now();
+	for (const FRow& Row : Rows)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%s,%s,%d,%lld") LINE_TERMINATOR, *Timestamp, *Row.Kind, *Row.Tag, *Row.Name, Row.Count, Row.Bytes);
+	}
+	return FMPShooterCsv::Append(Path, TEXT("Timestamp,Kind,Tag,Name,Count,Bytes"), Csv);
+}
+
+FString FMPShooterMemoryReport::GetDefaultCsvPath()
+{
+	return FMPShooterCsv::GetPath(TEXT("MemReport.csv"));
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/MPShooterStats.h"
+
+DEFINE_STAT(STAT_MPShooter_CharacterTick);
+DEFINE_STAT(STAT_MPShooter_AnimUpdate);
+DEFINE_STAT(STAT_MPShooter_ProjectileSim);
+DEFINE_STAT(STAT_MPShooter_Effects);
+DEFINE_STAT(STAT_MPShooter_HUD);
+
+bool FMPShooterPerfCounters::bEnabled = false;
+uint64 FMPShooterPerfCounters::Cycles[(int32)EMPShooterPerfScope::Count] = {};
+uint32 FMPShooterPerfCounters::Calls[(int32)EMPShooterPerfScope::Count] = {};
+
+void FMPShooterPerfCounters::Reset()
+{
+	FMemory::Memzero(Cycles);
+	FMemory::Memzero(Calls);
+}
+
+const TCHAR* FMPShooterPerfCounters::GetName(EMPShooterPerfScope Scope)
+{
+	switch (Scope)
+	{
+	case EMPShooterPerfScope::CharacterTick:
+		return TEXT("CharacterTick");
+	case EMPShooterPerfScope::AnimUpdate:
+		return TEXT("AnimUpdate");
+	case EMPShooterPerfScope::ProjectileSim:
+		return TEXT("ProjectileSim");
+	case EMPShooterPerfScope::Effects:
+		return TEXT("Effects");
+	case EMPShooterPerfScope::HUD:
+		return TEXT("HUD");
+	}
+	return TEXT("Unknown");
+}
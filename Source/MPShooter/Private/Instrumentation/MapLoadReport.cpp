@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "UObject/UObjectGlobals.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+static TAutoConsoleVariable<int32> CVarMapLoadReport(
+	TEXT("MPShooter.MapLoadReport"),
+	1,
+	TEXT("Log every map load's time (persistent level, then until World Partition streaming settles) and resident memory, and append it to Profiling/MPShooter/MapLoad.csv."));
+
+// Load time and resident memory per map, on every process, so a World Partition map can be compared against the single level one.
+namespace MapLoadReport
+{
+	static FString MapName;
+	static double LoadStartTime = 0.0;
+	static double PersistentLoadedTime = 0.0;
+	static TWeakObjectPtr<UWorld> LoadedWorld;
+	static FTSTicker::FDelegateHandle StreamingTickHandle;
+
+	static void Write(UWorld* World, bool bPartitioned)
+	{
+		const double Now = FPlatformTime::Seconds();
+		const double LoadSeconds = PersistentLoadedTime - LoadStartTime;
+		const double StreamSeconds = Now - PersistentLoadedTime;
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		const double ResidentMB = MemoryStats.UsedPhysical / (1024.0 * 1024.0);
+		const double PeakMB = MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0);
+		const TCHAR* NetMode = World->GetNetMode() == NM_Client ? TEXT("Client") : World->GetNetMode() == NM_DedicatedServer ? TEXT("DedicatedServer") : TEXT("ListenServer");
+
+		UE_LOG(LogTemp, Display, TEXT("Map load %s (%s%s): persistent level %.2f s, streaming %.2f s, resident %.0f MB (peak %.0f MB)"),
+			*MapName, NetMode, bPartitioned ? TEXT(", World Partition") : TEXT(""), LoadSeconds, StreamSeconds, ResidentMB, PeakMB);
+
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("MapLoad.csv")), TEXT("Time,Map,NetMode,WorldPartition,LoadSeconds,StreamSeconds,ResidentMB,PeakResidentMB"),
+			FString::Printf(TEXT("%s,%s,%s,%d,%.3f,%.3f,%.1f,%.1f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *MapName, NetMode,
+			bPartitioned ? 1 : 0, LoadSeconds, StreamSeconds, ResidentMB, PeakMB));
+	}
+
+	static bool TickStreaming(float DeltaTime)
+	{
+		UWorld* World = LoadedWorld.Get();
+		if (World == nullptr)
+		{
+			StreamingTickHandle.Reset();
+			return false;
+		}
+		const UWorldPartitionSubsystem* WorldPartitionSubsystem = World->GetSubsystem<UWorldPartitionSubsystem>();
+		if (WorldPartitionSubsystem && !WorldPartitionSubsystem->IsStreamingCompleted()) return true;
+
+		Write(World, true);
+		StreamingTickHandle.Reset();
+		return false;
+	}
+
+	static void OnPreLoadMap(const FString& InMapName)
+	{
+		MapName = InMapName;
+		LoadStartTime = FPlatformTime::Seconds();
+	}
+
+	static void OnPostLoadMap(UWorld* World)
+	{
+		if (World == nullptr || LoadStartTime == 0.0 || CVarMapLoadReport.GetValueOnGameThread() == 0) return;
+		PersistentLoadedTime = FPlatformTime::Seconds();
+		if (StreamingTickHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(StreamingTickHandle);
+			StreamingTickHandle.Reset();
+		}
+
+		if (World->IsPartitionedWorld())
+		{
+			// The persistent level is mostly empty, the cells around the streaming sources are the real load
+			LoadedWorld = World;
+			StreamingTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickStreaming), 0.1f);
+		}
+		else
+		{
+			Write(World, false);
+		}
+		LoadStartTime = 0.0;
+	}
+
+	static FDelayedAutoRegisterHelper RegisterDelegates(EDelayedRegisterRunPhase::EndOfEngineInit, []()
+	{
+		FCoreUObjectDelegates::PreLoadMap.AddStatic(&OnPreLoadMap);
+		FCoreUObjectDelegates::PostLoadMapWithWorld.AddStatic(&OnPostLoadMap);
+	});
+}
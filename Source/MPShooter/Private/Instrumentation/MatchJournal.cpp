@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/MatchJournal.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "MPShooter/GameMode/GM_Lobby.h"
+
+static TAutoConsoleVariable<int32> CVarMatchJournal(
+	TEXT("MPShooter.MatchJournal"),
+	0,
+	TEXT("Server: write a binary journal of fire/hit/equip/aim events for every match to Saved/MatchJournals."));
+
+bool FMatchJournal::bRecording = false;
+FMatchJournal::FChunk* FMatchJournal::CurrentChunk = nullptr;
+IFileHandle* FMatchJournal::FileHandle = nullptr;
+UE::Tasks::FPipe* FMatchJournal::WritePipe = nullptr;
+
+bool FMatchJournal::Start(const FString& Path, const FString& MapName)
+{
+	check(IsInGameThread());
+	Stop();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+	FileHandle = PlatformFile.OpenWrite(*Path);
+	if (FileHandle == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MatchJournal: could not open %s"), *Path);
+		return false;
+	}
+
+	FMatchJournalHeader Header;
+	Header.StartUtcTicks = FDateTime::UtcNow().GetTicks();
+	FCString::Strncpy(Header.MapName, *MapName, UE_ARRAY_COUNT(Header.MapName));
+	FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+	WritePipe = new UE::Tasks::FPipe(TEXT("MatchJournalWrite"));
+	bRecording = true;
+	UE_LOG(LogTemp, Log, TEXT("MatchJournal: recording to %s"), *Path);
+	return true;
+}
+
+void FMatchJournal::Stop()
+{
+	check(IsInGameThread());
+	if (!bRecording) return;
+	Flush(); // nothing is left behind, the game thread holds the only partial chunk
+
+	bRecording = false;
+	WritePipe->WaitUntilEmpty();
+	delete WritePipe;
+	WritePipe = nullptr;
+	delete FileHandle; // flushes and closes
+	FileHandle = nullptr;
+}
+
+void FMatchJournal::Record(EMatchJournalEvent Type, float Time, uint32 PlayerId, const FVector& Location, float Value, uint32 Target, uint16 Aux)
+{
+	if (!bRecording) return;
+	if (!ensureMsgf(IsInGameThread(), TEXT("MatchJournal: events are recorded from the game thread only"))) return;
+
+	if (CurrentChunk == nullptr)
+	{
+		CurrentChunk = new FChunk();
+	}
+
+	FMatchJournalRecord& Out = CurrentChunk->Records[CurrentChunk->Num++];
+	Out.Time = Time;
+	Out.PlayerId = PlayerId;
+	Out.Target = Target;
+	Out.Value = Value;
+	Out.Location = FVector3f(Location);
+	Out.Aux = Aux;
+	Out.Type = (uint8)Type;
+	Out.Pad = 0;
+
+	if (CurrentChunk->Num == RecordsPerChunk)
+	{
+		Submit(CurrentChunk);
+		CurrentChunk = nullptr;
+	}
+}
+
+void FMatchJournal::Flush()
+{
+	check(IsInGameThread());
+	if (CurrentChunk && CurrentChunk->Num > 0)
+	{
+		Submit(CurrentChunk);
+		CurrentChunk = nullptr;
+	}
+}
+
+void FMatchJournal::Submit(FChunk* Chunk)
+{
+	if (!bRecording)
+	{
+		delete Chunk;
+		return;
+	}
+	WritePipe->Launch(TEXT("MatchJournalWriteChunk"), [Chunk, Handle = FileHandle]()
+	{
+		Handle->Write(reinterpret_cast<const uint8*>(Chunk->Records), Chunk->Num * sizeof(FMatchJournalRecord));
+		delete Chunk;
+	});
+}
+
+uint32 FMatchJournal::GetPlayerId(const AActor* PawnOrController)
+{
+	const APlayerState* PlayerState = nullptr;
+	if (const APawn* Pawn = Cast<APawn>(PawnOrController))
+	{
+		PlayerState = Pawn->GetPlayerState();
+	}
+	else if (const AController* Controller = Cast<AController>(PawnOrController))
+	{
+		PlayerState = Controller->PlayerState;
+	}
+	return PlayerState ? (uint32)PlayerState->GetPlayerId() : 0;
+}
+
+FString FMatchJournal::GetDefaultDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("MatchJournals");
+}
+
+bool UMatchJournalSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UMatchJournalSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (CVarMatchJournal.GetValueOnGameThread() == 0) return;
+	if (InWorld.GetNetMode() != NM_DedicatedServer && InWorld.GetNetMode() != NM_ListenServer) return;
+	if (InWorld.IsPlayingReplay() || Cast<AGM_Lobby>(InWorld.GetAuthGameMode())) return;
+
+	const FString MapName = InWorld.GetMapName();
+	const FString Path = FMatchJournal::GetDefaultDirectory() / FString::Printf(TEXT("%s_%s.mpj"), *MapName, *FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")));
+	if (FMatchJournal::Start(Path, MapName))
+	{
+		bOwnsJournal = true;
+		FMatchJournal::Record(EMatchJournalEvent::Travel, InWorld.GetTimeSeconds(), 0, FVector::ZeroVector, 0.f, 0, 1);
+		FlushTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UMatchJournalSubsystem::TickFlush), 0.25f);
+	}
+}
+
+void UMatchJournalSubsystem::Deinitialize()
+{
+	if (FlushTickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(FlushTickHandle);
+		FlushTickHandle.Reset();
+	}
+	if (bOwnsJournal)
+	{
+		FMatchJournal::Record(EMatchJournalEvent::Travel, GetWorld()->GetTimeSeconds(), 0, FVector::ZeroVector, 0.f, 0, 0);
+		FMatchJournal::Stop();
+		bOwnsJournal = false;
+	}
+
+	Super::Deinitialize();
+}
+
+bool UMatchJournalSubsystem::TickFlush(float DeltaTime)
+{
+	FMatchJournal::Flush(); // written a few times a second instead of once per 2048
+	return true;
+}
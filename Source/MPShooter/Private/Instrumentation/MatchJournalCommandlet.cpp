@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/MatchJournalCommandlet.h"
+#include "Instrumentation/MatchJournal.h"
+#include "Instrumentation/LatencyHistogram.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace MatchJournalAnalysis
+{
+	struct FPlayerStats
+	{
+		int32 Shots = 0;
+		int32 Rejected = 0;
+		int32 PlayerHits = 0;
+		int32 WorldHits = 0;
+		int32 Kills = 0;
+		int32 Deaths = 0;
+		double Damage = 0.0;
+		int32 Equips = 0;
+		int32 AimToggles = 0;
+	};
+
+	static FString FindNewestJournal()
+	{
+		TArray<FString> Files;
+		const FString Directory = FMatchJournal::GetDefaultDirectory();
+		IFileManager::Get().FindFiles(Files, *(Directory / TEXT("*.mpj")), true, false);
+		FString Newest;
+		FDateTime NewestTime = FDateTime::MinValue();
+		for (const FString& File : Files)
+		{
+			const FString Path = Directory / File;
+			const FDateTime Time = IFileManager::Get().GetTimeStamp(*Path);
+			if (Time > NewestTime)
+			{
+				NewestTime = Time;
+				Newest = Path;
+			}
+		}
+		return Newest;
+	}
+}
+
+UMatchJournalCommandlet::UMatchJournalCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UMatchJournalCommandlet::Main(const FString& Params)
+{
+	using namespace MatchJournalAnalysis;
+
+	FString Path;
+	if (!FParse::Value(*Params, TEXT("File="), Path))
+	{
+		Path = FindNewestJournal();
+	}
+	TUniquePtr<IMappedFileHandle> MappedFile(Path.IsEmpty() ? nullptr : FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() < (int64)sizeof(FMatchJournalHeader))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MatchJournal: could not open journal '%s'"), *Path);
+		return 1;
+	}
+	TUniquePtr<IMappedFileRegion> Region(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!Region.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("MatchJournal: could not map %s"), *Path);
+		return 1;
+	}
+
+	const uint8* Data = Region->GetMappedPtr();
+	const FMatchJournalHeader& Header = *reinterpret_cast<const FMatchJournalHeader*>(Data);
+	if (Header.Magic != FMatchJournalHeader::MagicValue || Header.Version != FMatchJournalHeader::CurrentVersion || Header.RecordSize != sizeof(FMatchJournalRecord))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MatchJournal: %s is not a version %u journal"), *Path, FMatchJournalHeader::CurrentVersion);
+		return 1;
+	}
+
+	const int64 NumRecords = (Region->GetMappedSize() - sizeof(FMatchJournalHeader)) / sizeof(FMatchJournalRecord); // a torn last record is ignored
+	const FMatchJournalRecord* Records = reinterpret_cast<const FMatchJournalRecord*>(Data + sizeof(FMatchJournalHeader));
+
+	TMap<uint32, FPlayerStats> Players;
+	int32 EventCounts[(int32)EMatchJournalEvent::Count] = {};
+	FLatencyHistogram ShooterPing;
+	FLatencyHistogram ProjectileFlight;
+	TMap<int32, int32> ShotsPerSecond;
+	float FirstTime = TNumericLimits<float>::Max();
+	float LastTime = 0.f;
+
+	for (int64 Index = 0; Index < NumRecords; ++Index)
+	{
+		const FMatchJournalRecord& Record = Records[Index];
+		if (Record.Type >= (uint8)EMatchJournalEvent::Count) continue;
+		EventCounts[Record.Type]++;
+		FirstTime = FMath::Min(FirstTime, Record.Time);
+		LastTime = FMath::Max(LastTime, Record.Time);
+
+		switch ((EMatchJournalEvent)Record.Type)
+		{
+		case EMatchJournalEvent::Fire:
+			Players.FindOrAdd(Record.PlayerId).Shots++;
+			ShooterPing.Add(Record.Value);
+			ShotsPerSecond.FindOrAdd(FMath::FloorToInt32(Record.Time))++;
+			break;
+		case EMatchJournalEvent::FireRejected:
+			Players.FindOrAdd(Record.PlayerId).Rejected++;
+			break;
+		case EMatchJournalEvent::Hit:
+		{
+			FPlayerStats& Shooter = Players.FindOrAdd(Record.PlayerId);
+			if (Record.Target != 0)
+			{
+				Shooter.PlayerHits++;
+				Shooter.Damage += Record.Value;
+			}
+			else
+			{
+				Shooter.WorldHits++;
+			}
+			ProjectileFlight.Add(Record.Aux);
+			break;
+		}
+		case EMatchJournalEvent::Kill:
+			Players.FindOrAdd(Record.PlayerId).Kills++;
+			Players.FindOrAdd(Record.Target).Deaths++;
+			break;
+		case EMatchJournalEvent::Equip:
+			Players.FindOrAdd(Record.PlayerId).Equips++;
+			break;
+		case EMatchJournalEvent::AimStart:
+		case EMatchJournalEvent::AimStop:
+			Players.FindOrAdd(Record.PlayerId).AimToggles++;
+			break;
+		default:
+			break;
+		}
+	}
+
+	const float Duration = NumRecords > 0 ? FMath::Max(LastTime - FirstTime, 1.f) : 0.f;
+	int32 PeakShotsPerSecond = 0;
+	for (const TPair<int32, int32>& Second : ShotsPerSecond)
+	{
+		PeakShotsPerSecond = FMath::Max(PeakShotsPerSecond, Second.Value);
+	}
+	const int32 Shots = EventCounts[(int32)EMatchJournalEvent::Fire];
+	const int32 Rejected = EventCounts[(int32)EMatchJournalEvent::FireRejected];
+	int32 PlayerHits = 0;
+	for (const TPair<uint32, FPlayerStats>& Player : Players)
+	{
+		PlayerHits += Player.Value.PlayerHits;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("MatchJournal: %s (map %s, started %s UTC)"), *Path, Header.MapName, *FDateTime(Header.StartUtcTicks).ToString());
+	UE_LOG(LogTemp, Display, TEXT("  %lld records over %.1f s"), NumRecords, Duration);
+	UE_LOG(LogTemp, Display, TEXT("  shots %d (%.2f/s, peak %d/s), rejected %d (%.1f%%), player hits %d (hit rate %.1f%%), kills %d"),
+		Shots, Duration > 0.f ? Shots / Duration : 0.f, PeakShotsPerSecond, Rejected, Shots > 0 ? 100.f * Rejected / Shots : 0.f,
+		PlayerHits, Shots - Rejected > 0 ? 100.f * PlayerHits / (Shots - Rejected) : 0.f, EventCounts[(int32)EMatchJournalEvent::Kill]);
+	UE_LOG(LogTemp, Display, TEXT("  equips %d, aim toggles %d, travels %d"), EventCounts[(int32)EMatchJournalEvent::Equip],
+		EventCounts[(int32)EMatchJournalEvent::AimStart] + EventCounts[(int32)EMatchJournalEvent::AimStop], EventCounts[(int32)EMatchJournalEvent::Travel]);
+	UE_LOG(LogTemp, Display, TEXT("  shooter ping ms: %s"), *ShooterPing.ToString());
+	UE_LOG(LogTemp, Display, TEXT("  projectile flight ms: %s"), *ProjectileFlight.ToString());
+
+	FString Csv = TEXT("PlayerId,Shots,Rejected,PlayerHits,WorldHits,HitRate,Damage,Kills,Deaths,Equips,AimToggles\n");
+	Players.KeySort(TLess<uint32>());
+	for (const TPair<uint32, FPlayerStats>& Player : Players)
+	{
+		if (Player.Key == 0) continue;
+		const FPlayerStats& Stats = Player.Value;
+		const int32 Accepted = Stats.Shots - Stats.Rejected;
+		const float HitRate = Accepted > 0 ? (float)Stats.PlayerHits / Accepted : 0.f;
+		UE_LOG(LogTemp, Display, TEXT("  player %u: shots %d, rejected %d, hits %d (%.1f%%), damage %.0f, K/D %d/%d"),
+			Player.Key, Stats.Shots, Stats.Rejected, Stats.PlayerHits, HitRate * 100.f, Stats.Damage, Stats.Kills, Stats.Deaths);
+		Csv += FString::Printf(TEXT("%u,%d,%d,%d,%d,%.4f,%.0f,%d,%d,%d,%d\n"), Player.Key, Stats.Shots, Stats.Rejected, Stats.PlayerHits, Stats.WorldHits,
+			HitRate, Stats.Damage, Stats.Kills, Stats.Deaths, Stats.Equips, Stats.AimToggles);
+	}
+
+	FString CsvPath;
+	if (FParse::Value(*Params, TEXT("CSV="), CsvPath))
+	{
+		FFileHelper::SaveStringToFile(Csv, *CsvPath);
+	}
+	return 0;
+}
@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/SpartanCharacter.h"
+#include "MPShooter/HUD/OverheadWidget.h"
+#include "Components/WidgetComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "RenderCore.h"
+
+// Nameplates before and after the HUD pass, on the same client and the same characters: first the HUD draws them, then the HUD's
+// are switched off (MPShooter.HUDNameplates 0) and every character gets a screen space widget component with the old overhead
+// widget, the way they used to. Run it on a rendering client with the characters around (Scripts/RunNameplateBench.sh, 63 bots).
+// It waits for the characters to show up, so it can go in a client's -ExecCmds before it has even connected.
+namespace NameplateBench
+{
+	enum class EPhase : uint8
+	{
+		Waiting,
+		Hud,
+		Widgets
+	};
+
+	struct FSession
+	{
+		EPhase Phase = EPhase::Waiting;
+		FString Label;
+		TSoftClassPtr<UUserWidget> WidgetClass;
+		int32 MinCharacters = 0;
+		float Duration = 0.f;
+		float WaitLeft = 0.f;
+		float Elapsed = 0.f;
+		int32 Frames = 0;
+		int32 Characters = 0;
+		double GameThreadMsSum = 0.0;
+		double RenderThreadMsSum = 0.0;
+		double HudMsSum = 0.0;
+		TArray<TWeakObjectPtr<UWidgetComponent>> Widgets;
+	};
+
+	static FSession Session;
+	static FTSTicker::FDelegateHandle TickHandle;
+
+	static UWorld* FindGameWorld()
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World() && Context.World()->HasBegunPlay())
+			{
+				return Context.World();
+			}
+		}
+		return nullptr;
+	}
+
+	static void SetHudNameplates(bool bEnabled)
+	{
+		IConsoleManager::Get().FindConsoleVariable(TEXT("MPShooter.HUDNameplates"))->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+	static void RemoveWidgets()
+	{
+		for (const TWeakObjectPtr<UWidgetComponent>& Widget : Session.Widgets)
+		{
+			if (Widget.IsValid())
+			{
+				Widget->DestroyComponent();
+			}
+		}
+		Session.Widgets.Reset();
+	}
+
+	static void WriteRow(const TCHAR* Path)
+	{
+		const int32 Frames = FMath::Max(Session.Frames, 1);
+		const double GameThreadMs = Session.GameThreadMsSum / Frames;
+		const double RenderThreadMs = Session.RenderThreadMsSum / Frames;
+		const double HudMs = Session.HudMsSum / Frames;
+
+		UE_LOG(LogTemp, Display, TEXT("Nameplate bench [%s] %s, %d characters over %d frames: game thread %.3f ms, render thread %.3f ms, HUD nameplates %.4f ms"),
+			*Session.Label, Path, Session.Characters, Session.Frames, GameThreadMs, RenderThreadMs, HudMs);
+
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("Nameplates.csv")), TEXT("Time,Label,Path,Characters,Frames,GameThreadMs,RenderThreadMs,HudNameplateMs"),
+			FString::Printf(TEXT("%s,%s,%s,%d,%d,%.4f,%.4f,%.4f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Session.Label, Path,
+			Session.Characters, Session.Frames, GameThreadMs, RenderThreadMs, HudMs));
+	}
+
+	static void Finish()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+		FMPShooterPerfCounters::bEnabled = false;
+		RemoveWidgets();
+		SetHudNameplates(true);
+	}
+
+	static void StartPhase(EPhase Phase)
+	{
+		Session.Phase = Phase;
+		Session.Elapsed = 0.f;
+		Session.Frames = 0;
+		Session.GameThreadMsSum = 0.0;
+		Session.RenderThreadMsSum = 0.0;
+		Session.HudMsSum = 0.0;
+		FMPShooterPerfCounters::Reset();
+		FMPShooterPerfCounters::bEnabled = true;
+	}
+
+	static bool AddWidgets(UWorld* World)
+	{
+		UClass* WidgetClass = Session.WidgetClass.IsNull() ? nullptr : Session.WidgetClass.LoadSynchronous();
+		if (WidgetClass == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchNameplates: no widget class '%s', only the HUD path was measured"), *Session.WidgetClass.ToString());
+			return false;
+		}
+		for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+		{
+			UWidgetComponent* Widget = NewObject<UWidgetComponent>(*It);
+			Widget->SetWidgetSpace(EWidgetSpace::Screen);
+			Widget->SetWidgetClass(WidgetClass);
+			Widget->SetDrawAtDesiredSize(true);
+			Widget->SetupAttachment(It->GetRootComponent());
+			Widget->SetRelativeLocation(FVector(0.f, 0.f, It->GetSimpleCollisionHalfHeight() + 30.f));
+			Widget->RegisterComponent();
+			Widget->InitWidget();
+			if (UOverheadWidget* Overhead = Cast<UOverheadWidget>(Widget->GetUserWidgetObject()))
+			{
+				Overhead->SetDisplayText(It->GetPlayerState() ? It->GetPlayerState()->GetPlayerName() : It->GetName());
+			}
+			Session.Widgets.Add(Widget);
+		}
+		SetHudNameplates(false);
+		return true;
+	}
+
+	static bool Tick(float DeltaTime)
+	{
+		UWorld* World = FindGameWorld();
+		if (Session.Phase == EPhase::Waiting)
+		{
+			int32 Characters = 0;
+			for (TActorIterator<ASpartanCharacter> It(World); World && It; ++It)
+			{
+				Characters++;
+			}
+			Session.WaitLeft -= DeltaTime;
+			if (Characters < Session.MinCharacters)
+			{
+				if (Session.WaitLeft <= 0.f)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchNameplates: only %d of %d characters showed up"), Characters, Session.MinCharacters);
+					Finish();
+					return false;
+				}
+				return true;
+			}
+			Session.Characters = Characters;
+			StartPhase(EPhase::Hud);
+			return true;
+		}
+		if (World == nullptr)
+		{
+			Finish();
+			return false;
+		}
+
+		Session.GameThreadMsSum += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		Session.RenderThreadMsSum += FPlatformTime::ToMilliseconds(GRenderThreadTime);
+		Session.HudMsSum += FPlatformTime::ToMilliseconds64(FMPShooterPerfCounters::Cycles[(int32)EMPShooterPerfScope::HUD]);
+		Session.Frames++;
+		Session.Elapsed += DeltaTime;
+		FMPShooterPerfCounters::Reset();
+		if (Session.Elapsed < Session.Duration)
+		{
+			return true;
+		}
+
+		if (Session.Phase == EPhase::Hud)
+		{
+			WriteRow(TEXT("HUD"));
+			if (AddWidgets(World))
+			{
+				StartPhase(EPhase::Widgets);
+				return true;
+			}
+		}
+		else
+		{
+			WriteRow(TEXT("WidgetComponents"));
+		}
+		Finish();
+		return false;
+	}
+}
+
+static FAutoConsoleCommand CmdBenchNameplates(
+	TEXT("MPShooter.BenchNameplates"),
+	TEXT("Client: once N characters are around (default 64), measures game / render thread time for S seconds (default 20) with the HUD's nameplates, then again with a widget component per character. Args: S N WidgetClassPath (e.g. /Game/.../WBP_Overhead.WBP_Overhead_C, without it only the HUD is measured) label. Appends to Profiling/MPShooter/Nameplates.csv."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace NameplateBench;
+		if (TickHandle.IsValid())
+		{
+			Finish();
+		}
+
+		Session = FSession();
+		Session.Duration = Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 1.f) : 20.f;
+		Session.MinCharacters = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 64;
+		Session.WidgetClass = TSoftClassPtr<UUserWidget>(FSoftObjectPath(Args.Num() > 2 ? Args[2] : FString())); // the overhead widget blueprint characters used to carry
+		Session.Label = Args.Num() > 3 ? Args[3] : TEXT("");
+		Session.WaitLeft = 180.f;
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick));
+	}));
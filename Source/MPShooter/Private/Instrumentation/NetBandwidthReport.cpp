@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/SpartanCharacter.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Networking/MPShooterIris.h"
+
+// Character net rate vs bandwidth vs how smooth simulated proxies look. Run it on the server for bandwidth and on a client for the
+// snapshot buffer's side, with the same MPShooter.CharacterNetRate / MPShooter.AimSnapshots settings (Scripts/CompareCharacterNetRate.sh).
+// The measurement starts once the game is under way: on the server when enough clients are connected, on a client once its
+// connection to the server is open in the game map. So the command can go in -ExecCmds, which run before any of that.
+namespace NetBandwidthReport
+{
+	static constexpr int32 MaxWaitSeconds = 120;
+
+	struct FSession
+	{
+		TWeakObjectPtr<UWorld> World; // set when the measurement starts
+		FString Label;
+		int32 MinConnections = 1;
+		int32 WaitSecondsLeft = MaxWaitSeconds;
+		int32 SecondsLeft = 0;
+		int32 Seconds = 0;
+		uint64 OutBytes = 0;
+		uint64 InBytes = 0;
+		int32 MaxConnections = 0;
+		double SnapshotDelaySum = 0.0;
+		int32 ProxySamples = 0;
+		int32 ExtrapolatedSamples = 0;
+	};
+
+	static FSession Session;
+	static FTSTicker::FDelegateHandle TickHandle;
+
+	static void Stop()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+
+	// A client's world is replaced when it connects, so the world is looked up until the measurement starts
+	static UWorld* FindStartedWorld()
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			UWorld* World = Context.World();
+			if ((Context.WorldType != EWorldType::Game && Context.WorldType != EWorldType::PIE) || World == nullptr || !World->HasBegunPlay()) continue;
+
+			const UNetDriver* NetDriver = World->GetNetDriver();
+			if (NetDriver == nullptr) continue;
+			if (World->GetNetMode() == NM_Client)
+			{
+				if (NetDriver->ServerConnection && NetDriver->ServerConnection->GetConnectionState() == USOCK_Open)
+				{
+					return World;
+				}
+			}
+			else if (NetDriver->ClientConnections.Num() >= Session.MinConnections)
+			{
+				return World;
+			}
+		}
+		return nullptr;
+	}
+
+	static void Finish()
+	{
+		Stop();
+
+		UWorld* World = Session.World.Get();
+		float CharacterNetRate = 0.f;
+		if (World)
+		{
+			for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+			{
+				CharacterNetRate = It->GetNetUpdateFrequency(); // only meaningful on the server
+				break;
+			}
+		}
+		const int32 AimSnapshots = IConsoleManager::Get().FindConsoleVariable(TEXT("MPShooter.AimSnapshots"))->GetInt();
+		const int32 Seconds = FMath::Max(Session.Seconds, 1);
+		const double OutKBps = Session.OutBytes / 1024.0 / Seconds;
+		const double InKBps = Session.InBytes / 1024.0 / Seconds;
+		const double PerConnectionKBps = OutKBps / FMath::Max(Session.MaxConnections, 1);
+		const double DelayMs = Session.ProxySamples > 0 ? Session.SnapshotDelaySum * 1000.0 / Session.ProxySamples : 0.0;
+		const double ExtrapolatedPct = Session.ProxySamples > 0 ? 100.0 * Session.ExtrapolatedSamples / Session.ProxySamples : 0.0;
+		const TCHAR* NetMode = World && World->GetNetMode() == NM_Client ? TEXT("Client") : TEXT("Server");
+		const bool bIris = MPShooterIris::IsUsingIris(World);
+
+		UE_LOG(LogTemp, Display, TEXT("Net bandwidth [%s] %s%s over %d s: character rate %.0f Hz, aim snapshots %d, out %.2f KB/s (%.2f per connection, %d connections), in %.2f KB/s, snapshot delay %.1f ms, extrapolated %.1f%%"),
+			*Session.Label, NetMode, bIris ? TEXT(" (Iris)") : TEXT(""), Seconds, CharacterNetRate, AimSnapshots, OutKBps, PerConnectionKBps, Session.MaxConnections, InKBps, DelayMs, ExtrapolatedPct);
+
+		// Files started before the Iris column are moved aside rather than getting rows one column wider than their header
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("NetBandwidth.csv")), TEXT("Time,Label,NetMode,Iris,Seconds,CharacterNetRate,AimSnapshots,Connections,OutKBps,OutKBpsPerConnection,InKBps,SnapshotDelayMs,ExtrapolatedPct"),
+			FString::Printf(TEXT("%s,%s,%s,%d,%d,%.0f,%d,%d,%.3f,%.3f,%.3f,%.2f,%.2f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Session.Label, NetMode,
+			bIris ? 1 : 0, Seconds, CharacterNetRate, AimSnapshots, Session.MaxConnections, OutKBps, PerConnectionKBps, InKBps, DelayMs, ExtrapolatedPct));
+	}
+
+	static bool Tick(float DeltaTime)
+	{
+		if (!Session.World.IsValid() && Session.Seconds == 0)
+		{
+			// Not started yet: joining (map load, the initial bunches for everything) isn't what we're measuring
+			Session.World = FindStartedWorld();
+			if (!Session.World.IsValid() && --Session.WaitSecondsLeft <= 0)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("MPShooter.NetBandwidth: not connected (or fewer than %d clients) after %d s, giving up"), Session.MinConnections, MaxWaitSeconds);
+				Stop();
+				return false;
+			}
+			return true; // the byte counters below cover the second that starts now
+		}
+
+		UWorld* World = Session.World.Get();
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if (NetDriver == nullptr)
+		{
+			Finish();
+			return false;
+		}
+
+		// The driver's per second counters roll over once a second, this ticker runs at the same rate.
+		Session.OutBytes += NetDriver->OutBytesPerSecond;
+		Session.InBytes += NetDriver->InBytesPerSecond;
+		Session.MaxConnections = FMath::Max(Session.MaxConnections, NetDriver->ClientConnections.Num());
+		Session.Seconds++;
+
+		for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+		{
+			if (It->GetLocalRole() != ROLE_SimulatedProxy || It->GetAimSnapshots().IsEmpty()) continue;
+			Session.SnapshotDelaySum += It->GetAimSnapshots().GetDelay();
+			Session.ExtrapolatedSamples += It->GetAimSnapshots().GetExtrapolatedTime() > 0.f ? 1 : 0;
+			Session.ProxySamples++;
+		}
+
+		if (--Session.SecondsLeft <= 0)
+		{
+			Finish();
+			return false;
+		}
+		return true;
+	}
+}
+
+static FAutoConsoleCommand CmdNetBandwidth(
+	TEXT("MPShooter.NetBandwidth"),
+	TEXT("Averages net driver bandwidth (and, on clients, simulated proxy snapshot delay / extrapolation) over S seconds (default 60), starting once a client is connected or a server has C clients (default 1). Args: S label C. Appends to Profiling/MPShooter/NetBandwidth.csv."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace NetBandwidthReport;
+		if (TickHandle.IsValid())
+		{
+			Stop();
+		}
+
+		Session = FSession();
+		Session.SecondsLeft = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 60;
+		Session.Label = Args.Num() > 1 ? Args[1] : TEXT("");
+		Session.MinConnections = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 0) : 1;
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick), 1.f);
+	}));
@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MPShooter/Weapon/Weapon.h"
+#include "Blueprint/UserWidget.h"
+#include "Components/WidgetComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "RenderCore.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectIterator.h"
+
+// Pickup prompts before and after the shared HUD prompt, on the same world and the same weapons: first the HUD's one prompt,
+// then every weapon gets a hidden world space widget component with the pickup widget, the way each weapon used to carry one.
+// Spawns the weapons itself (copies of the first weapon class in the level), so one standalone game is enough
+// (Scripts/RunPickupPromptBench.sh, 300 weapons). Each phase writes the frame times, the components the weapons carry and what
+// the weapons, the widget components and the user widgets take in memory ('obj list' measure, same as MPShooter.MemReport).
+namespace PickupPromptBench
+{
+	enum class EPhase : uint8
+	{
+		Waiting,
+		Prompt,
+		Widgets
+	};
+
+	struct FSession
+	{
+		EPhase Phase = EPhase::Waiting;
+		FString Label;
+		TSoftClassPtr<UUserWidget> WidgetClass;
+		int32 NumWeapons = 0;
+		float Duration = 0.f;
+		float WaitLeft = 0.f;
+		float Elapsed = 0.f;
+		int32 Frames = 0;
+		double GameThreadMsSum = 0.0;
+		double RenderThreadMsSum = 0.0;
+		double HudMsSum = 0.0;
+		TArray<TWeakObjectPtr<AWeapon>> Weapons;
+		TArray<TWeakObjectPtr<UWidgetComponent>> Widgets;
+	};
+
+	static FSession Session;
+	static FTSTicker::FDelegateHandle TickHandle;
+
+	static UWorld* FindGameWorld()
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World() && Context.World()->HasBegunPlay())
+			{
+				return Context.World();
+			}
+		}
+		return nullptr;
+	}
+
+	static bool SpawnWeapons(UWorld* World)
+	{
+		TActorIterator<AWeapon> FirstWeapon(World);
+		if (!FirstWeapon)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchPickupPrompts: no weapon in the level to copy"));
+			return false;
+		}
+		UClass* WeaponClass = FirstWeapon->GetClass();
+		LLM_SCOPE_BYTAG(MPShooter_Weapons);
+		const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt((float)Session.NumWeapons));
+		for (int32 Index = 0; Index < Session.NumWeapons; ++Index)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			const FVector Location(Index % GridSize * 150.f, Index / GridSize * 150.f, 100.f);
+			Session.Weapons.Add(World->SpawnActor<AWeapon>(WeaponClass, Location, FRotator::ZeroRotator, SpawnParams));
+		}
+		return true;
+	}
+
+	static void RemoveAll()
+	{
+		for (const TWeakObjectPtr<UWidgetComponent>& Widget : Session.Widgets)
+		{
+			if (Widget.IsValid())
+			{
+				Widget->DestroyComponent();
+			}
+		}
+		Session.Widgets.Reset();
+		for (const TWeakObjectPtr<AWeapon>& Weapon : Session.Weapons)
+		{
+			if (Weapon.IsValid())
+			{
+				Weapon->Destroy();
+			}
+		}
+		Session.Weapons.Reset();
+	}
+
+	static void WriteRow(const TCHAR* Path)
+	{
+		const int32 Frames = FMath::Max(Session.Frames, 1);
+		const double GameThreadMs = Session.GameThreadMsSum / Frames;
+		const double RenderThreadMs = Session.RenderThreadMsSum / Frames;
+		const double HudMs = Session.HudMsSum / Frames;
+
+		int32 Weapons = 0;
+		int32 WeaponComponents = 0;
+		int64 WeaponBytes = 0;
+		for (const TWeakObjectPtr<AWeapon>& Weapon : Session.Weapons)
+		{
+			if (!Weapon.IsValid()) continue;
+			Weapons++;
+			WeaponComponents += Weapon->GetComponents().Num();
+			WeaponBytes += FArchiveCountMem(Weapon.Get()).GetMax() + Weapon->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+		int32 WidgetComponents = 0;
+		int64 WidgetComponentBytes = 0;
+		for (TObjectIterator<UWidgetComponent> It(RF_ClassDefaultObject | RF_ArchetypeObject); It; ++It)
+		{
+			WidgetComponents++;
+			WidgetComponentBytes += FArchiveCountMem(*It).GetMax() + It->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+		int32 UserWidgets = 0;
+		int64 UserWidgetBytes = 0;
+		for (TObjectIterator<UUserWidget> It(RF_ClassDefaultObject | RF_ArchetypeObject); It; ++It)
+		{
+			UserWidgets++;
+			UserWidgetBytes += FArchiveCountMem(*It).GetMax() + It->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Pickup prompt bench [%s] %s, %d weapons (%d components) over %d frames: game thread %.3f ms, render thread %.3f ms, HUD %.4f ms; %d widget components %lld bytes, %d user widgets %lld bytes, weapons %lld bytes"),
+			*Session.Label, Path, Weapons, WeaponComponents, Session.Frames, GameThreadMs, RenderThreadMs, HudMs,
+			WidgetComponents, WidgetComponentBytes, UserWidgets, UserWidgetBytes, WeaponBytes);
+
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("PickupPrompts.csv")), TEXT("Time,Label,Path,Weapons,WeaponComponents,Frames,GameThreadMs,RenderThreadMs,HudMs,WidgetComponents,WidgetComponentBytes,UserWidgets,UserWidgetBytes,WeaponBytes"),
+			FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%.4f,%.4f,%.4f,%d,%lld,%d,%lld,%lld") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Session.Label, Path,
+			Weapons, WeaponComponents, Session.Frames, GameThreadMs, RenderThreadMs, HudMs, WidgetComponents, WidgetComponentBytes, UserWidgets, UserWidgetBytes, WeaponBytes));
+	}
+
+	static void Finish()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+		FMPShooterPerfCounters::bEnabled = false;
+		RemoveAll();
+	}
+
+	static void StartPhase(EPhase Phase)
+	{
+		Session.Phase = Phase;
+		Session.Elapsed = 0.f;
+		Session.Frames = 0;
+		Session.GameThreadMsSum = 0.0;
+		Session.RenderThreadMsSum = 0.0;
+		Session.HudMsSum = 0.0;
+		FMPShooterPerfCounters::Reset();
+		FMPShooterPerfCounters::bEnabled = true;
+	}
+
+	// What AWeapon's constructor used to add: a hidden world space widget on the root, shown while a character overlaps
+	static bool AddWidgets()
+	{
+		UClass* WidgetClass = Session.WidgetClass.IsNull() ? nullptr : Session.WidgetClass.LoadSynchronous();
+		if (WidgetClass == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchPickupPrompts: no widget class '%s', only the shared prompt was measured"), *Session.WidgetClass.ToString());
+			return false;
+		}
+		LLM_SCOPE_BYTAG(MPShooter_Weapons);
+		for (const TWeakObjectPtr<AWeapon>& Weapon : Session.Weapons)
+		{
+			if (!Weapon.IsValid()) continue;
+			UWidgetComponent* Widget = NewObject<UWidgetComponent>(Weapon.Get());
+			Widget->SetWidgetClass(WidgetClass);
+			Widget->SetupAttachment(Weapon->GetRootComponent());
+			Widget->SetVisibility(false);
+			Widget->RegisterComponent();
+			Widget->InitWidget();
+			Session.Widgets.Add(Widget);
+		}
+		return true;
+	}
+
+	static bool Tick(float DeltaTime)
+	{
+		UWorld* World = FindGameWorld();
+		if (Session.Phase == EPhase::Waiting)
+		{
+			Session.WaitLeft -= DeltaTime;
+			if (World == nullptr)
+			{
+				if (Session.WaitLeft <= 0.f)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchPickupPrompts: no game world"));
+					Finish();
+					return false;
+				}
+				return true;
+			}
+			if (!SpawnWeapons(World))
+			{
+				Finish();
+				return false;
+			}
+			StartPhase(EPhase::Prompt);
+			return true;
+		}
+		if (World == nullptr)
+		{
+			Finish();
+			return false;
+		}
+
+		Session.GameThreadMsSum += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		Session.RenderThreadMsSum += FPlatformTime::ToMilliseconds(GRenderThreadTime);
+		Session.HudMsSum += FPlatformTime::ToMilliseconds64(FMPShooterPerfCounters::Cycles[(int32)EMPShooterPerfScope::HUD]);
+		Session.Frames++;
+		Session.Elapsed += DeltaTime;
+		FMPShooterPerfCounters::Reset();
+		if (Session.Elapsed < Session.Duration)
+		{
+			return true;
+		}
+
+		if (Session.Phase == EPhase::Prompt)
+		{
+			WriteRow(TEXT("SharedPrompt"));
+			if (AddWidgets())
+			{
+				StartPhase(EPhase::Widgets);
+				return true;
+			}
+		}
+		else
+		{
+			WriteRow(TEXT("WidgetComponents"));
+		}
+		Finish();
+		return false;
+	}
+}
+
+static FAutoConsoleCommand CmdBenchPickupPrompts(
+	TEXT("MPShooter.BenchPickupPrompts"),
+	TEXT("Standalone / listen server: spawns N weapons (default 300), measures frame times, components and widget memory for S seconds (default 20) with the HUD's shared pickup prompt, then again with a widget component per weapon. Args: S N WidgetClassPath (the pickup widget blueprint class, without it only the shared prompt is measured) label. Appends to Profiling/MPShooter/PickupPrompts.csv."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace PickupPromptBench;
+		if (TickHandle.IsValid())
+		{
+			Finish();
+		}
+
+		Session = FSession();
+		Session.Duration = Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 1.f) : 20.f;
+		Session.NumWeapons = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 300;
+		Session.WidgetClass = TSoftClassPtr<UUserWidget>(FSoftObjectPath(Args.Num() > 2 ? Args[2] : FString())); // the pickup widget blueprint weapons used to carry
+		Session.Label = Args.Num() > 3 ? Args[3] : TEXT("");
+		Session.WaitLeft = 60.f;
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick));
+	}));
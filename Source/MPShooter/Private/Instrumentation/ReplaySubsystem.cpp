@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/ReplaySubsystem.h"
+#include "Engine/DemoNetDriver.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/Paths.h"
+#include "MPShooter/GameMode/GM_Lobby.h"
+
+static TAutoConsoleVariable<int32> CVarRecordMatchReplays(
+	TEXT("MPShooter.RecordMatchReplays"),
+	0,
+	TEXT("Record a replay of every match (not the lobby) on the server."));
+
+static TAutoConsoleVariable<float> CVarReplayCheckpointInterval(
+	TEXT("MPShooter.ReplayCheckpointInterval"),
+	120.f,
+	TEXT("Seconds between replay checkpoints. Fewer checkpoints keep the replay small, at the cost of slower scrubbing."));
+
+void UReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldInitHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &UReplaySubsystem::OnWorldInitializedActors);
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &UReplaySubsystem::OnWorldCleanup);
+
+	FString ReplayName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-ReplayBenchmark="), ReplayName))
+	{
+		float FixedFPS = 60.f;
+		FParse::Value(FCommandLine::Get(), TEXT("-BenchmarkFPS="), FixedFPS);
+		FString CsvPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/ReplayBenchmark.csv");
+		FParse::Value(FCommandLine::Get(), TEXT("-BenchmarkCSV="), CsvPath);
+		StartBenchmark(ReplayName, FixedFPS, CsvPath);
+	}
+}
+
+void UReplaySubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	RestoreCheckpointDelay();
+	if (BenchmarkTickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(BenchmarkTickHandle);
+		BenchmarkTickHandle.Reset();
+	}
+	FMPShooterPerfCounters::bEnabled = false;
+
+	Super::Deinitialize();
+}
+
+void UReplaySubsystem::OnWorldInitializedActors(const FActorsInitializedParams& Params)
+{
+	UWorld* World = Params.World;
+	if (World == nullptr || World->GetGameInstance() != GetGameInstance()) return;
+	if (World->IsPlayingReplay() || bBenchmarkRunning) return;
+	if (World->GetNetMode() != NM_DedicatedServer && World->GetNetMode() != NM_ListenServer) return; // Only the server records
+	if (Cast<AGM_Lobby>(World->GetAuthGameMode())) return; // No point recording the lobby
+
+	if (CVarRecordMatchReplays.GetValueOnGameThread() != 0)
+	{
+		StartMatchRecording(World);
+	}
+}
+
+void UReplaySubsystem::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	if (World != nullptr && World == RecordingWorld.Get())
+	{
+		RestoreCheckpointDelay(); // the recording ends with its world
+	}
+}
+
+void UReplaySubsystem::StartMatchRecording(UWorld* World)
+{
+	if (IConsoleVariable* CheckpointDelay = IConsoleManager::Get().FindConsoleVariable(TEXT("demo.CheckpointUploadDelayInSeconds")))
+	{
+		if (!SavedCheckpointDelay.IsSet())
+		{
+			SavedCheckpointDelay = CheckpointDelay->GetFloat();
+		}
+		CheckpointDelay->Set(CVarReplayCheckpointInterval.GetValueOnGameThread(), ECVF_SetByCode);
+	}
+	RecordingWorld = World;
+
+	const FString ReplayName = FString::Printf(TEXT("Match_%s"), *FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")));
+	GetGameInstance()->StartRecordingReplay(ReplayName, World->GetMapName());
+	UE_LOG(LogTemp, Log, TEXT("Recording match replay %s"), *ReplayName);
+}
+
+void UReplaySubsystem::RestoreCheckpointDelay()
+{
+	RecordingWorld.Reset();
+	if (!SavedCheckpointDelay.IsSet()) return;
+
+	if (IConsoleVariable* CheckpointDelay = IConsoleManager::Get().FindConsoleVariable(TEXT("demo.CheckpointUploadDelayInSeconds")))
+	{
+		CheckpointDelay->Set(SavedCheckpointDelay.GetValue(), ECVF_SetByCode);
+	}
+	SavedCheckpointDelay.Reset();
+}
+
+void UReplaySubsystem::StartBenchmark(const FString& InReplayName, float FixedFPS, const FString& InCsvPath)
+{
+	if (bBenchmarkRunning) return;
+
+	BenchmarkReplayName = InReplayName;
+	BenchmarkCsvPath = InCsvPath;
+	BenchmarkFPS = FMath::Max(FixedFPS, 1.f);
+	bBenchmarkRunning = true;
+	bPlaybackStarted = false;
+	BenchmarkStartTime = FPlatformTime::Seconds();
+
+	FramesSampled = 0;
+	GameThreadMsSum = 0.0;
+	GameThreadMsMax = 0.0;
+	FMemory::Memzero(ScopeMsSum);
+	FMemory::Memzero(ScopeMsMax);
+	FMemory::Memzero(ScopeCallsSum);
+
+	// Benchmarking mode makes the engine step by FixedDeltaTime regardless of how long the frame really took.
+	FApp::SetBenchmarking(true);
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / BenchmarkFPS);
+
+	BenchmarkTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UReplaySubsystem::TickBenchmark));
+}
+
+bool UReplaySubsystem::TickBenchmark(float DeltaTime)
+{
+	if (!bPlaybackStarted)
+	{
+		// Wait a tick so the game instance has finished starting up before loading the replay.
+		bPlaybackStarted = GetGameInstance()->PlayReplay(BenchmarkReplayName);
+		if (!bPlaybackStarted)
+		{
+			UE_LOG(LogTemp, Error, TEXT("ReplayBenchmark: could not play replay %s"), *BenchmarkReplayName);
+			FinishBenchmark(false);
+			return false;
+		}
+		FMPShooterPerfCounters::Reset();
+		FMPShooterPerfCounters::bEnabled = true;
+		return true;
+	}
+
+	UWorld* World = GetGameInstance()->GetWorld();
+	UDemoNetDriver* DemoDriver = World ? World->GetDemoNetDriver() : nullptr;
+	if (DemoDriver == nullptr || !DemoDriver->IsPlaying())
+	{
+		if (FPlatformTime::Seconds() - BenchmarkStartTime > 60.0) // the replay never came up
+		{
+			UE_LOG(LogTemp, Error, TEXT("ReplayBenchmark: timed out waiting for playback of %s"), *BenchmarkReplayName);
+			FinishBenchmark(false);
+			return false;
+		}
+		FMPShooterPerfCounters::Reset(); // don't count the map load
+		return true;
+	}
+
+	SampleFrame();
+
+	if (DemoDriver->GetDemoCurrentTime() >= DemoDriver->GetDemoTotalTime())
+	{
+		FinishBenchmark(true);
+		return false;
+	}
+	return true;
+}
+
+void UReplaySubsystem::SampleFrame()
+{
+	const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	GameThreadMsSum += GameThreadMs;
+	GameThreadMsMax = FMath::Max(GameThreadMsMax, GameThreadMs);
+
+	for (int32 Index = 0; Index < (int32)EMPShooterPerfScope::Count; ++Index)
+	{
+		const double ScopeMs = FPlatformTime::ToMilliseconds64(FMPShooterPerfCounters::Cycles[Index]);
+		ScopeMsSum[Index] += ScopeMs;
+		ScopeMsMax[Index] = FMath::Max(ScopeMsMax[Index], ScopeMs);
+		ScopeCallsSum[Index] += FMPShooterPerfCounters::Calls[Index];
+	}
+	FMPShooterPerfCounters::Reset();
+	++FramesSampled;
+}
+
+void UReplaySubsystem::FinishBenchmark(bool bCompleted)
+{
+	FMPShooterPerfCounters::bEnabled = false;
+	bBenchmarkRunning = false;
+	BenchmarkTickHandle.Reset(); // returning false from the ticker removes it
+
+	WriteBenchmarkCsv(bCompleted);
+	FPlatformMisc::RequestExit(false);
+}
+
+void UReplaySubsystem::WriteBenchmarkCsv(bool bCompleted) const
+{
+	const double Frames = FMath::Max(FramesSampled, 1);
+
+	FString Header = TEXT("Date,Build,Changelist,Config,Replay,Completed,FixedFPS,Frames,GameThreadAvgMs,GameThreadMaxMs");
+	for (int32 Index = 0; Index < (int32)EMPShooterPerfScope::Count; ++Index)
+	{
+		const TCHAR* Name = FMPShooterPerfCounters::GetName((EMPShooterPerfScope)Index);
+		Header += FString::Printf(TEXT(",%sAvgMs,%sMaxMs,%sCallsPerFrame"), Name, Name, Name);
+	}
+
+	FString Csv = FString::Printf(TEXT("%s,%s,%u,%s,%s,%d,%.1f,%d,%.4f,%.4f"),
+		*FDateTime::Now().ToIso8601(),
+		FApp::GetBuildVersion(),
+		FEngineVersion::Current().GetChangelist(),
+		LexToString(FApp::GetBuildConfiguration()),
+		*BenchmarkReplayName,
+		bCompleted ? 1 : 0,
+		BenchmarkFPS,
+		FramesSampled,
+		GameThreadMsSum / Frames,
+		GameThreadMsMax);
+	for (int32 Index = 0; Index < (int32)EMPShooterPerfScope::Count; ++Index)
+	{
+		Csv += FString::Printf(TEXT(",%.4f,%.4f,%.2f"), ScopeMsSum[Index] / Frames, ScopeMsMax[Index], ScopeCallsSum[Index] / Frames);
+	}
+	Csv += LINE_TERMINATOR;
+
+	FMPShooterCsv::Append(BenchmarkCsvPath, Header, Csv); // a perf scope added since the file was started moves it aside
+	UE_LOG(LogTemp, Log, TEXT("ReplayBenchmark: %d frames of %s written to %s"), FramesSampled, *BenchmarkReplayName, *BenchmarkCsvPath);
+}
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MPShooter/Weapon/Weapon.h"
+#include "Containers/Ticker.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+
+// Server replication cost of a level full of pickups, with and without weapon dormancy. Run it on a server with clients connected,
+// once with net.DormancyEnable 1 and once with 0 (Scripts/CompareWeaponDormancy.sh). Replication time is measured the same way
+// the tick governor does: from the end of the actor ticks to the end of the net driver's TickFlush.
+namespace WeaponDormancyBench
+{
+	static constexpr int32 MaxWaitSeconds = 120;
+
+	struct FSession
+	{
+		TWeakObjectPtr<UWorld> World;
+		FString Label;
+		int32 Weapons = 0;
+		int32 MinConnections = 1;
+		int32 SecondsLeft = 0;
+		int32 WaitSecondsLeft = MaxWaitSeconds;
+		bool bMeasuring = false;
+		int32 Seconds = 0;
+		uint64 OutBytes = 0;
+		int32 Connections = 0;
+		double PostActorTickTime = 0.0;
+		double NetMsSum = 0.0;
+		double NetMsMax = 0.0;
+		int32 Frames = 0;
+	};
+
+	static FSession Session;
+	static FTSTicker::FDelegateHandle TickHandle;
+	static FDelegateHandle PostActorTickHandle;
+	static FDelegateHandle PostTickFlushHandle;
+
+	static void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+	{
+		if (World == Session.World.Get())
+		{
+			Session.PostActorTickTime = FPlatformTime::Seconds();
+		}
+	}
+
+	static void OnPostTickFlush()
+	{
+		if (!Session.bMeasuring || Session.PostActorTickTime == 0.0) return;
+
+		const double NetMs = (FPlatformTime::Seconds() - Session.PostActorTickTime) * 1000.0;
+		Session.NetMsSum += NetMs;
+		Session.NetMsMax = FMath::Max(Session.NetMsMax, NetMs);
+		Session.Frames++;
+	}
+
+	static void Stop()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+		FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+		if (UWorld* World = Session.World.Get())
+		{
+			World->OnPostTickFlush().Remove(PostTickFlushHandle);
+		}
+	}
+
+	static void Finish()
+	{
+		Stop();
+
+		const int32 DormancyEnabled = IConsoleManager::Get().FindConsoleVariable(TEXT("net.DormancyEnable"))->GetInt();
+		const int32 Frames = FMath::Max(Session.Frames, 1);
+		const double NetMs = Session.NetMsSum / Frames;
+		const double OutKBps = Session.OutBytes / 1024.0 / FMath::Max(Session.Seconds, 1);
+
+		UE_LOG(LogTemp, Display, TEXT("Weapon dormancy bench [%s] dormancy %d, %d weapons, %d connections over %d s: replication %.3f ms avg, %.3f ms max per frame, out %.2f KB/s"),
+			*Session.Label, DormancyEnabled, Session.Weapons, Session.Connections, Session.Seconds, NetMs, Session.NetMsMax, OutKBps);
+
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("WeaponDormancy.csv")), TEXT("Time,Label,DormancyEnable,Weapons,Connections,Seconds,Frames,ReplicationMs,ReplicationMaxMs,OutKBps"),
+			FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%d,%.4f,%.4f,%.3f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Session.Label,
+			DormancyEnabled, Session.Weapons, Session.Connections, Session.Seconds, Session.Frames, NetMs, Session.NetMsMax, OutKBps));
+	}
+
+	static bool Tick(float DeltaTime)
+	{
+		UWorld* World = Session.World.Get();
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if (NetDriver == nullptr)
+		{
+			Stop();
+			return false;
+		}
+
+		if (!Session.bMeasuring)
+		{
+			// Clients joining (map load, initial bunches for every weapon) aren't what we're measuring
+			if (NetDriver->ClientConnections.Num() < Session.MinConnections)
+			{
+				if (--Session.WaitSecondsLeft <= 0)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchWeaponDormancy: %d of %d clients connected after %d s, giving up"), NetDriver->ClientConnections.Num(), Session.MinConnections, MaxWaitSeconds);
+					Stop();
+					return false;
+				}
+				return true;
+			}
+			Session.bMeasuring = true;
+			return true; // the byte counters below cover the second that starts now
+		}
+
+		// The driver's per second counters roll over once a second, this ticker runs at the same rate.
+		Session.OutBytes += NetDriver->OutBytesPerSecond;
+		Session.Connections = FMath::Max(Session.Connections, NetDriver->ClientConnections.Num());
+		Session.Seconds++;
+		if (--Session.SecondsLeft <= 0)
+		{
+			Finish();
+			return false;
+		}
+		return true;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdBenchWeaponDormancy(
+	TEXT("MPShooter.BenchWeaponDormancy"),
+	TEXT("Server: makes sure there are N pickups in the level (default 500, copies of the first weapon class on a grid), waits for C clients (default 1), then measures replication time and bandwidth for S seconds (default 30). Args: N S C label. Appends to Profiling/MPShooter/WeaponDormancy.csv."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		using namespace WeaponDormancyBench;
+		if (World == nullptr || World->GetNetMode() == NM_Client || World->GetNetDriver() == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchWeaponDormancy: run it on a server"));
+			return;
+		}
+		if (TickHandle.IsValid())
+		{
+			Stop();
+		}
+
+		const int32 NumWeapons = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 500;
+		TArray<AWeapon*> Weapons;
+		for (TActorIterator<AWeapon> It(World); It; ++It)
+		{
+			Weapons.Add(*It);
+		}
+		if (Weapons.Num() == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("MPShooter.BenchWeaponDormancy: no weapon in the level to copy"));
+			return;
+		}
+		UClass* WeaponClass = Weapons[0]->GetClass();
+		const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt((float)NumWeapons));
+		for (int32 Index = Weapons.Num(); Index < NumWeapons; ++Index)
+		{
+			const FVector Location(Index % GridSize * 150.f, Index / GridSize * 150.f, 100.f);
+			Weapons.Add(World->SpawnActor<AWeapon>(WeaponClass, Location, FRotator::ZeroRotator)); // lying there like placed pickups, never touched
+		}
+
+		Session = FSession();
+		Session.World = World;
+		Session.Weapons = Weapons.Num();
+		Session.SecondsLeft = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 30;
+		Session.MinConnections = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 0) : 1;
+		Session.Label = Args.Num() > 3 ? Args[3] : TEXT("");
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddStatic(&OnWorldPostActorTick);
+		PostTickFlushHandle = World->OnPostTickFlush().AddStatic(&OnPostTickFlush);
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick), 1.f);
+	}));
@@ -2,4 +2,183 @@
 
 
 #include "MPShooterGameModeBase.h"
+#include "HUD/SpartanHUD.h"
+#include "GameState/MPShooterGameState.h"
+#include "Character/SpartanCharacter.h"
+#include "Character/SpartanPawnPoolSubsystem.h"
+#include "GameFramework/PlayerState.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "RenderCore.h"
+#include "TimerManager.h"
 
+DECLARE_CYCLE_STAT(TEXT("Respawn"), STAT_MPShooter_Respawn, STATGROUP_MPShooter);
+
+static TAutoConsoleVariable<int32> CVarUsePawnPool(
+	TEXT("MPShooter.UsePawnPool"),
+	1,
+	TEXT("1: eliminated characters are pooled and reused on respawn. 0: destroy and spawn a new pawn (for comparison)."));
+
+// Respawn cost by path, pooled against spawned: the time RespawnPlayer takes and the game thread time of the frame it ran in
+// (the hitch). MPShooter.RespawnReport writes them out; run a bot server once with MPShooter.UsePawnPool 1 and once with 0.
+namespace RespawnReport
+{
+	struct FPathStats
+	{
+		int32 Count = 0;
+		double RespawnMsSum = 0.0;
+		double RespawnMsMax = 0.0;
+		int32 Frames = 0;
+		double FrameMsSum = 0.0;
+		double FrameMsMax = 0.0;
+	};
+
+	static FPathStats Paths[2]; // 0 spawned, 1 pooled
+	static FString Label;
+	static FTSTicker::FDelegateHandle ReportHandle;
+
+	static void AddRespawn(bool bPooled, double RespawnMs)
+	{
+		FPathStats& Stats = Paths[bPooled ? 1 : 0];
+		Stats.Count++;
+		Stats.RespawnMsSum += RespawnMs;
+		Stats.RespawnMsMax = FMath::Max(Stats.RespawnMsMax, RespawnMs);
+
+		// The core ticker runs at the start of the next frame, when GGameThreadTime holds the frame we respawned in
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([bPooled](float)
+		{
+			FPathStats& Stats = Paths[bPooled ? 1 : 0];
+			const double FrameMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+			Stats.Frames++;
+			Stats.FrameMsSum += FrameMs;
+			Stats.FrameMsMax = FMath::Max(Stats.FrameMsMax, FrameMs);
+			return false;
+		}));
+	}
+
+	static bool Write(float)
+	{
+		ReportHandle.Reset();
+		FString Csv;
+		for (int32 Path = 0; Path < 2; ++Path)
+		{
+			const FPathStats& Stats = Paths[Path];
+			if (Stats.Count == 0) continue;
+			const TCHAR* PathName = Path == 1 ? TEXT("pooled") : TEXT("spawned");
+			const double RespawnMs = Stats.RespawnMsSum / Stats.Count;
+			const double FrameMs = Stats.Frames > 0 ? Stats.FrameMsSum / Stats.Frames : 0.0;
+			UE_LOG(LogTemp, Display, TEXT("Respawn report [%s] %s: %d respawns, %.3f ms avg, %.3f ms max, respawn frame %.2f ms avg, %.2f ms max"),
+				*Label, PathName, Stats.Count, RespawnMs, Stats.RespawnMsMax, FrameMs, Stats.FrameMsMax);
+			Csv += FString::Printf(TEXT("%s,%s,%s,%d,%.4f,%.4f,%.3f,%.3f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Label, PathName,
+				Stats.Count, RespawnMs, Stats.RespawnMsMax, FrameMs, Stats.FrameMsMax);
+		}
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("Respawn.csv")), TEXT("Time,Label,Path,Respawns,RespawnMs,RespawnMaxMs,FrameMs,FrameMaxMs"), Csv);
+		Paths[0] = FPathStats();
+		Paths[1] = FPathStats();
+		return false;
+	}
+}
+
+static FAutoConsoleCommand CmdRespawnReport(
+	TEXT("MPShooter.RespawnReport"),
+	TEXT("Server: clears the respawn counters, and after S seconds (default 0, right away) writes respawn time and respawn frame time for the pooled and the spawned path. Optional label as the second argument. Appends to Profiling/MPShooter/Respawn.csv."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace RespawnReport;
+		const float Seconds = Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 0.f) : 0.f;
+		Label = Args.Num() > 1 ? Args[1] : TEXT("");
+		if (ReportHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(ReportHandle);
+			ReportHandle.Reset();
+		}
+		if (Seconds <= 0.f)
+		{
+			Write(0.f);
+			return;
+		}
+		Paths[0] = FPathStats();
+		Paths[1] = FPathStats();
+		ReportHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Write), Seconds);
+	}));
+
+AMPShooterGameModeBase::AMPShooterGameModeBase()
+{
+	HUDClass = ASpartanHUD::StaticClass(); // Nameplates are drawn by the HUD, not by widget components on each character.
+	GameStateClass = AMPShooterGameState::StaticClass(); // Health, armor and score for every player
+	RespawnDelay = 3.f;
+}
+
+APawn* AMPShooterGameModeBase::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	LLM_SCOPE_BYTAG(MPShooter_Characters);
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
+
+void AMPShooterGameModeBase::PlayerEliminated(ASpartanCharacter* EliminatedCharacter, AController* VictimController, AController* AttackerController)
+{
+	if (EliminatedCharacter == nullptr) return;
+
+	EliminatedCharacter->Elim();
+
+	const double ElimTime = FPlatformTime::Seconds();
+	FTimerHandle RespawnTimer;
+	GetWorldTimerManager().SetTimer(RespawnTimer, FTimerDelegate::CreateWeakLambda(this,
+		[this, WeakController = TWeakObjectPtr<AController>(VictimController), WeakCharacter = TWeakObjectPtr<ASpartanCharacter>(EliminatedCharacter), ElimTime]()
+		{
+			RespawnPlayer(WeakController.Get(), WeakCharacter.Get());
+			UE_LOG(LogTemp, Log, TEXT("Respawn latency %.1f ms (including %.1f s delay)"), (FPlatformTime::Seconds() - ElimTime) * 1000.0, RespawnDelay);
+		}), RespawnDelay, false);
+}
+
+void AMPShooterGameModeBase::RespawnPlayer(AController* Controller, ASpartanCharacter* EliminatedCharacter)
+{
+	if (Controller == nullptr) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_Respawn);
+	LLM_SCOPE_BYTAG(MPShooter_Characters);
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (EliminatedCharacter && EliminatedCharacter->GetController() == Controller)
+	{
+		Controller->UnPossess();
+	}
+
+	USpartanPawnPoolSubsystem* PawnPool = GetWorld()->GetSubsystem<USpartanPawnPoolSubsystem>();
+	ASpartanCharacter* Character = nullptr;
+	if (PawnPool && CVarUsePawnPool.GetValueOnGameThread() != 0)
+	{
+		// Another pooled body first: releasing ours and acquiring on the same frame would hand back the corpse we just hid, and wake
+		// the channel it just made dormant. The first death of each player spawns; after that there is always one dead long enough.
+		Character = PawnPool->Acquire(EliminatedCharacter ? EliminatedCharacter->GetClass() : GetDefaultPawnClassForController(Controller).Get());
+		PawnPool->Release(EliminatedCharacter); // it has been a ragdoll for RespawnDelay
+	}
+	else if (EliminatedCharacter)
+	{
+		EliminatedCharacter->Destroy();
+	}
+
+	if (Character)
+	{
+		const AActor* StartSpot = ChoosePlayerStart(Controller);
+		const FTransform SpawnTransform = StartSpot ? FTransform(StartSpot->GetActorRotation(), StartSpot->GetActorLocation()) : Character->GetActorTransform();
+		Character->LeavePool(SpawnTransform);
+		Controller->Possess(Character);
+		Controller->ClientSetRotation(SpawnTransform.Rotator(), true);
+	}
+	else
+	{
+		RestartPlayer(Controller); // nothing pooled, spawn the usual way
+	}
+
+	if (AMPShooterGameState* MPShooterGameState = GetGameState<AMPShooterGameState>())
+	{
+		MPShooterGameState->ResetPlayerHealth(Controller->PlayerState);
+	}
+	const double RespawnMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	RespawnReport::AddRespawn(Character != nullptr, RespawnMs);
+	UE_LOG(LogTemp, Log, TEXT("Respawned %s in %.3f ms (%s)"), *GetNameSafe(Controller), RespawnMs, Character ? TEXT("pooled") : TEXT("spawned"));
+}
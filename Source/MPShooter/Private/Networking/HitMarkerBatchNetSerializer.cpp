@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Networking/HitMarkerBatchNetSerializer.h"
+
+#if UE_WITH_IRIS
+#include "SpartanComponents/CombatComponent.h"
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+#include "Iris/Serialization/NetBitStreamReader.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+
+namespace UE::Net
+{
+
+struct FHitMarkerBatchNetSerializer
+{
+	static const uint32 Version = 0;
+
+	typedef FHitMarkerBatch SourceType;
+	typedef uint32 QuantizedType; // hits | kills << 6 | damage << 9, packed once when the state is quantized
+	typedef FHitMarkerBatchNetSerializerConfig ConfigType;
+
+	static const ConfigType DefaultConfig;
+
+	static constexpr uint32 HitsBits = 6;
+	static constexpr uint32 KillsBits = 3;
+	static constexpr uint32 DamageBits = 14;
+	static constexpr uint32 TotalBits = HitsBits + KillsBits + DamageBits;
+
+	static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+	{
+		const QuantizedType Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+		Context.GetBitStreamWriter()->WriteBits(Value, TotalBits);
+	}
+
+	static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+	{
+		*reinterpret_cast<QuantizedType*>(Args.Target) = Context.GetBitStreamReader()->ReadBits(TotalBits);
+	}
+
+	static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+	{
+		const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+		// FHitMarkerBatch::Add already saturates each field to its bit width
+		*reinterpret_cast<QuantizedType*>(Args.Target) =
+			(uint32(Source.NumHits) & ((1U << HitsBits) - 1U))
+			| ((uint32(Source.NumKills) & ((1U << KillsBits) - 1U)) << HitsBits)
+			| ((uint32(Source.TotalDamage) & ((1U << DamageBits) - 1U)) << (HitsBits + KillsBits));
+	}
+
+	static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+	{
+		const QuantizedType Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+		SourceType& Target = *reinterpret_cast<SourceType*>(Args.Target);
+		Target.NumHits = uint8(Value & ((1U << HitsBits) - 1U));
+		Target.NumKills = uint8((Value >> HitsBits) & ((1U << KillsBits) - 1U));
+		Target.TotalDamage = uint16(Value >> (HitsBits + KillsBits));
+	}
+
+	static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+	{
+		if (Args.bStateIsQuantized)
+		{
+			return *reinterpret_cast<const QuantizedType*>(Args.Source0) == *reinterpret_cast<const QuantizedType*>(Args.Source1);
+		}
+		const SourceType& A = *reinterpret_cast<const SourceType*>(Args.Source0);
+		const SourceType& B = *reinterpret_cast<const SourceType*>(Args.Source1);
+		return A.NumHits == B.NumHits && A.NumKills == B.NumKills && A.TotalDamage == B.TotalDamage;
+	}
+
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	static FHitMarkerBatchNetSerializer::FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+};
+
+const FHitMarkerBatchNetSerializer::ConfigType FHitMarkerBatchNetSerializer::DefaultConfig;
+FHitMarkerBatchNetSerializer::FNetSerializerRegistryDelegates FHitMarkerBatchNetSerializer::NetSerializerRegistryDelegates;
+
+UE_NET_IMPLEMENT_SERIALIZER(FHitMarkerBatchNetSerializer);
+
+// Replaces the last resort (NetSerialize through an FArchive) serializer Iris would otherwise use for the struct
+static const FName PropertyNetSerializerRegistry_NAME_HitMarkerBatch("HitMarkerBatch");
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_HitMarkerBatch, FHitMarkerBatchNetSerializer);
+
+FHitMarkerBatchNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_HitMarkerBatch);
+}
+
+void FHitMarkerBatchNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_HitMarkerBatch);
+}
+
+}
+#endif
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Networking/MPShooterIris.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+#if UE_WITH_IRIS
+#include "Iris/ReplicationSystem/ReplicationSystem.h"
+#include "Net/Iris/ReplicationSystem/ReplicationSystemUtil.h"
+#endif
+
+static TAutoConsoleVariable<FString> CVarIrisFilter(
+	TEXT("MPShooter.Iris.Filter"),
+	TEXT("Spatial"),
+	TEXT("Iris dynamic filter for characters, weapons and projectiles (a FilterName from NetObjectFilterDefinitions, empty for none)."));
+
+static TAutoConsoleVariable<FString> CVarIrisCharacterPrioritizer(
+	TEXT("MPShooter.Iris.CharacterPrioritizer"),
+	TEXT("FieldOfView"),
+	TEXT("Iris prioritizer for characters (a PrioritizerName from NetObjectPrioritizerDefinitions). Falls back to MPShooter.Iris.Prioritizer."));
+
+static TAutoConsoleVariable<FString> CVarIrisPrioritizer(
+	TEXT("MPShooter.Iris.Prioritizer"),
+	TEXT("Sphere"),
+	TEXT("Iris prioritizer for weapons and projectiles, and characters when theirs isn't defined."));
+
+namespace MPShooterIris
+{
+	bool IsUsingIris(const UObject* WorldContextObject)
+	{
+#if UE_WITH_IRIS
+		const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+		const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		return NetDriver && NetDriver->IsUsingIrisReplication();
+#else
+		return false;
+#endif
+	}
+
+	void ConfigureActor(AActor* Actor, EReplicatedClass Class)
+	{
+#if UE_WITH_IRIS
+		using namespace UE::Net;
+		if (!IsUsingIris(Actor) || !Actor->HasAuthority()) return;
+
+		UReplicationSystem* ReplicationSystem = FReplicationSystemUtil::GetReplicationSystem(Actor);
+		const FNetRefHandle Handle = FReplicationSystemUtil::GetNetRefHandle(Actor);
+		if (ReplicationSystem == nullptr || !Handle.IsValid()) return;
+
+		const FString FilterName = CVarIrisFilter.GetValueOnGameThread();
+		if (!FilterName.IsEmpty())
+		{
+			const FNetObjectFilterHandle Filter = ReplicationSystem->GetFilterHandle(FName(*FilterName));
+			if (Filter != InvalidNetObjectFilterHandle)
+			{
+				ReplicationSystem->SetFilter(Handle, Filter);
+			}
+		}
+
+		// Characters are what players look at, so they get view based priority; pickups and projectiles only distance
+		FNetObjectPrioritizerHandle Prioritizer = InvalidNetObjectPrioritizerHandle;
+		if (Class == EReplicatedClass::Character)
+		{
+			Prioritizer = ReplicationSystem->GetPrioritizerHandle(FName(*CVarIrisCharacterPrioritizer.GetValueOnGameThread()));
+		}
+		if (Prioritizer == InvalidNetObjectPrioritizerHandle)
+		{
+			Prioritizer = ReplicationSystem->GetPrioritizerHandle(FName(*CVarIrisPrioritizer.GetValueOnGameThread()));
+		}
+		if (Prioritizer != InvalidNetObjectPrioritizerHandle)
+		{
+			ReplicationSystem->SetPrioritizer(Handle, Prioritizer);
+		}
+		else
+		{
+			// Whatever the project's default prioritizer is stays in charge; a static priority would stop distance mattering at all
+			static bool bLogged = false;
+			if (!bLogged)
+			{
+				bLogged = true;
+				UE_LOG(LogTemp, Warning, TEXT("MPShooter Iris: no prioritizer named '%s' or '%s' in NetObjectPrioritizerDefinitions, using the default one"),
+					*CVarIrisCharacterPrioritizer.GetValueOnGameThread(), *CVarIrisPrioritizer.GetValueOnGameThread());
+			}
+		}
+#endif
+	}
+
+	void SetReplicatesWith(AActor* Parent, AActor* Child, bool bDependent)
+	{
+#if UE_WITH_IRIS
+		using namespace UE::Net;
+		if (Parent == nullptr || Child == nullptr || !IsUsingIris(Parent) || !Parent->HasAuthority()) return;
+
+		if (bDependent)
+		{
+			FReplicationSystemUtil::AddDependentActor(Parent, Child);
+		}
+		else
+		{
+			FReplicationSystemUtil::RemoveDependentActor(Parent, Child);
+		}
+#endif
+	}
+}
@@ -0,0 +1,572 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Server/MatchSnapshotSubsystem.h"
+#include "Character/SpartanCharacter.h"
+#include "SpartanComponents/CombatComponent.h"
+#include "GameState/MPShooterGameState.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "Weapon/Projectile.h"
+#include "MPShooterGameModeBase.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Networking/MPShooterIris.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Match Snapshot"), STAT_MPShooter_MatchSnapshot, STATGROUP_MPShooter);
+DECLARE_CYCLE_STAT(TEXT("Match Snapshot Restore"), STAT_MPShooter_MatchSnapshotRestore, STATGROUP_MPShooter);
+
+static TAutoConsoleVariable<float> CVarSnapshotInterval(
+	TEXT("MPShooter.Snapshot.Interval"),
+	10.f,
+	TEXT("Dedicated server: seconds between match snapshots written to Saved/MatchSnapshots, 0 to stop taking them."));
+
+static TAutoConsoleVariable<float> CVarSnapshotPendingPlayerTimeout(
+	TEXT("MPShooter.Snapshot.PendingPlayerTimeout"),
+	300.f,
+	TEXT("Dedicated server: seconds a restored player has to come back before their record is dropped (their weapons stay where they are)."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdSaveSnapshot(
+	TEXT("MPShooter.Snapshot.Save"),
+	TEXT("Dedicated server: snapshots the match now and waits for the file. Run it before stopping a server to patch it."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UMatchSnapshotSubsystem* Snapshots = World ? World->GetSubsystem<UMatchSnapshotSubsystem>() : nullptr)
+		{
+			Snapshots->SaveSnapshot(true);
+			UE_LOG(LogTemp, Display, TEXT("MatchSnapshot: saved %s"), *Snapshots->GetSnapshotPath());
+		}
+	}));
+
+namespace MatchSnapshots
+{
+	static constexpr double PendingPlayerCheckInterval = 0.5;
+	static constexpr double RestoreTravelTimeout = 60.0; // a non-seamless travel leaves the booted world on its next frame
+
+	// -RestoreSnapshot is honored once per process: by the first gameplay world, after at most one travel to the snapshot's map
+	enum class ERestoreState : uint8
+	{
+		Unknown,
+		Pending,
+		Travelled,
+		Done
+	};
+	static ERestoreState RestoreState = ERestoreState::Unknown;
+
+	struct FReportCounts
+	{
+		FString MapName;
+		int32 Players;
+		int32 Weapons;
+		int32 Projectiles;
+
+		explicit FReportCounts(const FMatchSnapshot& Snapshot)
+			: MapName(Snapshot.MapName), Players(Snapshot.Players.Num()), Weapons(Snapshot.Weapons.Num()), Projectiles(Snapshot.Projectiles.Num())
+		{
+		}
+	};
+
+	static void AppendCsv(const TCHAR* Kind, const FReportCounts& Counts, int32 Bytes, double GameThreadMs, double FileMs, int32 Skipped)
+	{
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("Snapshot.csv")), TEXT("Time,Kind,Map,Players,Weapons,Projectiles,Bytes,GameThreadMs,FileMs,Skipped"),
+			FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%.4f,%.4f,%d") LINE_TERMINATOR, *FMPShooterCsv::Now(), Kind, *Counts.MapName,
+			Counts.Players, Counts.Weapons, Counts.Projectiles, Bytes, GameThreadMs, FileMs, Skipped));
+	}
+}
+
+static FArchive& operator<<(FArchive& Ar, FMatchSnapshotPlayer& Player)
+{
+	Ar << Player.Key << Player.Location << Player.ControlRotation << Player.Health << Player.Armor << Player.Kills << Player.Deaths;
+	for (int16& Weapon : Player.Weapons)
+	{
+		Ar << Weapon;
+	}
+	Ar << Player.ActiveSlot << Player.bAlive;
+	return Ar;
+}
+
+static FArchive& operator<<(FArchive& Ar, FMatchSnapshotWeapon& Weapon)
+{
+	Ar << Weapon.ClassIndex << Weapon.PlacedName << Weapon.State << Weapon.Location << Weapon.Rotation << Weapon.LinearVelocity;
+	return Ar;
+}
+
+static FArchive& operator<<(FArchive& Ar, FMatchSnapshotProjectile& Projectile)
+{
+	Ar << Projectile.ClassIndex << Projectile.Location << Projectile.Velocity;
+	return Ar;
+}
+
+bool FMatchSnapshot::Serialize(FArchive& Ar)
+{
+	uint32 Magic = MagicValue;
+	uint32 Version = CurrentVersion;
+	Ar << Magic << Version;
+	if (Magic != MagicValue || Version != CurrentVersion) return false;
+
+	Ar << MapName << WorldTime << UtcTicks << Classes << Players << Weapons << Projectiles;
+	return !Ar.IsError();
+}
+
+uint16 FMatchSnapshot::AddClass(const UClass* Class)
+{
+	return (uint16)Classes.AddUnique(FSoftClassPath(Class).ToString());
+}
+
+bool UMatchSnapshotSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+TStatId UMatchSnapshotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMatchSnapshotSubsystem, STATGROUP_Tickables);
+}
+
+FString UMatchSnapshotSubsystem::GetSnapshotPath() const
+{
+	FString Path;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-SnapshotFile="), Path))
+	{
+		return Path;
+	}
+	const UWorld* World = GetWorld();
+	return FPaths::ProjectSavedDir() / TEXT("MatchSnapshots") / FString::Printf(TEXT("Server_%d.snap"), World ? World->URL.Port : 0); // one per port, for several servers on a machine
+}
+
+FString UMatchSnapshotSubsystem::GetPlayerKey(const APlayerState* PlayerState)
+{
+	if (PlayerState == nullptr) return FString();
+
+	const FUniqueNetIdRepl& UniqueId = PlayerState->GetUniqueId();
+	return UniqueId.IsValid() ? UniqueId.ToString() : PlayerState->GetPlayerName();
+}
+
+void UMatchSnapshotSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	using namespace MatchSnapshots;
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() != NM_DedicatedServer) return; // a listen server's match ends with its host anyway
+
+	bActive = InWorld.GetAuthGameMode<AMPShooterGameModeBase>() != nullptr; // the gameplay map, not the lobby
+	NextSnapshotTime = FPlatformTime::Seconds() + CVarSnapshotInterval.GetValueOnGameThread();
+
+	if (RestoreState == ERestoreState::Unknown)
+	{
+		RestoreState = FParse::Param(FCommandLine::Get(), TEXT("RestoreSnapshot")) ? ERestoreState::Pending : ERestoreState::Done;
+	}
+	if (RestoreState == ERestoreState::Done) return;
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FString Path = GetSnapshotPath();
+	TArray<uint8> Bytes;
+	FMatchSnapshot Snapshot;
+	const bool bLoaded = FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent);
+	FMemoryReader Reader(Bytes);
+	if (!bLoaded || !Snapshot.Serialize(Reader))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MatchSnapshot: no usable snapshot at %s, starting a new match"), *Path);
+		RestoreState = ERestoreState::Done;
+		return;
+	}
+	const double LoadMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	if (Snapshot.MapName != InWorld.GetOutermost()->GetName())
+	{
+		if (RestoreState == ERestoreState::Pending)
+		{
+			UE_LOG(LogTemp, Display, TEXT("MatchSnapshot: travelling to %s to restore the match"), *Snapshot.MapName);
+			RestoreState = ERestoreState::Travelled;
+			RestoreTravelDeadline = FPlatformTime::Seconds() + RestoreTravelTimeout;
+			TravelFailureHandle = GEngine->OnTravelFailure().AddUObject(this, &UMatchSnapshotSubsystem::OnTravelFailure);
+			if (!InWorld.ServerTravel(Snapshot.MapName)) // straight to the gameplay map, no lobby
+			{
+				AbandonRestoreTravel(TEXT("ServerTravel refused it"));
+			}
+			return;
+		}
+		UE_LOG(LogTemp, Warning, TEXT("MatchSnapshot: snapshot is of %s but the server is on %s, not restoring"), *Snapshot.MapName, *InWorld.GetOutermost()->GetName());
+		RestoreState = ERestoreState::Done;
+		return;
+	}
+	RestoreState = ERestoreState::Done;
+	if (!bActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MatchSnapshot: %s isn't running the gameplay game mode, not restoring"), *Snapshot.MapName);
+		return;
+	}
+
+	const double RestoreStartTime = FPlatformTime::Seconds();
+	Restore(Snapshot);
+	const double RestoreMs = (FPlatformTime::Seconds() - RestoreStartTime) * 1000.0;
+	const double AgeSeconds = double(FDateTime::UtcNow().GetTicks() - Snapshot.UtcTicks) / ETimespan::TicksPerSecond;
+	UE_LOG(LogTemp, Display, TEXT("MatchSnapshot: restored %s (%.0f s old, match time %.0f s): %d players, %d weapons, %d projectiles in %.2f ms (%.2f ms load, %.2f ms apply)"),
+		*Snapshot.MapName, AgeSeconds, Snapshot.WorldTime, Snapshot.Players.Num(), Snapshot.Weapons.Num(), Snapshot.Projectiles.Num(), LoadMs + RestoreMs, LoadMs, RestoreMs);
+	AppendCsv(TEXT("Restore"), FReportCounts(Snapshot), Bytes.Num(), RestoreMs, LoadMs, 0);
+}
+
+void UMatchSnapshotSubsystem::OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString)
+{
+	AbandonRestoreTravel(*ErrorString);
+}
+
+void UMatchSnapshotSubsystem::AbandonRestoreTravel(const TCHAR* Reason)
+{
+	using namespace MatchSnapshots;
+	GEngine->OnTravelFailure().Remove(TravelFailureHandle);
+	TravelFailureHandle.Reset();
+	RestoreTravelDeadline = 0.0;
+	if (RestoreState != ERestoreState::Travelled) return;
+
+	// Otherwise the end of this match would keep the snapshot (Deinitialize takes Travelled for the restore's own travel)
+	UE_LOG(LogTemp, Warning, TEXT("MatchSnapshot: the travel to restore the match failed (%s), not restoring"), Reason);
+	RestoreState = ERestoreState::Done;
+}
+
+void UMatchSnapshotSubsystem::Deinitialize()
+{
+	WriteTask.Wait(); // the last snapshot makes it to disk
+	if (TravelFailureHandle.IsValid())
+	{
+		GEngine->OnTravelFailure().Remove(TravelFailureHandle);
+		TravelFailureHandle.Reset();
+	}
+	if (bActive && !IsEngineExitRequested() && MatchSnapshots::RestoreState != MatchSnapshots::ERestoreState::Travelled) // the travel is to restore it
+	{
+		IFileManager::Get().Delete(*GetSnapshotPath(), false, false, true); // the match is over (travel), there's nothing left to restore
+	}
+	PendingPlayers.Reset();
+	Super::Deinitialize();
+}
+
+void UMatchSnapshotSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	const double Now = FPlatformTime::Seconds();
+	if (RestoreTravelDeadline > 0.0 && Now >= RestoreTravelDeadline)
+	{
+		AbandonRestoreTravel(TEXT("still on the booted map"));
+	}
+	if (!bActive) return;
+
+	if (PendingPlayers.Num() > 0 && Now >= NextPendingCheckTime)
+	{
+		NextPendingCheckTime = Now + MatchSnapshots::PendingPlayerCheckInterval;
+		RestorePendingPlayers();
+		ExpirePendingPlayers(Now);
+	}
+
+	const float Interval = CVarSnapshotInterval.GetValueOnGameThread();
+	if (Interval > 0.f && Now >= NextSnapshotTime)
+	{
+		NextSnapshotTime = Now + Interval;
+		SaveSnapshot(false);
+	}
+}
+
+void UMatchSnapshotSubsystem::SaveSnapshot(bool bWait)
+{
+	if (!bActive) return;
+	if (!WriteTask.IsCompleted())
+	{
+		if (!bWait)
+		{
+			SkippedSnapshots++;
+			return;
+		}
+		WriteTask.Wait();
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_MatchSnapshot);
+	const double StartTime = FPlatformTime::Seconds();
+	FMatchSnapshot Snapshot;
+	Capture(Snapshot);
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Snapshot.Serialize(Writer);
+	const double CaptureMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	WriteTask = UE::Tasks::Launch(TEXT("MatchSnapshotWrite"),
+		[Counts = MatchSnapshots::FReportCounts(Snapshot), Bytes = MoveTemp(Bytes), Path = GetSnapshotPath(), CaptureMs, Skipped = SkippedSnapshots]()
+		{
+			const double WriteStartTime = FPlatformTime::Seconds();
+			const FString TempPath = Path + TEXT(".tmp");
+			const bool bWritten = FFileHelper::SaveArrayToFile(Bytes, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true, true); // dying mid-write leaves the previous snapshot
+			const double WriteMs = (FPlatformTime::Seconds() - WriteStartTime) * 1000.0;
+			if (!bWritten)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("MatchSnapshot: could not write %s"), *Path);
+			}
+			UE_LOG(LogTemp, Log, TEXT("MatchSnapshot: %d bytes, %.3f ms capture (game thread), %.3f ms write"), Bytes.Num(), CaptureMs, WriteMs);
+			MatchSnapshots::AppendCsv(TEXT("Save"), Counts, Bytes.Num(), CaptureMs, WriteMs, Skipped);
+		}, UE::Tasks::ETaskPriority::BackgroundNormal);
+	SkippedSnapshots = 0;
+
+	if (bWait)
+	{
+		WriteTask.Wait();
+	}
+}
+
+void UMatchSnapshotSubsystem::Capture(FMatchSnapshot& Snapshot) const
+{
+	UWorld* World = GetWorld();
+	Snapshot.MapName = World->GetOutermost()->GetName();
+	Snapshot.WorldTime = World->GetTimeSeconds();
+	Snapshot.UtcTicks = FDateTime::UtcNow().GetTicks();
+
+	TMap<const AWeapon*, int32> WeaponIndices;
+	for (TActorIterator<AWeapon> It(World); It; ++It)
+	{
+		const AWeapon* Weapon = *It;
+		if (Weapon->IsActorBeingDestroyed()) continue;
+
+		WeaponIndices.Add(Weapon, Snapshot.Weapons.Num());
+		FMatchSnapshotWeapon& Record = Snapshot.Weapons.AddDefaulted_GetRef();
+		Record.ClassIndex = Snapshot.AddClass(Weapon->GetClass());
+		Record.PlacedName = Weapon->IsNetStartupActor() ? Weapon->GetFName() : NAME_None;
+		Record.State = (uint8)Weapon->GetWeaponState();
+		Record.Location = FVector3f(Weapon->GetActorLocation());
+		Record.Rotation = FRotator3f(Weapon->GetActorRotation());
+		if (Weapon->GetWeaponState() == EWeaponState::EWS_Dropped)
+		{
+			Record.LinearVelocity = FVector3f(Weapon->GetWeaponMesh()->GetPhysicsLinearVelocity());
+		}
+	}
+
+	const AMPShooterGameState* GameState = World->GetGameState<AMPShooterGameState>();
+	if (GameState)
+	{
+		for (const APlayerState* PlayerState : GameState->PlayerArray)
+		{
+			const FString Key = GetPlayerKey(PlayerState);
+			if (Key.IsEmpty()) continue;
+
+			FMatchSnapshotPlayer& Record = Snapshot.Players.AddDefaulted_GetRef();
+			Record.Key = Key;
+			if (const FPlayerCombatStats* Stats = GameState->GetCombatStats(PlayerState))
+			{
+				Record.Health = Stats->Health;
+				Record.Armor = Stats->Armor;
+				Record.Kills = Stats->Kills;
+				Record.Deaths = Stats->Deaths;
+			}
+			const ASpartanCharacter* Character = PlayerState->GetPawn<ASpartanCharacter>();
+			Record.bAlive = Character && !Character->IsEliminated() && Record.Health > 0.f;
+			if (!Record.bAlive) continue;
+
+			Record.Location = FVector3f(Character->GetActorLocation());
+			Record.ControlRotation = FRotator3f(Character->GetController() ? Character->GetController()->GetControlRotation() : Character->GetActorRotation());
+			if (const UCombatComponent* Combat = Character->GetCombat())
+			{
+				for (int32 Slot = 0; Slot < (int32)EInventorySlot::EIS_MAX; ++Slot)
+				{
+					const int32* WeaponIndex = WeaponIndices.Find(Combat->GetWeaponInSlot((EInventorySlot)Slot));
+					Record.Weapons[Slot] = (int16)(WeaponIndex ? *WeaponIndex : INDEX_NONE);
+				}
+				Record.ActiveSlot = (uint8)Combat->GetActiveSlot();
+			}
+		}
+	}
+
+	// Restored players who haven't come back keep their place in the next snapshot too
+	for (const TPair<FString, FPendingPlayer>& Pending : PendingPlayers)
+	{
+		FMatchSnapshotPlayer& Record = Snapshot.Players.Add_GetRef(Pending.Value.Record);
+		for (int32 Slot = 0; Slot < (int32)EInventorySlot::EIS_MAX; ++Slot)
+		{
+			const AWeapon* Weapon = Pending.Value.Weapons[Slot].Get();
+			const int32* WeaponIndex = Weapon && Weapon->CanBePickedUp() ? WeaponIndices.Find(Weapon) : nullptr;
+			Record.Weapons[Slot] = (int16)(WeaponIndex ? *WeaponIndex : INDEX_NONE);
+		}
+	}
+
+	for (TActorIterator<AProjectile> It(World); It; ++It)
+	{
+		const AProjectile* Projectile = *It;
+		if (Projectile->IsActorBeingDestroyed() || Projectile->GetProjectileMovement() == nullptr) continue;
+
+		FMatchSnapshotProjectile& Record = Snapshot.Projectiles.AddDefaulted_GetRef();
+		Record.ClassIndex = Snapshot.AddClass(Projectile->GetClass());
+		Record.Location = FVector3f(Projectile->GetActorLocation());
+		Record.Velocity = FVector3f(Projectile->GetProjectileMovement()->Velocity);
+	}
+}
+
+void UMatchSnapshotSubsystem::Restore(const FMatchSnapshot& Snapshot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_MatchSnapshotRestore);
+	UWorld* World = GetWorld();
+
+	TArray<UClass*> Classes;
+	for (const FString& ClassPath : Snapshot.Classes)
+	{
+		Classes.Add(FSoftClassPath(ClassPath).TryLoadClass<AActor>());
+	}
+	auto FindClass = [&Classes](uint16 Index) { return Classes.IsValidIndex(Index) ? Classes[Index] : nullptr; };
+
+	TMap<FName, AWeapon*> PlacedWeapons;
+	for (TActorIterator<AWeapon> It(World); It; ++It)
+	{
+		if (It->IsNetStartupActor())
+		{
+			PlacedWeapons.Add(It->GetFName(), *It);
+		}
+	}
+
+	int32 Missing = 0;
+	TArray<AWeapon*> Weapons;
+	for (const FMatchSnapshotWeapon& Record : Snapshot.Weapons)
+	{
+		const FTransform Transform(FRotator(Record.Rotation), FVector(Record.Location));
+		AWeapon* Weapon = Record.PlacedName.IsNone() ? nullptr : PlacedWeapons.FindRef(Record.PlacedName);
+		UClass* WeaponClass = FindClass(Record.ClassIndex);
+		if (Weapon)
+		{
+			Weapon->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		}
+		else if (WeaponClass && WeaponClass->IsChildOf<AWeapon>())
+		{
+			Weapon = World->SpawnActor<AWeapon>(WeaponClass, Transform);
+		}
+		Weapons.Add(Weapon);
+		if (Weapon == nullptr)
+		{
+			Missing++;
+			continue;
+		}
+		if ((EWeaponState)Record.State != EWeaponState::EWS_Initial) // carried weapons wait on the floor for their owner to come back
+		{
+			Weapon->SetWeaponState(EWeaponState::EWS_Dropped);
+			Weapon->GetWeaponMesh()->SetPhysicsLinearVelocity(FVector(Record.LinearVelocity));
+		}
+	}
+
+	for (const FMatchSnapshotProjectile& Record : Snapshot.Projectiles)
+	{
+		UClass* ProjectileClass = FindClass(Record.ClassIndex);
+		const FVector Velocity(Record.Velocity);
+		if (ProjectileClass == nullptr || !ProjectileClass->IsChildOf<AProjectile>() || Velocity.IsNearlyZero())
+		{
+			Missing++;
+			continue;
+		}
+		// No owner or instigator, the shooter isn't back yet: hits still do damage, they just aren't credited
+		AProjectile* Projectile = World->SpawnActorDeferred<AProjectile>(ProjectileClass, FTransform(Velocity.Rotation(), FVector(Record.Location)));
+		if (Projectile == nullptr) continue;
+
+		UProjectileMovementComponent* Movement = Projectile->GetProjectileMovement();
+		Movement->bInitialVelocityInLocalSpace = false;
+		Movement->Velocity = Velocity.GetSafeNormal();
+		Movement->InitialSpeed = Velocity.Size(); // InitializeComponent scales the direction by this, before BeginPlay registers the flight
+		Projectile->FinishSpawning(FTransform(Velocity.Rotation(), FVector(Record.Location)));
+	}
+
+	const double ExpireTime = FPlatformTime::Seconds() + CVarSnapshotPendingPlayerTimeout.GetValueOnGameThread();
+	for (const FMatchSnapshotPlayer& Record : Snapshot.Players)
+	{
+		FPendingPlayer& Pending = PendingPlayers.Add(Record.Key);
+		Pending.Record = Record;
+		Pending.ExpireTime = ExpireTime;
+		for (int32 Slot = 0; Slot < (int32)EInventorySlot::EIS_MAX; ++Slot)
+		{
+			Pending.Weapons[Slot] = Weapons.IsValidIndex(Record.Weapons[Slot]) ? Weapons[Record.Weapons[Slot]] : nullptr;
+		}
+	}
+	RestorePendingPlayers();
+
+	if (Missing > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MatchSnapshot: %d weapons / projectiles could not be restored (class missing)"), Missing);
+	}
+}
+
+void UMatchSnapshotSubsystem::RestorePendingPlayers()
+{
+	UWorld* World = GetWorld();
+	AMPShooterGameState* GameState = World->GetGameState<AMPShooterGameState>();
+	for (FConstControllerIterator It = World->GetControllerIterator(); It && PendingPlayers.Num() > 0; ++It)
+	{
+		AController* Controller = It->Get();
+		ASpartanCharacter* Character = Controller ? Cast<ASpartanCharacter>(Controller->GetPawn()) : nullptr;
+		if (Character == nullptr || Character->IsEliminated() || Controller->PlayerState == nullptr) continue;
+
+		FPendingPlayer Pending;
+		if (!PendingPlayers.RemoveAndCopyValue(GetPlayerKey(Controller->PlayerState), Pending)) continue;
+
+		const FMatchSnapshotPlayer& Record = Pending.Record;
+		if (GameState)
+		{
+			GameState->RestoreScore(Controller->PlayerState, Record.Kills, Record.Deaths);
+		}
+		if (!Record.bAlive) continue; // they were waiting to respawn, the spawn they just had will do
+
+		const FRotator ControlRotation(Record.ControlRotation);
+		Character->TeleportTo(FVector(Record.Location), FRotator(0.f, ControlRotation.Yaw, 0.f)); // stays at the player start if someone's standing there
+		Controller->SetControlRotation(ControlRotation);
+		Controller->ClientSetRotation(ControlRotation, true);
+		if (GameState)
+		{
+			GameState->RestoreHealth(Controller->PlayerState, Record.Health, Record.Armor);
+		}
+
+		UCombatComponent* Combat = Character->GetCombat();
+		if (Combat == nullptr) continue;
+
+		// Straight back into the slots they were in, the way EquipWeapon fills one; EquipWeapon would pick the slot itself
+		for (int32 Slot = 0; Slot < (int32)EInventorySlot::EIS_MAX; ++Slot)
+		{
+			AWeapon* Weapon = Pending.Weapons[Slot].Get();
+			if (Weapon == nullptr || !Weapon->CanBePickedUp() || Combat->WeaponSlots.Contains(Weapon)) continue; // unless someone else took it meanwhile
+
+			if (AWeapon* Spawned = Combat->WeaponSlots[Slot])
+			{
+				Spawned->Dropped();
+			}
+			Combat->WeaponSlots[Slot] = Weapon;
+			Weapon->SetWeaponState(EWeaponState::EWS_Equipped);
+			Weapon->SetOwner(Character);
+			MPShooterIris::SetReplicatesWith(Character, Weapon, true);
+		}
+		const EInventorySlot ActiveSlot = (EInventorySlot)FMath::Min<uint8>(Record.ActiveSlot, (uint8)EInventorySlot::EIS_MAX - 1);
+		const AWeapon* ActiveWeapon = Pending.Weapons[(int32)ActiveSlot].Get();
+		if (ActiveWeapon && Combat->GetWeaponInSlot(ActiveSlot) == ActiveWeapon)
+		{
+			Combat->ActiveSlot = ActiveSlot;
+			if (!Character->IsLocallyControlled())
+			{
+				Combat->ClientCorrectActiveSlot(ActiveSlot); // ActiveSlot doesn't replicate to the owner
+			}
+		}
+		Combat->RefreshWeaponPreloads();
+		Combat->ApplyActiveSlot(); // server doesn't get the OnReps
+		UE_LOG(LogTemp, Log, TEXT("MatchSnapshot: restored %s"), *Controller->PlayerState->GetPlayerName());
+	}
+}
+
+void UMatchSnapshotSubsystem::ExpirePendingPlayers(double Now)
+{
+	for (auto It = PendingPlayers.CreateIterator(); It; ++It)
+	{
+		if (Now < It.Value().ExpireTime) continue;
+
+		// Not back in time: they'd come back as a new player anyway, and their record would ride along in every snapshot
+		UE_LOG(LogTemp, Log, TEXT("MatchSnapshot: %s didn't come back, dropping their restored state"), *It.Key());
+		It.RemoveCurrent();
+	}
+}
@@ -0,0 +1,284 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Server/ServerTickGovernorSubsystem.h"
+#include "Character/SpartanCharacter.h"
+#include "Weapon/Projectile.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Governor Level"), STAT_MPShooter_GovernorLevel, STATGROUP_MPShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Game ms"), STAT_MPShooter_GovernorGameMs, STATGROUP_MPShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Physics ms"), STAT_MPShooter_GovernorPhysicsMs, STATGROUP_MPShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Net ms"), STAT_MPShooter_GovernorNetMs, STATGROUP_MPShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Tick Rate"), STAT_MPShooter_GovernorTickRate, STATGROUP_MPShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Net Rate Scale"), STAT_MPShooter_GovernorNetRateScale, STATGROUP_MPShooter);
+
+static TAutoConsoleVariable<int32> CVarGovernor(
+	TEXT("MPShooter.Governor"),
+	1,
+	TEXT("Dedicated server: adapt tick rate, net rates, anim rate and projectile substeps to the frame time (1), or hold full fidelity (0)."));
+
+static TAutoConsoleVariable<float> CVarGovernorHighWater(
+	TEXT("MPShooter.Governor.HighWater"),
+	0.9f,
+	TEXT("Step down a level when game + physics + net time stays above this fraction of the frame budget (1 / tick rate)."));
+
+static TAutoConsoleVariable<float> CVarGovernorLowWater(
+	TEXT("MPShooter.Governor.LowWater"),
+	0.6f,
+	TEXT("Step back up a level once the frame would stay below this fraction of the next level's budget."));
+
+static TAutoConsoleVariable<float> CVarGovernorDownHold(
+	TEXT("MPShooter.Governor.DownHold"),
+	0.5f,
+	TEXT("Seconds over the high water mark before stepping down."));
+
+static TAutoConsoleVariable<float> CVarGovernorUpHold(
+	TEXT("MPShooter.Governor.UpHold"),
+	5.f,
+	TEXT("Seconds under the low water mark before stepping up. Much longer than DownHold so a lull in a firefight doesn't flap the settings."));
+
+static TAutoConsoleVariable<float> CVarGovernorMinTickRateScale(
+	TEXT("MPShooter.Governor.MinTickRateScale"),
+	0.5f,
+	TEXT("Lowest NetServerMaxTickRate, as a fraction of the configured one."));
+
+static TAutoConsoleVariable<float> CVarGovernorMinNetRateScale(
+	TEXT("MPShooter.Governor.MinNetRateScale"),
+	0.5f,
+	TEXT("Lowest character / projectile NetUpdateFrequency, as a fraction of the class default."));
+
+static TAutoConsoleVariable<float> CVarGovernorMaxAnimTickInterval(
+	TEXT("MPShooter.Governor.MaxAnimTickInterval"),
+	0.1f,
+	TEXT("Longest character mesh tick interval (seconds) on a dedicated server."));
+
+static TAutoConsoleVariable<float> CVarGovernorMaxProjectileTimeStep(
+	TEXT("MPShooter.Governor.MaxProjectileTimeStep"),
+	0.1f,
+	TEXT("Longest projectile simulation substep (seconds)."));
+
+bool UServerTickGovernorSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() == NM_DedicatedServer; // a listen server's frame rate is its player's
+}
+
+void UServerTickGovernorSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UServerTickGovernorSubsystem::OnWorldTickStart);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UServerTickGovernorSubsystem::OnWorldPostActorTick);
+	PostTickFlushHandle = GetWorld()->OnPostTickFlush().AddUObject(this, &UServerTickGovernorSubsystem::OnPostTickFlush);
+}
+
+void UServerTickGovernorSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	GetWorld()->OnPostTickFlush().Remove(PostTickFlushHandle);
+	if (PhysicsStartMarker.IsTickFunctionRegistered())
+	{
+		GetWorld()->StartPhysicsTickFunction.RemovePrerequisite(this, PhysicsStartMarker);
+	}
+	PhysicsStartMarker.UnRegisterTickFunction();
+	PhysicsEndMarker.UnRegisterTickFunction();
+	Super::Deinitialize();
+}
+
+void UServerTickGovernorSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (const UNetDriver* NetDriver = InWorld.GetNetDriver())
+	{
+		FullTickRate = NetDriver->NetServerMaxTickRate;
+	}
+	Fidelity = GetFidelityForLevel(0);
+
+	// Physics start runs after our start marker, our end marker after physics end
+	PhysicsStartMarker.Governor = this;
+	PhysicsStartMarker.bStart = true;
+	PhysicsStartMarker.bCanEverTick = true;
+	PhysicsStartMarker.TickGroup = TG_StartPhysics;
+	PhysicsStartMarker.RegisterTickFunction(InWorld.PersistentLevel);
+	InWorld.StartPhysicsTickFunction.AddPrerequisite(this, PhysicsStartMarker);
+
+	PhysicsEndMarker.Governor = this;
+	PhysicsEndMarker.bCanEverTick = true;
+	PhysicsEndMarker.TickGroup = TG_EndPhysics;
+	PhysicsEndMarker.RegisterTickFunction(InWorld.PersistentLevel);
+	PhysicsEndMarker.AddPrerequisite(&InWorld, InWorld.EndPhysicsTickFunction);
+}
+
+TStatId UServerTickGovernorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UServerTickGovernorSubsystem, STATGROUP_Tickables);
+}
+
+void UServerTickGovernorSubsystem::FPhysicsMarkerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (bStart)
+	{
+		Governor->OnPhysicsStart();
+	}
+	else
+	{
+		Governor->OnPhysicsEnd();
+	}
+}
+
+void UServerTickGovernorSubsystem::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld()) return;
+	FrameStartTime = FPlatformTime::Seconds();
+	PhysicsMs = 0.0;
+}
+
+void UServerTickGovernorSubsystem::OnPhysicsStart()
+{
+	PhysicsStartTime = FPlatformTime::Seconds();
+}
+
+void UServerTickGovernorSubsystem::OnPhysicsEnd()
+{
+	PhysicsMs = (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0;
+}
+
+void UServerTickGovernorSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld()) return;
+	PostActorTickTime = FPlatformTime::Seconds();
+}
+
+void UServerTickGovernorSubsystem::OnPostTickFlush()
+{
+	if (FrameStartTime == 0.0 || PostActorTickTime < FrameStartTime) return;
+
+	// Replication is everything after the actors ticked: mostly the net driver's TickFlush
+	const double Now = FPlatformTime::Seconds();
+	const float FrameGameMs = float((PostActorTickTime - FrameStartTime) * 1000.0 - PhysicsMs);
+	const float FrameNetMs = float((Now - PostActorTickTime) * 1000.0);
+
+	constexpr float Smoothing = 0.1f;
+	GameMs = FMath::Lerp(GameMs, FrameGameMs, Smoothing);
+	PhysicsMsAvg = FMath::Lerp(PhysicsMsAvg, float(PhysicsMs), Smoothing);
+	NetMs = FMath::Lerp(NetMs, FrameNetMs, Smoothing);
+}
+
+void UServerTickGovernorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_MPShooter_GovernorLevel, Level);
+	SET_FLOAT_STAT(STAT_MPShooter_GovernorGameMs, GameMs);
+	SET_FLOAT_STAT(STAT_MPShooter_GovernorPhysicsMs, PhysicsMsAvg);
+	SET_FLOAT_STAT(STAT_MPShooter_GovernorNetMs, NetMs);
+	SET_FLOAT_STAT(STAT_MPShooter_GovernorTickRate, Fidelity.TickRate);
+	SET_FLOAT_STAT(STAT_MPShooter_GovernorNetRateScale, Fidelity.NetRateScale);
+
+	if (CVarGovernor.GetValueOnGameThread() == 0)
+	{
+		if (Level != 0)
+		{
+			SetLevel(0, TEXT("disabled"));
+		}
+		return;
+	}
+	if (FullTickRate <= 0) return; // no net driver, or the tick rate isn't ours to govern
+
+	const float WorkMs = GameMs + PhysicsMsAvg + NetMs;
+	const float BudgetMs = 1000.f / Fidelity.TickRate;
+
+	if (Level < NumLevels - 1 && WorkMs > BudgetMs * CVarGovernorHighWater.GetValueOnGameThread())
+	{
+		OverBudgetTime += DeltaTime;
+		UnderBudgetTime = 0.f;
+		if (OverBudgetTime >= CVarGovernorDownHold.GetValueOnGameThread())
+		{
+			SetLevel(Level + 1, TEXT("over budget"));
+		}
+		return;
+	}
+	OverBudgetTime = 0.f;
+
+	// Only step up if the shorter frame of the level above would still have plenty of headroom
+	if (Level > 0 && WorkMs < (1000.f / GetFidelityForLevel(Level - 1).TickRate) * CVarGovernorLowWater.GetValueOnGameThread())
+	{
+		UnderBudgetTime += DeltaTime;
+		if (UnderBudgetTime >= CVarGovernorUpHold.GetValueOnGameThread())
+		{
+			SetLevel(Level - 1, TEXT("under budget"));
+		}
+	}
+	else
+	{
+		UnderBudgetTime = 0.f;
+	}
+}
+
+FServerFidelity UServerTickGovernorSubsystem::GetFidelityForLevel(int32 ForLevel) const
+{
+	const float Alpha = float(FMath::Clamp(ForLevel, 0, NumLevels - 1)) / (NumLevels - 1);
+
+	FServerFidelity Result;
+	Result.TickRate = FMath::Max(FMath::RoundToFloat(FMath::Lerp(1.f, CVarGovernorMinTickRateScale.GetValueOnGameThread(), Alpha) * FullTickRate), 1.f);
+	Result.NetRateScale = FMath::Lerp(1.f, CVarGovernorMinNetRateScale.GetValueOnGameThread(), Alpha);
+	Result.AnimTickInterval = FMath::Lerp(0.f, CVarGovernorMaxAnimTickInterval.GetValueOnGameThread(), Alpha);
+	Result.ProjectileMaxTimeStep = FMath::Lerp(0.f, CVarGovernorMaxProjectileTimeStep.GetValueOnGameThread(), Alpha);
+	return Result;
+}
+
+void UServerTickGovernorSubsystem::SetLevel(int32 NewLevel, const TCHAR* Reason)
+{
+	const int32 OldLevel = Level;
+	Level = FMath::Clamp(NewLevel, 0, NumLevels - 1);
+	OverBudgetTime = 0.f;
+	UnderBudgetTime = 0.f;
+	if (Level == OldLevel) return;
+
+	Fidelity = GetFidelityForLevel(Level);
+	ApplyFidelity();
+
+	UE_LOG(LogTemp, Log, TEXT("Server governor %s: level %d -> %d (game %.2f ms, physics %.2f ms, net %.2f ms) tick rate %.0f, net rate x%.2f, anim interval %.3f s, projectile step %.3f s"),
+		Reason, OldLevel, Level, GameMs, PhysicsMsAvg, NetMs, Fidelity.TickRate, Fidelity.NetRateScale, Fidelity.AnimTickInterval, Fidelity.ProjectileMaxTimeStep);
+	WriteCsv(OldLevel, Reason);
+}
+
+void UServerTickGovernorSubsystem::ApplyFidelity()
+{
+	UWorld* World = GetWorld();
+	if (UNetDriver* NetDriver = World->GetNetDriver())
+	{
+		NetDriver->NetServerMaxTickRate = FMath::RoundToInt(Fidelity.TickRate);
+	}
+	for (TActorIterator<ASpartanCharacter> It(World); It; ++It)
+	{
+		It->ApplyServerFidelity(Fidelity);
+	}
+	for (TActorIterator<AProjectile> It(World); It; ++It)
+	{
+		It->ApplyServerFidelity(Fidelity);
+	}
+}
+
+FServerFidelity UServerTickGovernorSubsystem::GetCurrentFidelity(const UWorld* World)
+{
+	const UServerTickGovernorSubsystem* Governor = World ? World->GetSubsystem<UServerTickGovernorSubsystem>() : nullptr;
+	return Governor ? Governor->Fidelity : FServerFidelity();
+}
+
+void UServerTickGovernorSubsystem::WriteCsv(int32 OldLevel, const TCHAR* Reason) const
+{
+	FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("Governor.csv")), TEXT("Time,Frame,Reason,OldLevel,Level,GameMs,PhysicsMs,NetMs,TickRate,NetRateScale,AnimTickInterval,ProjectileMaxTimeStep"),
+		FString::Printf(TEXT("%s,%llu,%s,%d,%d,%.3f,%.3f,%.3f,%.0f,%.3f,%.3f,%.3f") LINE_TERMINATOR, *FMPShooterCsv::Now(), GFrameCounter, Reason,
+		OldLevel, Level, GameMs, PhysicsMsAvg, NetMs, Fidelity.TickRate, Fidelity.NetRateScale, Fidelity.AnimTickInterval, Fidelity.ProjectileMaxTimeStep));
+}
@@ -5,68 +5,285 @@
 #include "Engine/SkeletalMeshSocket.h"
 #include "Net/UnrealNetwork.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "SpartanComponents/SpartanMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
 #include "DrawDebugHelpers.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+#include "Combat/ShotValidationSubsystem.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "Instrumentation/MatchJournal.h"
+#include "Instrumentation/AllocationTrackerSubsystem.h"
+#include "Instrumentation/LatencyHarnessSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Networking/MPShooterIris.h"
 
+static TAutoConsoleVariable<int32> CVarPredictFireCosmetics(
+	TEXT("MPShooter.PredictFireCosmetics"),
+	1,
+	TEXT("1: the shooter plays its own fire cosmetics immediately. 0: wait for the server's result (for latency comparisons)."));
+
+static TAutoConsoleVariable<int32> CVarShotAllocBudget(
+	TEXT("MPShooter.AllocBudget.Shot"),
+	6,
+	TEXT("UObjects a validated server shot may construct (projectile actor and its components) before it counts as a budget violation."));
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Swap"), STAT_MPShooter_WeaponSwap, STATGROUP_MPShooter);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdFireLatency(
+	TEXT("MPShooter.FireLatency"),
+	TEXT("Prints input-to-muzzle and input-to-confirm latency for local shooters. Pass 'reset' to clear."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		for (TObjectIterator<UCombatComponent> It; It; ++It)
+		{
+			const APawn* Pawn = Cast<APawn>(It->GetOwner());
+			if (It->GetWorld() != World || Pawn == nullptr || !Pawn->IsLocallyControlled()) continue;
+
+			const UCombatComponent::FFireLatency* FireLatency = It->GetFireLatency();
+			if (FireLatency == nullptr) continue; // hasn't fired yet
+
+			UE_LOG(LogTemp, Display, TEXT("%s input->muzzle: %s"), *Pawn->GetName(), *FireLatency->InputToMuzzle.ToString());
+			UE_LOG(LogTemp, Display, TEXT("%s input->confirm: %s, rejected: %u"), *Pawn->GetName(), *FireLatency->InputToConfirm.ToString(), It->GetRejectedShots());
+			if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+			{
+				It->ResetFireLatency();
+			}
+		}
+	}));
+
+
+void FHitMarkerBatch::Add(float Damage, bool bKilled)
+{
+	NumHits = FMath::Min<int32>(NumHits + 1, 63);
+	NumKills = FMath::Min<int32>(NumKills + (bKilled ? 1 : 0), 7);
+	TotalDamage = FMath::Min<int32>(TotalDamage + FMath::RoundToInt32(Damage), 16383);
+}
+
+bool FHitMarkerBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// 6 + 3 + 14 bits instead of 4 bytes
+	uint32 PackedHits = NumHits;
+	uint32 PackedKills = NumKills;
+	uint32 PackedDamage = TotalDamage;
+	Ar.SerializeBits(&PackedHits, 6);
+	Ar.SerializeBits(&PackedKills, 3);
+	Ar.SerializeBits(&PackedDamage, 14);
+	if (Ar.IsLoading())
+	{
+		NumHits = (uint8)PackedHits;
+		NumKills = (uint8)PackedKills;
+		TotalDamage = (uint16)PackedDamage;
+	}
+	bOutSuccess = true;
+	return true;
+}
 
 UCombatComponent::UCombatComponent()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Combat);
 
 	PrimaryComponentTick.bCanEverTick = true;
 
 	BaseWalkSpeed = 600.f;
 	AimWalkSpeed = 425.f;
+
+	WeaponSlots.SetNum((int32)EInventorySlot::EIS_MAX);
+	ActiveSlot = EInventorySlot::EIS_Primary;
+	HandSocketName = FName("RightHandSocket");
+	HolsterSocketName = FName("HolsterSocket");
+
+	LastFirePredictionKey = 0;
+	HostFireInputTime = 0.0;
+	RejectedShots = 0;
+	LastHitMarkerTime = -1.f;
+
+	FireCosmeticAlwaysRadius = 2000.f;
+	FireCosmeticViewRadius = 15000.f;
+	FireCosmeticViewConeDegrees = 100.f;
+	GunfireAudibleRadius = 30000.f;
 }
 
 void UCombatComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	LLM_SCOPE_BYTAG(MPShooter_Combat);
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!PendingHitMarkers.IsEmpty())
+	{
+		ClientHitMarkers(PendingHitMarkers); // at most one per frame, however many hits landed
+		PendingHitMarkers = FHitMarkerBatch();
+	}
+}
+
+void UCombatComponent::AddHitMarker(float Damage, bool bKilled)
+{
+	PendingHitMarkers.Add(Damage, bKilled);
+}
+
+void UCombatComponent::ClientHitMarkers_Implementation(const FHitMarkerBatch& HitMarkers)
+{
+	LastHitMarkers = HitMarkers;
+	LastHitMarkerTime = GetWorld()->GetTimeSeconds();
 }
 
 void UCombatComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	{
 		Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-		DOREPLIFETIME(UCombatComponent, EquippedWeapon);
+		DOREPLIFETIME(UCombatComponent, WeaponSlots);
+		DOREPLIFETIME_CONDITION(UCombatComponent, ActiveSlot, COND_SkipOwner); // the owner predicts it; server side changes go through ClientCorrectActiveSlot
 		DOREPLIFETIME(UCombatComponent, bAiming);
 	}
 }
 
 void UCombatComponent::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Combat);
 	Super::BeginPlay();
 
 	if (Character)
 	{
 		Character->GetCharacterMovement()->MaxWalkSpeed = BaseWalkSpeed;
+		if (USpartanMovementComponent* Movement = Character->GetSpartanMovement())
+		{
+			Movement->AimWalkSpeed = AimWalkSpeed;
+		}
 	}
 	
 }
 
 void UCombatComponent::SetAiming(bool bIsAiming)
+{
+	if (bAiming != bIsAiming && Character && Character->HasAuthority())
 	{
+		FMatchJournal::Record(bIsAiming ? EMatchJournalEvent::AimStart : EMatchJournalEvent::AimStop, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(Character), Character->GetActorLocation());
+	}
 	bAiming = bIsAiming;
-	ServerSetAiming(bIsAiming);
 	if (Character)
 	{
-		Character->GetCharacterMovement() -> MaxWalkSpeed = bIsAiming ? AimWalkSpeed : BaseWalkSpeed;
+		if (USpartanMovementComponent* Movement = Character->GetSpartanMovement())
+		{
+			Movement->SetWantsToAim(bIsAiming); // Goes to the server with the next saved move, which also updates bAiming there
+		}
 	}
+}
+
+void UCombatComponent::OnRep_WeaponSlots()
+{
+	RefreshWeaponPreloads();
+	ApplyActiveSlot();
+}
+
+void UCombatComponent::OnRep_ActiveSlot()
+{
+	ApplyActiveSlot();
+}
+
+void UCombatComponent::SwapWeapons()
+{
+	if (Character == nullptr) return;
+	const EInventorySlot OtherSlot = ActiveSlot == EInventorySlot::EIS_Primary ? EInventorySlot::EIS_Secondary : EInventorySlot::EIS_Primary;
+	if (WeaponSlots[(int32)OtherSlot] == nullptr) return;
+
+	SetActiveSlot(OtherSlot); // right away, the weapon is already loaded and attached to us
+	if (!Character->HasAuthority())
+	{
+		ServerSetActiveSlot(OtherSlot);
 	}
+}
 
-void UCombatComponent::ServerSetAiming_Implementation(bool bIsAiming)
+void UCombatComponent::ServerSetActiveSlot_Implementation(EInventorySlot Slot)
 {
-	bAiming = bIsAiming;
-	if (Character)
+	if (Slot >= EInventorySlot::EIS_MAX || WeaponSlots[(int32)Slot] == nullptr)
 	{
-		Character->GetCharacterMovement()->MaxWalkSpeed = bIsAiming ? AimWalkSpeed : BaseWalkSpeed;
+		ClientCorrectActiveSlot(ActiveSlot);
+		return;
 	}
+	SetActiveSlot(Slot);
 }
 
-void UCombatComponent::OnRep_EquippedWeapon()
+void UCombatComponent::ClientCorrectActiveSlot_Implementation(EInventorySlot Slot)
 {
-	if(EquippedWeapon && Character)
-	Character->GetCharacterMovement()->bOrientRotationToMovement = false;
-	Character->bUseControllerRotationYaw = true;
+	ActiveSlot = Slot;
+	ApplyActiveSlot();
+}
+
+void UCombatComponent::ClientStopAiming_Implementation()
+{
+	SetAiming(false); // also what the aim camera and the anim blueprint read, and the next saved move tells the server
+}
+
+void UCombatComponent::SetActiveSlot(EInventorySlot Slot)
+{
+	if (Slot == ActiveSlot) return;
+	ActiveSlot = Slot;
+	bFireButtonPressed = false;
+	ApplyActiveSlot();
+	if (Character && Character->HasAuthority())
+	{
+		FMatchJournal::Record(EMatchJournalEvent::Equip, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(Character), Character->GetActorLocation(), 0.f, 0, 1); // Aux 1: swap
+	}
+}
+
+void UCombatComponent::ApplyActiveSlot()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_WeaponSwap);
+	if (Character == nullptr) return;
+
+	AWeapon* ActiveWeapon = WeaponSlots[(int32)ActiveSlot];
+	for (AWeapon* Weapon : WeaponSlots)
+	{
+		if (Weapon && Weapon->GetWeaponState() == EWeaponState::EWS_Equipped)
+		{
+			AttachWeaponToSocket(Weapon, Weapon == ActiveWeapon ? HandSocketName : HolsterSocketName);
+		}
+	}
+	EquippedWeapon = ActiveWeapon;
+
+	// Holding a weapon we face where we aim, otherwise where we move
+	Character->GetCharacterMovement()->bOrientRotationToMovement = EquippedWeapon == nullptr;
+	Character->bUseControllerRotationYaw = EquippedWeapon != nullptr;
+}
+
+void UCombatComponent::AttachWeaponToSocket(AWeapon* Weapon, FName SocketName)
+{
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	if (Weapon->GetAttachParentActor() == Character && Weapon->GetAttachParentSocketName() == SocketName) return;
+
+	const USkeletalMeshSocket* Socket = Mesh->GetSocketByName(SocketName);
+	if (Socket == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s: no socket '%s' on %s, %s left where it is"), *GetNameSafe(Character), *SocketName.ToString(), *GetNameSafe(Mesh->GetSkeletalMeshAsset()), *Weapon->GetName());
+		return;
+	}
+	Socket->AttachActor(Weapon, Mesh);
+}
+
+void UCombatComponent::RefreshWeaponPreloads()
+{
+	for (int32 Slot = 0; Slot < WeaponSlots.Num(); ++Slot)
+	{
+		AWeapon* Weapon = WeaponSlots[Slot];
+		if (PreloadedWeapons[Slot].Get() == Weapon) continue;
+		PreloadedWeapons[Slot] = Weapon;
+		PreloadHandles[Slot].Reset();
+		if (Weapon == nullptr) continue;
+
+		TArray<FSoftObjectPath> Assets;
+		Weapon->GetPreloadAssets(Assets);
+		if (Assets.Num() > 0)
+		{
+			PreloadHandles[Slot] = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+		}
+		if (GetNetMode() != NM_DedicatedServer)
+		{
+			Weapon->GetWeaponMesh()->PrestreamTextures(5.f, true); // full mips before it comes out of the holster
+		}
+	}
 }
 
 void UCombatComponent::FireButtonPressed(bool bPressed)
@@ -75,9 +292,34 @@ void UCombatComponent::FireButtonPressed(bool bPressed)
 
 	if (bFireButtonPressed)
 	{
+		const double InputTime = FPlatformTime::Seconds(); // same clock as the muzzle flash and confirm ends
 		FHitResult HitResult;
 		TraceUnderCrosshairs(HitResult);
-		ServerFire(HitResult.ImpactPoint);
+		if (Character && Character->HasAuthority())
+		{
+			HostFireInputTime = GetOrCreateFireLatency() ? InputTime : 0.0; // the muzzle flash plays when this frame's shot batch is applied
+			ServerFire(HitResult.ImpactPoint, 0); // Runs right here, no prediction needed
+			return;
+		}
+
+		// Our own shot is keyed so the server's answer can be matched to it; the server never echoes the cosmetics back to us.
+		LastFirePredictionKey = LastFirePredictionKey == MAX_uint16 ? 1 : LastFirePredictionKey + 1;
+		ULatencyHarnessSubsystem::RecordStage(ELatencyHarnessStage::ClientInput, FMatchJournal::GetPlayerId(Character), LastFirePredictionKey);
+		const bool bPredict = CVarPredictFireCosmetics.GetValueOnGameThread() != 0;
+		if (bPredict)
+		{
+			PlayFire(HitResult.ImpactPoint);
+			if (FFireLatency* Latency = GetOrCreateFireLatency())
+			{
+				Latency->InputToMuzzle.Add((FPlatformTime::Seconds() - InputTime) * 1000.0);
+			}
+		}
+		if (PendingShots.Num() >= 32) // results are unreliable, don't let lost ones pile up
+		{
+			PendingShots.RemoveAt(0, 1, EAllowShrinking::No);
+		}
+		PendingShots.Add({ LastFirePredictionKey, InputTime, bPredict });
+		ServerFire(HitResult.ImpactPoint, LastFirePredictionKey);
 	}
 	
 }
@@ -92,50 +334,337 @@ void UCombatComponent::TraceUnderCrosshairs(FHitResult& TraceHitResult)
 	FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
 	FVector CorsshairWorldPosition;
 	FVector CrosshairWorldDirection;
-	bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation, CorsshairWorldPosition, CrosshairWorldDirection);
+	bool bScreenToWorld = false;
+	FCollisionQueryParams QueryParams;
+	AController* Controller = Character ? Character->GetController() : nullptr;
+	if (Controller && !Controller->IsPlayerController()) // bots: no viewport, they aim down their control rotation from the eyes
+	{
+		FRotator ViewRotation;
+		Controller->GetPlayerViewPoint(CorsshairWorldPosition, ViewRotation);
+		CrosshairWorldDirection = ViewRotation.Vector();
+		QueryParams.AddIgnoredActor(Character); // the trace starts inside our own capsule
+		bScreenToWorld = true;
+	}
+	else
+	{
+		bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation, CorsshairWorldPosition, CrosshairWorldDirection);
+	}
 	// Deproject function: Transforms the Given 2D sceren space coordinate into a 3D world-space point and direction
 	if (bScreenToWorld)
 	{
 		FVector Start = CorsshairWorldPosition;
 		FVector End = Start + CrosshairWorldDirection * TRACE_LENGTH;
 
-		GetWorld()->LineTraceSingleByChannel(TraceHitResult, Start, End, ECollisionChannel::ECC_Visibility);
+		GetWorld()->LineTraceSingleByChannel(TraceHitResult, Start, End, ECollisionChannel::ECC_Visibility, QueryParams);
+		if (!TraceHitResult.bBlockingHit)
+		{
+			TraceHitResult.ImpactPoint = End; // nothing hit, aim at the end of the trace instead of the world origin
+		}
 	}
 
 }
 
-void UCombatComponent::MulticastFire_Implementation(const FVector_NetQuantize& TraceHitTarget)
+void UCombatComponent::PlayFire(const FVector& TraceHitTarget)
 {
+	LLM_SCOPE_BYTAG(MPShooter_Combat);
+	MPSHOOTER_PERF_SCOPE(Effects);
 	if (EquippedWeapon == nullptr) return;
 	if (Character)
 	{
-		Character->PlayFireMontage(bAiming);
+		if (GetNetMode() != NM_DedicatedServer) // nobody to see it
+		{
+			Character->PlayFireMontage(bAiming);
+		}
 		EquippedWeapon->Fire(TraceHitTarget);
 	}
 }
 
-void UCombatComponent::ServerFire_Implementation(const FVector_NetQuantize& TraceHitTarget)
+void UCombatComponent::ServerFire_Implementation(const FVector_NetQuantize& TraceHitTarget, uint16 PredictionKey)
+{
+	LLM_SCOPE_BYTAG(MPShooter_Combat);
+	ULatencyHarnessSubsystem::RecordStage(ELatencyHarnessStage::ServerFire, FMatchJournal::GetPlayerId(Character), PredictionKey);
+	if (FMatchJournal::IsRecording() && Character)
+	{
+		const APlayerState* PlayerState = Character->GetPlayerState();
+		FMatchJournal::Record(EMatchJournalEvent::Fire, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(Character), TraceHitTarget, PlayerState ? PlayerState->GetPingInMilliseconds() : 0.f, 0, PredictionKey);
+	}
+	UShotValidationSubsystem* ShotValidation = GetWorld() ? GetWorld()->GetSubsystem<UShotValidationSubsystem>() : nullptr;
+	if (ShotValidation)
+	{
+		ShotValidation->QueueShot(this, TraceHitTarget, PredictionKey); // validated with the rest of this frame's shots
+	}
+	else
+	{
+		ApplyValidatedShot(TraceHitTarget, PredictionKey, ValidateFire(TraceHitTarget));
+	}
+}
+
+void UCombatComponent::ApplyValidatedShot(const FVector_NetQuantize& TraceHitTarget, uint16 PredictionKey, bool bAccepted)
+{
+	MPSHOOTER_UOBJECT_BUDGET_SCOPE(ServerShot, CVarShotAllocBudget.GetValueOnGameThread());
+	if (bAccepted)
+	{
+		if (EquippedWeapon)
+		{
+			EquippedWeapon->SetFireShotKey(PredictionKey);
+		}
+		PlayFire(TraceHitTarget); // Spawns the projectile, and shows the shot to a listen server host
+		SendFireCosmetics(TraceHitTarget);
+		if (PredictionKey == 0 && HostFireInputTime > 0.0 && FireLatency)
+		{
+			FireLatency->InputToMuzzle.Add((FPlatformTime::Seconds() - HostFireInputTime) * 1000.0);
+		}
+	}
+	else if (FMatchJournal::IsRecording())
+	{
+		FMatchJournal::Record(EMatchJournalEvent::FireRejected, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(Character), TraceHitTarget, 0.f, 0, PredictionKey);
+	}
+	HostFireInputTime = 0.0;
+	if (PredictionKey != 0)
+	{
+		ClientFireResult(PredictionKey, bAccepted, TraceHitTarget);
+	}
+}
+
+bool UCombatComponent::IsFireInRange(const FVector& TraceHitTarget) const
+{
+	if (Character == nullptr || EquippedWeapon == nullptr) return false;
+	return FVector::DistSquared(Character->GetActorLocation(), TraceHitTarget) <= FMath::Square(TRACE_LENGTH + 1000.f); // a little slack for movement since the client traced
+}
+
+bool UCombatComponent::ValidateFire(const FVector& TraceHitTarget) const
+{
+	// The same checks a batched shot gets, for a world without the subsystem: range, then line of sight from the muzzle
+	FShotValidationJob Job;
+	if (!UShotValidationSubsystem::PrepareJob(this, TraceHitTarget, Job)) return false;
+	UShotValidationSubsystem::TraceJob(GetWorld(), Job, UShotValidationSubsystem::GetTolerance());
+	return Job.bAccepted;
+}
+
+void UCombatComponent::ClientFireResult_Implementation(uint16 PredictionKey, bool bAccepted, const FVector_NetQuantize& TraceHitTarget)
+{
+	const int32 ShotIndex = PendingShots.IndexOfByPredicate([PredictionKey](const FPendingFireShot& Shot) { return Shot.PredictionKey == PredictionKey; });
+	if (ShotIndex == INDEX_NONE) return; // already dropped
+
+	const FPendingFireShot Shot = PendingShots[ShotIndex];
+	PendingShots.RemoveAt(0, ShotIndex + 1, EAllowShrinking::No); // anything older than this shot lost its result
+	const double Now = FPlatformTime::Seconds();
+	FFireLatency* Latency = GetOrCreateFireLatency();
+	if (Latency)
+	{
+		Latency->InputToConfirm.Add((Now - Shot.InputTime) * 1000.0);
+	}
+
+	if (!bAccepted)
+	{
+		++RejectedShots;
+		if (Shot.bPredicted)
+		{
+			RollbackPredictedFire();
+		}
+	}
+	else if (!Shot.bPredicted)
+	{
+		PlayFire(TraceHitTarget); // prediction disabled, the muzzle flash waits for the server
+		if (Latency)
+		{
+			Latency->InputToMuzzle.Add((Now - Shot.InputTime) * 1000.0);
+		}
+	}
+}
+
+void UCombatComponent::RollbackPredictedFire()
+{
+	if (Character)
+	{
+		Character->StopFireMontage();
+	}
+	if (EquippedWeapon)
+	{
+		EquippedWeapon->StopFireAnimation();
+	}
+}
+
+void UCombatComponent::ResetFireLatency()
+{
+	if (FireLatency)
+	{
+		FireLatency->InputToMuzzle.Reset();
+		FireLatency->InputToConfirm.Reset();
+	}
+	RejectedShots = 0;
+}
+
+UCombatComponent::FFireLatency* UCombatComponent::GetOrCreateFireLatency()
 {
-	MulticastFire(TraceHitTarget);
+	if (FireLatency == nullptr && Character && Character->IsLocallyControlled() && Character->IsPlayerControlled())
+	{
+		FireLatency = MakeUnique<FFireLatency>();
+	}
+	return FireLatency.Get();
+}
+
+void UCombatComponent::SendFireCosmetics(const FVector& TraceHitTarget)
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr || Character == nullptr) return;
+
+	const FVector ShotOrigin = Character->GetActorLocation();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* Observer = It->Get();
+		if (Observer == nullptr || Observer->IsLocalController()) continue; // a listen server host already saw PlayFire
+		if (Observer == Character->GetController()) continue; // the shooter predicted its own shot
+
+		ASpartanCharacter* ObserverCharacter = Cast<ASpartanCharacter>(Observer->GetPawn());
+		UCombatComponent* ObserverCombat = ObserverCharacter ? ObserverCharacter->GetCombat() : nullptr;
+		if (ObserverCombat == nullptr) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		Observer->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		switch (GetFireCosmeticRelevance(ViewLocation, ViewRotation.Vector(), ShotOrigin, TraceHitTarget))
+		{
+		case EFireCosmeticRelevance::Full:
+			ObserverCombat->ClientFireCosmetic(Character, TraceHitTarget);
+			break;
+		case EFireCosmeticRelevance::Nearby:
+			ObserverCombat->ClientGunfireNearby(ShotOrigin);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+UCombatComponent::EFireCosmeticRelevance UCombatComponent::GetFireCosmeticRelevance(const FVector& ViewLocation, const FVector& ViewDirection, const FVector& ShotOrigin, const FVector& ShotTarget) const
+{
+	const float DistanceSquared = FVector::DistSquared(ViewLocation, ShotOrigin);
+	if (DistanceSquared <= FMath::Square(FireCosmeticAlwaysRadius))
+	{
+		return EFireCosmeticRelevance::Full;
+	}
+	if (DistanceSquared <= FMath::Square(FireCosmeticViewRadius))
+	{
+		// Either end of the shot in view counts, so a shot fired at us from behind cover still shows up.
+		const float CosHalfCone = FMath::Cos(FMath::DegreesToRadians(FireCosmeticViewConeDegrees * 0.5f));
+		if (((ShotOrigin - ViewLocation).GetSafeNormal() | ViewDirection) >= CosHalfCone ||
+			((ShotTarget - ViewLocation).GetSafeNormal() | ViewDirection) >= CosHalfCone)
+		{
+			return EFireCosmeticRelevance::Full;
+		}
+	}
+	if (DistanceSquared <= FMath::Square(GunfireAudibleRadius))
+	{
+		return EFireCosmeticRelevance::Nearby;
+	}
+	return EFireCosmeticRelevance::None;
+}
+
+void UCombatComponent::ClientFireCosmetic_Implementation(ASpartanCharacter* Shooter, const FVector_NetQuantize& TraceHitTarget)
+{
+	// Shooter is null if it isn't relevant to us
+	if (Shooter && Shooter->GetCombat())
+	{
+		Shooter->GetCombat()->PlayFire(TraceHitTarget);
+	}
+}
+
+void UCombatComponent::ClientGunfireNearby_Implementation(const FVector_NetQuantize& ShotOrigin)
+{
+	if (DistantGunfireSound)
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, DistantGunfireSound, ShotOrigin);
+	}
 }
 
 
 
 void UCombatComponent::EquipWeapon(AWeapon* WeaponToEquip)
 {
-	if (Character == nullptr || WeaponToEquip == nullptr) return;
+	if (Character == nullptr || WeaponToEquip == nullptr || WeaponSlots.Contains(WeaponToEquip)) return;
 
-	EquippedWeapon = WeaponToEquip;
-	EquippedWeapon->SetWeaponState(EWeaponState::EWS_Equipped);
-	const USkeletalMeshSocket* HandSocket = Character->GetMesh()->GetSocketByName(FName("RightHandSocket"));
-	if (HandSocket)
+	const EInventorySlot OtherSlot = ActiveSlot == EInventorySlot::EIS_Primary ? EInventorySlot::EIS_Secondary : EInventorySlot::EIS_Primary;
+	EInventorySlot Slot = ActiveSlot;
+	if (WeaponSlots[(int32)ActiveSlot] != nullptr)
 	{
-		HandSocket->AttachActor(EquippedWeapon, Character->GetMesh());
+		if (WeaponSlots[(int32)OtherSlot] == nullptr)
+		{
+			Slot = OtherSlot; // holstered, we keep what we're holding
+		}
+		else
+		{
+			WeaponSlots[(int32)ActiveSlot]->Dropped(); // both full, swap it for the one in our hands
+			WeaponSlots[(int32)ActiveSlot] = nullptr;
+		}
 	}
-	EquippedWeapon->SetOwner(Character);
-	Character->GetCharacterMovement()->bOrientRotationToMovement = false;
-	Character->bUseControllerRotationYaw = true;
 
-	UE_LOG(LogTemp, Warning, TEXT("EquipWeapon FunctionComplete"));
+	WeaponSlots[(int32)Slot] = WeaponToEquip;
+	WeaponToEquip->SetWeaponState(EWeaponState::EWS_Equipped);
+	WeaponToEquip->SetOwner(Character);
+	MPShooterIris::SetReplicatesWith(Character, WeaponToEquip, true);
+	FMatchJournal::Record(EMatchJournalEvent::Equip, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(Character), Character->GetActorLocation());
+	RefreshWeaponPreloads();
+	ApplyActiveSlot(); // server doesn't get the OnReps
+}
+
+void UCombatComponent::ResetCombatState()
+{
+	SetAiming(false);
+	bFireButtonPressed = false;
+	PendingShots.Reset();
+	PendingHitMarkers = FHitMarkerBatch();
+	HostFireInputTime = 0.0;
+}
+
+void UCombatComponent::DropEquippedWeapon()
+{
+	if (Character == nullptr || EquippedWeapon == nullptr || !Character->HasAuthority()) return;
+
+	EquippedWeapon->Dropped();
+	WeaponSlots[(int32)ActiveSlot] = nullptr;
+	SetAiming(false);
+	if (!Character->IsLocallyControlled())
+	{
+		ClientStopAiming(); // otherwise its next move asks to aim again
+	}
+
+	const EInventorySlot OtherSlot = ActiveSlot == EInventorySlot::EIS_Primary ? EInventorySlot::EIS_Secondary : EInventorySlot::EIS_Primary;
+	if (WeaponSlots[(int32)OtherSlot] != nullptr)
+	{
+		ActiveSlot = OtherSlot;
+		if (!Character->IsLocallyControlled())
+		{
+			ClientCorrectActiveSlot(ActiveSlot); // ActiveSlot doesn't replicate to the owner
+		}
+	}
+	RefreshWeaponPreloads();
+	ApplyActiveSlot();
+}
+
+void UCombatComponent::DropAllWeapons()
+{
+	if (Character == nullptr || !Character->HasAuthority()) return;
+
+	for (AWeapon*& Weapon : WeaponSlots)
+	{
+		if (Weapon)
+		{
+			Weapon->Dropped();
+			Weapon = nullptr;
+		}
+	}
+	SetAiming(false);
+	if (!Character->IsLocallyControlled())
+	{
+		ClientStopAiming();
+	}
+	if (ActiveSlot != EInventorySlot::EIS_Primary && !Character->IsLocallyControlled())
+	{
+		ClientCorrectActiveSlot(EInventorySlot::EIS_Primary); // ActiveSlot doesn't replicate to the owner
+	}
+	ActiveSlot = EInventorySlot::EIS_Primary;
+	RefreshWeaponPreloads();
+	ApplyActiveSlot();
 }
 
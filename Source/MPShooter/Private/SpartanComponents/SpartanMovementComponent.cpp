@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpartanComponents/SpartanMovementComponent.h"
+#include "Character/SpartanCharacter.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Server Move Corrections"), STAT_MPShooter_MoveCorrections, STATGROUP_MPShooter);
+
+static uint32 GServerCorrectionCount = 0;
+
+static FAutoConsoleCommand CmdMoveCorrections(
+	TEXT("MPShooter.MoveCorrections"),
+	TEXT("Prints the number of server movement corrections. Pass 'reset' to zero the count."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Server move corrections: %u"), USpartanMovementComponent::GetServerCorrectionCount());
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			USpartanMovementComponent::ResetServerCorrectionCount();
+		}
+	}));
+
+USpartanMovementComponent::USpartanMovementComponent()
+{
+	AimWalkSpeed = 425.f;
+	bWantsToAim = false;
+}
+
+float USpartanMovementComponent::GetMaxSpeed() const
+{
+	if (bWantsToAim && IsMovingOnGround() && !IsCrouching())
+	{
+		return AimWalkSpeed;
+	}
+	return Super::GetMaxSpeed();
+}
+
+void USpartanMovementComponent::SetWantsToAim(bool bNewWantsToAim)
+{
+	bWantsToAim = bNewWantsToAim;
+}
+
+void USpartanMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	const bool bNewWantsToAim = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	if (bNewWantsToAim != bWantsToAim)
+	{
+		bWantsToAim = bNewWantsToAim;
+		if (ASpartanCharacter* SpartanCharacter = Cast<ASpartanCharacter>(CharacterOwner))
+		{
+			if (SpartanCharacter->HasAuthority())
+			{
+				SpartanCharacter->OnServerAimingChanged(bWantsToAim); // keeps the replicated bAiming (anim) in step with the move
+			}
+		}
+	}
+}
+
+FNetworkPredictionData_Client* USpartanMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		USpartanMovementComponent* MutableThis = const_cast<USpartanMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Spartan(*this);
+	}
+	return ClientPredictionData;
+}
+
+bool USpartanMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	const bool bNeedsCorrection = Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientWorldLocation, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+	if (bNeedsCorrection)
+	{
+		INC_DWORD_STAT(STAT_MPShooter_MoveCorrections);
+		++GServerCorrectionCount;
+	}
+	return bNeedsCorrection;
+}
+
+uint32 USpartanMovementComponent::GetServerCorrectionCount()
+{
+	return GServerCorrectionCount;
+}
+
+void USpartanMovementComponent::ResetServerCorrectionCount()
+{
+	GServerCorrectionCount = 0;
+}
+
+void FSavedMove_Spartan::Clear()
+{
+	Super::Clear();
+	bSavedWantsToAim = false;
+}
+
+uint8 FSavedMove_Spartan::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+	if (bSavedWantsToAim)
+	{
+		Result |= FLAG_Custom_0;
+	}
+	return Result;
+}
+
+bool FSavedMove_Spartan::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	if (bSavedWantsToAim != static_cast<const FSavedMove_Spartan*>(NewMove.Get())->bSavedWantsToAim)
+	{
+		return false; // speed changes on this move, keep it separate
+	}
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Spartan::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const USpartanMovementComponent* Movement = Cast<USpartanMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedWantsToAim = Movement->bWantsToAim;
+	}
+}
+
+void FSavedMove_Spartan::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	if (USpartanMovementComponent* Movement = Cast<USpartanMovementComponent>(C->GetCharacterMovement()))
+	{
+		Movement->bWantsToAim = bSavedWantsToAim; // replaying moves after a correction uses the speed that move had
+	}
+}
+
+FNetworkPredictionData_Client_Spartan::FNetworkPredictionData_Client_Spartan(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Spartan::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Spartan());
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/AimSnapshotBuffer.h"
+#include "Character/SpartanCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// FAimSnapshotBuffer fed the way PostNetReceive feeds it, with the default delay cvars (0.03 - 0.25 s, 0.1 s extrapolation).
+// Snapshots are 0.05 s apart on the server and arrive exactly 1 s later, so the clock offset is 1 s, there's no jitter and the
+// playout delay settles on one interval, 0.05 s.
+namespace AimSnapshotBufferTest
+{
+	constexpr float Tolerance = 1.e-2f;
+	constexpr int32 TestFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter;
+	constexpr double Latency = 1.0;
+	constexpr double Interval = 0.05;
+
+	// Yaw 10, 20, 30, 40 at remote 0.05 ... 0.20, pitch 5 per snapshot
+	static void AddTurn(FAimSnapshotBuffer& Buffer)
+	{
+		for (int32 Index = 1; Index <= 4; ++Index)
+		{
+			const double RemoteTime = Index * Interval;
+			Buffer.Add(RemoteTime, RemoteTime + Latency, Index * 10.f, Index * 5.f);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAimSnapshotBufferInterpolationTest, "MPShooter.AimSnapshots.Interpolation", AimSnapshotBufferTest::TestFlags)
+
+bool FAimSnapshotBufferInterpolationTest::RunTest(const FString& Parameters)
+{
+	using namespace AimSnapshotBufferTest;
+	FAimSnapshotBuffer Buffer;
+	float Yaw = 0.f, Pitch = 0.f;
+	TestFalse(TEXT("nothing to sample before the first snapshot"), Buffer.Sample(Latency, Yaw, Pitch));
+
+	AddTurn(Buffer);
+	TestEqual(TEXT("playout delay, one interval"), Buffer.GetDelay(), (float)Interval, Tolerance);
+
+	// Rendering remote 0.175: halfway between 30 and 40
+	TestTrue(TEXT("sample"), Buffer.Sample(0.175 + Latency + Interval, Yaw, Pitch));
+	TestEqual(TEXT("yaw between two snapshots"), Yaw, 35.f, Tolerance);
+	TestEqual(TEXT("pitch between two snapshots"), Pitch, 17.5f, Tolerance);
+	TestEqual(TEXT("nothing extrapolated"), Buffer.GetExtrapolatedTime(), 0.f, Tolerance);
+
+	// Rendering remote 0.25, 0.05 past the newest: keeps turning at 10 per interval
+	Buffer.Sample(0.25 + Latency + Interval, Yaw, Pitch);
+	TestEqual(TEXT("starved: yaw extrapolated"), Yaw, 50.f, Tolerance);
+	TestEqual(TEXT("starved: extrapolated time"), Buffer.GetExtrapolatedTime(), 0.05f, Tolerance);
+
+	// Rendering before the oldest holds it
+	Buffer.Sample(Latency, Yaw, Pitch);
+	TestEqual(TEXT("before the oldest: its yaw"), Yaw, 10.f, Tolerance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAimSnapshotBufferTimestampTest, "MPShooter.AimSnapshots.Timestamps", AimSnapshotBufferTest::TestFlags)
+
+bool FAimSnapshotBufferTimestampTest::RunTest(const FString& Parameters)
+{
+	using namespace AimSnapshotBufferTest;
+	float Yaw = 0.f, Pitch = 0.f;
+
+	// Without a new remote timestamp only the pitch moves, which is why the timestamp has to replicate
+	const UCharacterMovementComponent* DefaultMovement = GetDefault<ASpartanCharacter>()->GetCharacterMovement();
+	TestTrue(TEXT("characters always replicate the movement timestamp"), DefaultMovement && DefaultMovement->bNetworkAlwaysReplicateTransformUpdateTimestamp);
+	FAimSnapshotBuffer Stale;
+	Stale.Add(0.0, Latency, 10.f, 0.f);
+	Stale.Add(0.0, Latency + Interval, 90.f, 20.f);
+	Stale.Sample(Latency + 1.0, Yaw, Pitch);
+	TestEqual(TEXT("same timestamp: yaw kept"), Yaw, 10.f, Tolerance);
+	TestEqual(TEXT("same timestamp: pitch updated"), Pitch, 20.f, Tolerance);
+
+	// Turning across +-180 goes the short way
+	FAimSnapshotBuffer Wrap;
+	Wrap.Add(Interval, Interval + Latency, 170.f, 0.f);
+	Wrap.Add(2.0 * Interval, 2.0 * Interval + Latency, -170.f, 0.f);
+	Wrap.Sample(1.5 * Interval + Latency + Interval, Yaw, Pitch);
+	TestEqual(TEXT("across +-180"), FMath::Abs(Yaw), 180.f, Tolerance);
+
+	// The owner's timestamps starting over (a new server, a respawned pawn) drops the old snapshots
+	FAimSnapshotBuffer Restart;
+	Restart.Add(5.0, 5.0 + Latency, 10.f, 0.f);
+	Restart.Add(5.0 + Interval, 5.0 + Interval + Latency, 20.f, 0.f);
+	Restart.Add(0.01, 7.0, -45.f, 0.f);
+	Restart.Sample(8.0, Yaw, Pitch);
+	TestEqual(TEXT("restarted timestamps: only the new snapshot"), Yaw, -45.f, Tolerance);
+	return true;
+}
+
+#endif
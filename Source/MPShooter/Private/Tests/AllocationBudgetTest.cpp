@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Instrumentation/AllocationTrackerSubsystem.h"
+#include "Weapon/Projectile.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/MPShooterTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Sustained fire against the server shot budget: every shot is one projectile spawned inside MPShooter.AllocBudget.Shot, the
+// way UCombatComponent::ApplyValidatedShot spawns it, while earlier projectiles fly, hit the wall and are destroyed.
+// The other scopes check that only the designated path is charged.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAllocationBudgetSustainedFireTest, "MPShooter.Allocation.ShotBudgetSustainedFire",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FAllocationBudgetSustainedFireTest::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* AssertCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("MPShooter.AllocBudgetAssert"));
+	const int32 SavedAssert = AssertCVar->GetInt();
+	AssertCVar->Set(0, ECVF_SetByCode); // violations are counted and checked below, not ensured
+	const bool bWasEnabled = FUObjectAllocationBudgetScope::IsEnabled();
+	FUObjectAllocationBudgetScope::SetEnabled(true);
+	FUObjectAllocationBudgetScope::ResetViolations();
+
+	const int32 ShotBudget = IConsoleManager::Get().FindConsoleVariable(TEXT("MPShooter.AllocBudget.Shot"))->GetInt();
+	{
+		FMPShooterTestWorld TestWorld(TEXT("AllocationBudgetTest"));
+		UWorld* World = TestWorld.Get();
+		TestWorld.SpawnWall(FVector(3000.f, 0.f, 0.f), FVector(50.f, 2000.f, 2000.f));
+		TestWorld.Tick(1.f / 60.f);
+
+		// 10 rounds a second for 10 seconds
+		const int32 NumShots = 100;
+		int32 FramesSinceShot = 0;
+		for (int32 Shot = 0; Shot < NumShots;)
+		{
+			if (++FramesSinceShot >= 6)
+			{
+				FramesSinceShot = 0;
+				MPSHOOTER_UOBJECT_BUDGET_SCOPE(TestFrame, 0); // an outer path that constructs nothing itself
+				{
+					MPSHOOTER_UOBJECT_BUDGET_SCOPE(ServerShot, ShotBudget);
+					FActorSpawnParameters SpawnParams;
+					SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+					SpawnParams.CustomPreSpawnInitalization = [](AActor* Actor) { CastChecked<AProjectile>(Actor)->GetProjectileMovement()->InitialSpeed = 15000.f; }; // the blueprint's job
+					World->SpawnActor<AProjectile>(AProjectile::StaticClass(), FVector(0.f, 0.f, 0.f), FRotator(0.f, (Shot % 7 - 3) * 2.f, 0.f), SpawnParams);
+				}
+				++Shot;
+			}
+			TestWorld.Tick(1.f / 60.f); // flights, hits and destroys outside any scope
+		}
+
+		int32 Worst = 0;
+		TestEqual(TEXT("server shot budget violations during sustained fire"), (int32)FUObjectAllocationBudgetScope::GetViolations(TEXT("ServerShot"), &Worst), 0);
+		TestTrue(FString::Printf(TEXT("worst shot constructed %d UObjects, budget %d"), Worst, ShotBudget), Worst <= ShotBudget);
+		TestEqual(TEXT("outer scope charged with the nested shot's UObjects"), (int32)FUObjectAllocationBudgetScope::GetViolations(TEXT("TestFrame")), 0);
+
+		// And a budget too small for a projectile has to fail, or the checks above prove nothing
+		{
+			MPSHOOTER_UOBJECT_BUDGET_SCOPE(TooSmall, 1);
+			World->SpawnActor<AProjectile>(AProjectile::StaticClass(), FVector(0.f, 0.f, 500.f), FRotator::ZeroRotator);
+		}
+		TestEqual(TEXT("a projectile spawned inside a budget of 1"), (int32)FUObjectAllocationBudgetScope::GetViolations(TEXT("TooSmall")), 1);
+	}
+
+	FUObjectAllocationBudgetScope::ResetViolations();
+	FUObjectAllocationBudgetScope::SetEnabled(bWasEnabled);
+	AssertCVar->Set(SavedAssert, ECVF_SetByCode);
+	return true;
+}
+
+#endif
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/WorldSettings.h"
+
+/**
+ * A standalone game world for automation tests: world subsystems are created, actors begin play as they spawn, and Tick runs
+ * the whole frame (actors, components, tickable world subsystems) at whatever delta the test asks for. No map, no game mode.
+ */
+class FMPShooterTestWorld
+{
+public:
+
+	explicit FMPShooterTestWorld(const TCHAR* Name)
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, Name);
+		FWorldContext& Context = GEngine->CreateNewWorldContext(EWorldType::Game);
+		Context.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+		World->GetWorldSettings()->NotifyBeginPlay(); // what the game mode would do
+	}
+
+	~FMPShooterTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	UWorld* Get() const { return World; }
+
+	void Tick(float DeltaSeconds)
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+	}
+
+	// A block everything box, for projectiles and traces to hit
+	AActor* SpawnWall(const FVector& Location, const FVector& Extent)
+	{
+		AActor* Wall = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location));
+		UBoxComponent* Box = NewObject<UBoxComponent>(Wall);
+		Box->SetBoxExtent(Extent);
+		Box->SetCollisionObjectType(ECC_WorldStatic);
+		Box->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Box->SetCollisionResponseToAllChannels(ECR_Block);
+		Wall->SetRootComponent(Box);
+		Box->RegisterComponent();
+		Box->SetWorldLocation(Location);
+		return Wall;
+	}
+
+private:
+
+	UWorld* World = nullptr;
+};
+
+#endif
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Server/MatchSnapshotSubsystem.h"
+#include "MPShooter/Weapon/Weapon.h"
+#include "Weapon/Projectile.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tests/MPShooterTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A match captured in one world, through the snapshot's bytes, and restored into another: weapons come back where they were,
+// the projectile keeps flying at the same velocity, and a player who hasn't reconnected yet keeps each weapon in its slot,
+// in the pending record and in the next snapshot. The test worlds have no game state, so the player record is added by hand,
+// the way Capture writes one for a character holding both weapons.
+namespace MatchSnapshotTest
+{
+	constexpr float Tolerance = 1.e-2f;
+	constexpr float Speed = 5000.f; // the C++ default InitialSpeed is 0
+	static const TCHAR* PlayerKey = TEXT("Bot_1");
+	const FVector WeaponLocations[] = { FVector(100.f, 0.f, 50.f), FVector(300.f, 200.f, 50.f) };
+	const FVector ProjectileLocation(0.f, 0.f, 500.f);
+
+	static FVector FindWeaponLocation(const FMatchSnapshot& Snapshot, int32 Index)
+	{
+		return Snapshot.Weapons.IsValidIndex(Index) ? FVector(Snapshot.Weapons[Index].Location) : FVector(UE_BIG_NUMBER);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatchSnapshotRoundTripTest, "MPShooter.MatchSnapshot.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMatchSnapshotRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace MatchSnapshotTest;
+
+	FMatchSnapshot Captured;
+	{
+		FMPShooterTestWorld TestWorld(TEXT("MatchSnapshotCapture"));
+		UWorld* World = TestWorld.Get();
+		for (const FVector& Location : WeaponLocations)
+		{
+			World->SpawnActor<AWeapon>(AWeapon::StaticClass(), Location, FRotator(0.f, 45.f, 0.f));
+		}
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParams.CustomPreSpawnInitalization = [](AActor* Actor) { CastChecked<AProjectile>(Actor)->GetProjectileMovement()->InitialSpeed = Speed; };
+		World->SpawnActor<AProjectile>(AProjectile::StaticClass(), ProjectileLocation, FRotator(0.f, 90.f, 0.f), SpawnParams);
+
+		UMatchSnapshotSubsystem* Snapshots = World->GetSubsystem<UMatchSnapshotSubsystem>();
+		if (!TestNotNull(TEXT("snapshot subsystem in a game world"), Snapshots)) return false;
+		Snapshots->Capture(Captured);
+	}
+	TestEqual(TEXT("captured weapons"), Captured.Weapons.Num(), 2);
+	TestEqual(TEXT("captured projectiles"), Captured.Projectiles.Num(), 1);
+
+	FMatchSnapshotPlayer& Player = Captured.Players.AddDefaulted_GetRef();
+	Player.Key = PlayerKey;
+	Player.Weapons[0] = 1; // slots in the other order than the weapons were spawned
+	Player.Weapons[1] = 0;
+	Player.ActiveSlot = 1;
+	Player.Kills = 3;
+	Player.bAlive = 1;
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	TestTrue(TEXT("serialized"), Captured.Serialize(Writer));
+	FMatchSnapshot Loaded;
+	FMemoryReader Reader(Bytes);
+	if (!TestTrue(TEXT("read back"), Loaded.Serialize(Reader))) return false;
+
+	TestEqual(TEXT("map"), Loaded.MapName, Captured.MapName);
+	TestTrue(TEXT("classes"), Loaded.Classes == Captured.Classes);
+	if (!TestEqual(TEXT("players read back"), Loaded.Players.Num(), 1)) return false;
+	TestEqual(TEXT("slot 0 read back"), (int32)Loaded.Players[0].Weapons[0], 1);
+	TestEqual(TEXT("slot 1 read back"), (int32)Loaded.Players[0].Weapons[1], 0);
+	TestEqual(TEXT("active slot read back"), (int32)Loaded.Players[0].ActiveSlot, 1);
+	TestEqual(TEXT("kills read back"), Loaded.Players[0].Kills, 3);
+	if (!TestEqual(TEXT("projectiles read back"), Loaded.Projectiles.Num(), 1)) return false;
+	TestEqual(TEXT("projectile velocity read back"), FVector(Loaded.Projectiles[0].Velocity), FVector(0.f, Speed, 0.f), Tolerance);
+
+	FMatchSnapshot Recaptured;
+	{
+		FMPShooterTestWorld TestWorld(TEXT("MatchSnapshotRestore"));
+		UWorld* World = TestWorld.Get();
+		UMatchSnapshotSubsystem* Snapshots = World->GetSubsystem<UMatchSnapshotSubsystem>();
+		if (!TestNotNull(TEXT("snapshot subsystem in the restored world"), Snapshots)) return false;
+		Snapshots->Restore(Loaded);
+
+		int32 Weapons = 0;
+		for (TActorIterator<AWeapon> It(World); It; ++It)
+		{
+			Weapons++;
+		}
+		TestEqual(TEXT("restored weapons"), Weapons, 2);
+		TActorIterator<AProjectile> Projectile(World);
+		if (TestTrue(TEXT("restored projectile"), (bool)Projectile))
+		{
+			TestEqual(TEXT("restored projectile location"), Projectile->GetActorLocation(), ProjectileLocation, Tolerance);
+			TestEqual(TEXT("restored projectile velocity"), Projectile->GetProjectileMovement()->Velocity, FVector(0.f, Speed, 0.f), Tolerance);
+		}
+
+		// Nobody has reconnected, so the player waits with their weapons
+		const UMatchSnapshotSubsystem::FPendingPlayer* Pending = Snapshots->PendingPlayers.Find(PlayerKey);
+		if (TestNotNull(TEXT("player pending"), Pending))
+		{
+			for (int32 Slot = 0; Slot < (int32)EInventorySlot::EIS_MAX; ++Slot)
+			{
+				const AWeapon* Weapon = Pending->Weapons[Slot].Get();
+				if (TestNotNull(*FString::Printf(TEXT("slot %d weapon restored"), Slot), Weapon))
+				{
+					TestEqual(*FString::Printf(TEXT("slot %d holds its weapon"), Slot), Weapon->GetActorLocation(), WeaponLocations[1 - Slot], Tolerance);
+				}
+			}
+		}
+		Snapshots->Capture(Recaptured);
+	}
+
+	// And the next snapshot still has them in the same slots
+	if (!TestEqual(TEXT("pending player carried into the next snapshot"), Recaptured.Players.Num(), 1)) return false;
+	TestEqual(TEXT("weapons in the next snapshot"), Recaptured.Weapons.Num(), 2);
+	TestEqual(TEXT("projectiles in the next snapshot"), Recaptured.Projectiles.Num(), 1);
+	for (int32 Slot = 0; Slot < (int32)EInventorySlot::EIS_MAX; ++Slot)
+	{
+		TestEqual(*FString::Printf(TEXT("slot %d in the next snapshot"), Slot), FindWeaponLocation(Recaptured, Recaptured.Players[0].Weapons[Slot]),
+			FindWeaponLocation(Loaded, Loaded.Players[0].Weapons[Slot]), Tolerance);
+	}
+	TestEqual(TEXT("active slot in the next snapshot"), (int32)Recaptured.Players[0].ActiveSlot, 1);
+	return true;
+}
+
+#endif
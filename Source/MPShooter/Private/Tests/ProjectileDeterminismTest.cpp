@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/Projectile.h"
+#include "Weapon/ProjectileSimulationSubsystem.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/MPShooterTestWorld.h"
+#include "Tests/ProjectileHitRecorder.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Real projectiles through UProjectileSimulationSubsystem at 30 and 120 frames a second: the same shots have to hit the same
+// points, OnHit and all. A pillar halfway makes some shots clip its edge, where a per-frame step would cut the corner at 30.
+namespace ProjectileDeterminismTest
+{
+	constexpr int32 NumProjectiles = 27;
+	constexpr int32 StraightShot = 13; // no pitch, no yaw
+	constexpr float Speed = 15000.f; // the blueprint's InitialSpeed, the C++ default is 0
+	constexpr float FlightSeconds = 1.5f; // the wall is 0.4 s out
+	constexpr float HitchSeconds = 0.35f; // 42 steps at 120 Hz, more than MaxStepsPerFrame
+
+	struct FFlight
+	{
+		TMap<int32, FVector> ImpactPoints;
+		FVector StraightShotAfterHitch = FVector::ZeroVector;
+	};
+
+	static FFlight Fly(const TCHAR* WorldName, float FrameSeconds, bool bHitch)
+	{
+		FFlight Flight;
+		FMPShooterTestWorld TestWorld(WorldName);
+		UWorld* World = TestWorld.Get();
+		TestWorld.SpawnWall(FVector(6000.f, 0.f, 0.f), FVector(50.f, 4000.f, 4000.f));
+		TestWorld.SpawnWall(FVector(3000.f, 400.f, 0.f), FVector(40.f, 40.f, 2000.f));
+		TestWorld.Tick(FrameSeconds);
+
+		TStrongObjectPtr<UProjectileHitRecorder> Recorder(NewObject<UProjectileHitRecorder>());
+		TArray<TWeakObjectPtr<AProjectile>> Projectiles;
+		for (int32 Index = 0; Index < NumProjectiles; ++Index)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			SpawnParams.CustomPreSpawnInitalization = [](AActor* Actor) { CastChecked<AProjectile>(Actor)->GetProjectileMovement()->InitialSpeed = Speed; };
+			const FRotator Aim((Index / 9 - 1) * 3.f, (Index % 9 - 4) * 2.f, 0.f);
+			AProjectile* Projectile = World->SpawnActor<AProjectile>(AProjectile::StaticClass(), FVector::ZeroVector, Aim, SpawnParams);
+			Recorder->Watch(Projectile, Index);
+			Projectiles.Add(Projectile);
+		}
+
+		float Elapsed = 0.f;
+		if (bHitch)
+		{
+			TestWorld.Tick(HitchSeconds);
+			TestWorld.Tick(FrameSeconds); // the hitch frame's steps are applied on the frame after it
+			Elapsed += HitchSeconds + FrameSeconds;
+			if (const AProjectile* Straight = Projectiles[StraightShot].Get())
+			{
+				Flight.StraightShotAfterHitch = Straight->GetActorLocation();
+			}
+		}
+		for (; Elapsed < FlightSeconds; Elapsed += FrameSeconds)
+		{
+			TestWorld.Tick(FrameSeconds);
+		}
+		Flight.ImpactPoints = Recorder->ImpactPoints;
+		return Flight;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FProjectileDeterminismTest, "MPShooter.Projectile.FixedStepDeterminism",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FProjectileDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace ProjectileDeterminismTest;
+	IConsoleVariable* FixedStepCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("MPShooter.Projectile.FixedStepHz"));
+	const float SavedFixedStepHz = FixedStepCVar->GetFloat();
+	FixedStepCVar->Set(120.f, ECVF_SetByCode);
+
+	const FFlight Reference = Fly(TEXT("ProjectileDeterminism120"), 1.f / 120.f, false);
+	const FFlight Slow = Fly(TEXT("ProjectileDeterminism30"), 1.f / 30.f, false);
+	const FFlight Hitched = Fly(TEXT("ProjectileDeterminism30Hitch"), 1.f / 30.f, true);
+
+	TestEqual(TEXT("every shot hits the pillar or the wall"), Reference.ImpactPoints.Num(), NumProjectiles);
+	for (const TPair<int32, FVector>& Impact : Reference.ImpactPoints)
+	{
+		const FVector* SlowImpact = Slow.ImpactPoints.Find(Impact.Key);
+		const FVector* HitchedImpact = Hitched.ImpactPoints.Find(Impact.Key);
+		if (TestNotNull(*FString::Printf(TEXT("shot %d hits at 30 Hz"), Impact.Key), SlowImpact))
+		{
+			TestEqual(*FString::Printf(TEXT("shot %d impact point, 30 vs 120 Hz"), Impact.Key), *SlowImpact, Impact.Value, UE_KINDA_SMALL_NUMBER);
+		}
+		if (TestNotNull(*FString::Printf(TEXT("shot %d hits at 30 Hz after a hitch"), Impact.Key), HitchedImpact))
+		{
+			TestEqual(*FString::Printf(TEXT("shot %d impact point, 30 Hz with a hitch vs 120 Hz"), Impact.Key), *HitchedImpact, Impact.Value, UE_KINDA_SMALL_NUMBER);
+		}
+	}
+
+	// The hitch frame is capped, the rest of its steps run over the next frames
+	const float MaxStepsDistance = UProjectileSimulationSubsystem::MaxStepsPerFrame * Speed / 120.f;
+	TestEqual(TEXT("straight shot after the hitch frame flew MaxStepsPerFrame steps"), Hitched.StraightShotAfterHitch.X, MaxStepsDistance, 1.f);
+
+	FixedStepCVar->Set(SavedFixedStepHz, ECVF_SetByCode);
+	return true;
+}
+
+#endif
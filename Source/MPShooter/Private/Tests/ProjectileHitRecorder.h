@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/BoxComponent.h"
+#include "UObject/Object.h"
+#include "Weapon/Projectile.h"
+#include "ProjectileHitRecorder.generated.h"
+
+/**
+ * Test helper: listens on projectiles' OnComponentHit, next to AProjectile::OnHit, and keeps where each one hit.
+ * A UObject because the hit delegate is dynamic; UHT doesn't look inside WITH_DEV_AUTOMATION_TESTS, so it's always compiled.
+ */
+UCLASS(Transient)
+class UProjectileHitRecorder : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void Watch(AProjectile* Projectile, int32 Index)
+	{
+		Indices.Add(Projectile->GetCollisionBox(), Index);
+		Projectile->GetCollisionBox()->OnComponentHit.AddDynamic(this, &UProjectileHitRecorder::OnHit);
+	}
+
+	TMap<int32, FVector> ImpactPoints; // by the index given to Watch, only the projectiles that hit something
+
+private:
+
+	UFUNCTION()
+	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+	{
+		if (const int32* Index = Indices.Find(HitComp))
+		{
+			ImpactPoints.Add(*Index, Hit.ImpactPoint);
+		}
+	}
+
+	TMap<TObjectKey<UPrimitiveComponent>, int32> Indices;
+};
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/SpartanAimMath.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Golden cases for FSpartanAimMath, worked out by hand from the thresholds and interp speeds in SpartanAimMath.h.
+// FInterpTo / RInterpTo move DeltaTime * Speed of the way there, so a DeltaTime of 0.1 s at speed 4 (turn) or 6 (lean, yaw offset)
+// covers 40% or 60% of the distance per call.
+namespace SpartanAimMathTest
+{
+	constexpr float Tolerance = 1.e-3f;
+	constexpr int32 TestFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter;
+
+	static FSpartanAimInput Standing(float AimYaw, float DeltaTime = 0.1f)
+	{
+		FSpartanAimInput Input;
+		Input.AimYaw = AimYaw;
+		Input.DeltaTime = DeltaTime;
+		return Input;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpartanAimMathPitchTest, "MPShooter.AimMath.AimPitch", SpartanAimMathTest::TestFlags)
+
+bool FSpartanAimMathPitchTest::RunTest(const FString& Parameters)
+{
+	using namespace SpartanAimMathTest;
+	TestEqual(TEXT("local pitch up"), FSpartanAimMath::AimPitch(30.f, false), 30.f, Tolerance);
+	TestEqual(TEXT("local pitch is never remapped"), FSpartanAimMath::AimPitch(330.f, false), 330.f, Tolerance);
+	TestEqual(TEXT("remote pitch up"), FSpartanAimMath::AimPitch(45.f, true), 45.f, Tolerance);
+	TestEqual(TEXT("remote pitch down, 330 is -30"), FSpartanAimMath::AimPitch(330.f, true), -30.f, Tolerance);
+	TestEqual(TEXT("remote pitch straight down, 270 is -90"), FSpartanAimMath::AimPitch(270.f, true), -90.f, Tolerance);
+
+	FSpartanAimInput Input = Standing(0.f);
+	Input.AimPitch = 315.f;
+	Input.bRemotePitch = true;
+	TestEqual(TEXT("AO_Pitch from a simulated proxy"), FSpartanAimMath::UpdateAimOffset(FSpartanAimState(), Input).AO_Pitch, -45.f, Tolerance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpartanAimMathYawTest, "MPShooter.AimMath.AimOffsetYaw", SpartanAimMathTest::TestFlags)
+
+bool FSpartanAimMathYawTest::RunTest(const FString& Parameters)
+{
+	using namespace SpartanAimMathTest;
+	FSpartanAimState Previous;
+	Previous.StartingAimYaw = 10.f;
+
+	FSpartanAimState State = FSpartanAimMath::UpdateAimOffset(Previous, Standing(50.f));
+	TestEqual(TEXT("standing: AO_Yaw against where we stopped"), State.AO_Yaw, 40.f, Tolerance);
+	TestEqual(TEXT("standing: Interp_AO_Yaw follows while not turning"), State.Interp_AO_Yaw, 40.f, Tolerance);
+	TestTrue(TEXT("standing: 40 is inside the turn limits"), State.TurningInPlace == ETurningInPlace::ETIP_NotTurning);
+	TestEqual(TEXT("standing: StartingAimYaw kept"), State.StartingAimYaw, 10.f, Tolerance);
+
+	Previous.StartingAimYaw = 170.f;
+	State = FSpartanAimMath::UpdateAimOffset(Previous, Standing(-170.f));
+	TestEqual(TEXT("standing across +-180: the short way round"), State.AO_Yaw, 20.f, Tolerance);
+
+	FSpartanAimInput Moving = Standing(75.f);
+	Moving.Velocity = FVector(300.f, 0.f, 0.f);
+	Previous.StartingAimYaw = 0.f;
+	Previous.TurningInPlace = ETurningInPlace::ETIP_Right;
+	State = FSpartanAimMath::UpdateAimOffset(Previous, Moving);
+	TestEqual(TEXT("moving: no aim offset yaw"), State.AO_Yaw, 0.f, Tolerance);
+	TestEqual(TEXT("moving: aim yaw becomes the start"), State.StartingAimYaw, 75.f, Tolerance);
+	TestTrue(TEXT("moving: stops turning in place"), State.TurningInPlace == ETurningInPlace::ETIP_NotTurning);
+
+	FSpartanAimInput Falling = Standing(-30.f);
+	Falling.Velocity = FVector(0.f, 0.f, -500.f); // no ground speed, still not standing
+	Falling.bIsInAir = true;
+	State = FSpartanAimMath::UpdateAimOffset(Previous, Falling);
+	TestEqual(TEXT("in air: no aim offset yaw"), State.AO_Yaw, 0.f, Tolerance);
+	TestEqual(TEXT("in air: aim yaw becomes the start"), State.StartingAimYaw, -30.f, Tolerance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpartanAimMathTurnInPlaceTest, "MPShooter.AimMath.TurnInPlace", SpartanAimMathTest::TestFlags)
+
+bool FSpartanAimMathTurnInPlaceTest::RunTest(const FString& Parameters)
+{
+	using namespace SpartanAimMathTest;
+
+	// Aim 80 to the right of where we stopped: past 70, turn right, and the yaw eases back 40% per 0.1 s frame until under 15
+	struct FGolden
+	{
+		float AO_Yaw;
+		ETurningInPlace Turning;
+		float StartingAimYaw;
+	};
+	const FGolden Right[] =
+	{
+		{ 48.f, ETurningInPlace::ETIP_Right, 0.f },
+		{ 28.8f, ETurningInPlace::ETIP_Right, 0.f },
+		{ 17.28f, ETurningInPlace::ETIP_Right, 0.f },
+		{ 10.368f, ETurningInPlace::ETIP_NotTurning, 80.f }, // turned far enough, aim from here
+		{ 0.f, ETurningInPlace::ETIP_NotTurning, 80.f },
+	};
+	FSpartanAimState State;
+	for (int32 Frame = 0; Frame < (int32)UE_ARRAY_COUNT(Right); ++Frame)
+	{
+		State = FSpartanAimMath::UpdateAimOffset(State, Standing(80.f));
+		TestEqual(FString::Printf(TEXT("turn right frame %d: AO_Yaw"), Frame), State.AO_Yaw, Right[Frame].AO_Yaw, Tolerance);
+		TestTrue(FString::Printf(TEXT("turn right frame %d: TIP state"), Frame), State.TurningInPlace == Right[Frame].Turning);
+		TestEqual(FString::Printf(TEXT("turn right frame %d: StartingAimYaw"), Frame), State.StartingAimYaw, Right[Frame].StartingAimYaw, Tolerance);
+	}
+
+	State = FSpartanAimMath::UpdateAimOffset(FSpartanAimState(), Standing(-80.f));
+	TestTrue(TEXT("-80 is inside the left limit"), State.TurningInPlace == ETurningInPlace::ETIP_NotTurning);
+	TestEqual(TEXT("-80 stays an aim offset"), State.AO_Yaw, -80.f, Tolerance);
+
+	State = FSpartanAimMath::UpdateAimOffset(FSpartanAimState(), Standing(-100.f));
+	TestTrue(TEXT("-100 turns left"), State.TurningInPlace == ETurningInPlace::ETIP_Left);
+	TestEqual(TEXT("-100 eases 40% toward 0"), State.AO_Yaw, -60.f, Tolerance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpartanAimMathLeanTest, "MPShooter.AimMath.Lean", SpartanAimMathTest::TestFlags)
+
+bool FSpartanAimMathLeanTest::RunTest(const FString& Parameters)
+{
+	using namespace SpartanAimMathTest;
+
+	// Turning 10 degrees per 0.1 s frame is a yaw rate of 100, the lean closes 60% of the gap per frame and stops at 90
+	float Lean = FSpartanAimMath::UpdateLean(0.f, 10.f, 0.f, 0.1f);
+	TestEqual(TEXT("lean frame 0"), Lean, 60.f, Tolerance);
+	Lean = FSpartanAimMath::UpdateLean(Lean, 20.f, 10.f, 0.1f);
+	TestEqual(TEXT("lean frame 1"), Lean, 84.f, Tolerance);
+	Lean = FSpartanAimMath::UpdateLean(Lean, 30.f, 20.f, 0.1f);
+	TestEqual(TEXT("lean frame 2, clamped"), Lean, 90.f, Tolerance);
+
+	TestEqual(TEXT("turning left across +-180"), FSpartanAimMath::UpdateLean(0.f, 179.f, -179.f, 0.1f), -12.f, Tolerance);
+	TestEqual(TEXT("turning right across +-180"), FSpartanAimMath::UpdateLean(0.f, -179.f, 179.f, 0.1f), 12.f, Tolerance);
+	TestEqual(TEXT("no time passed keeps the lean"), FSpartanAimMath::UpdateLean(33.f, 50.f, 0.f, 0.f), 33.f, Tolerance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpartanAimMathYawOffsetTest, "MPShooter.AimMath.YawOffset", SpartanAimMathTest::TestFlags)
+
+bool FSpartanAimMathYawOffsetTest::RunTest(const FString& Parameters)
+{
+	using namespace SpartanAimMathTest;
+
+	// Strafing right while aiming ahead: 90, the blend space slows down past 45
+	FSpartanLocomotionState State;
+	FSpartanAimMath::UpdateYawOffset(State, FRotator::ZeroRotator, FVector(0.f, 300.f, 0.f), 1.f);
+	TestEqual(TEXT("strafe right: YawOffset"), State.YawOffset, 90.f, Tolerance);
+	TestEqual(TEXT("strafe right: CorrectiveRate"), State.CorrectiveRate, 0.5f, Tolerance);
+
+	State = FSpartanLocomotionState();
+	FSpartanAimMath::UpdateYawOffset(State, FRotator::ZeroRotator, FVector(0.f, 300.f, 0.f), 0.1f);
+	TestEqual(TEXT("strafe right, one 0.1 s frame: 60% of the way"), State.YawOffset, 54.f, Tolerance);
+	TestEqual(TEXT("strafe right, one 0.1 s frame: CorrectiveRate 45 / 54"), State.CorrectiveRate, 45.f / 54.f, Tolerance);
+
+	State = FSpartanLocomotionState();
+	FSpartanAimMath::UpdateYawOffset(State, FRotator(0.f, 30.f, 0.f), FVector(0.f, -300.f, 0.f), 1.f);
+	TestEqual(TEXT("backpedal left of the aim: YawOffset"), State.YawOffset, -120.f, Tolerance);
+	TestEqual(TEXT("backpedal left of the aim: CorrectiveRate clamped"), State.CorrectiveRate, 0.5f, Tolerance);
+
+	State = FSpartanLocomotionState();
+	FSpartanAimMath::UpdateYawOffset(State, FRotator(0.f, 20.f, 0.f), FVector(300.f, 0.f, 0.f), 1.f);
+	TestEqual(TEXT("running almost where we aim: YawOffset"), State.YawOffset, -20.f, Tolerance);
+	TestEqual(TEXT("running almost where we aim: full rate"), State.CorrectiveRate, 1.f, Tolerance);
+	return true;
+}
+
+#endif
@@ -3,16 +3,28 @@
 
 #include "Weapon/Projectile.h"
 #include "Components/BoxComponent.h"
-#include "GameFramework/ProjectileMovementComponent.h"
+#include "Weapon/SpartanProjectileMovementComponent.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "GameFramework/DamageType.h"
 #include "Kismet/GameplayStatics.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Particles/ParticleSystem.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "Instrumentation/MatchJournal.h"
+#include "Instrumentation/LatencyHarnessSubsystem.h"
+#include "Net/UnrealNetwork.h"
+#include "GameFramework/PlayerController.h"
+#include "Server/ServerTickGovernorSubsystem.h"
+#include "Networking/MPShooterIris.h"
+#include "Weapon/ProjectileSimulationSubsystem.h"
 
 AProjectile::AProjectile()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Projectiles);
 
 	PrimaryActorTick.bCanEverTick = true;
 	bReplicates = true;
+	bReplicateUsingRegisteredSubObjectList = true; // required by Iris, no difference on the generic path
 
 	CollisionBox = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionBox"));
 	SetRootComponent(CollisionBox);
@@ -21,26 +33,95 @@ AProjectile::AProjectile()
 	CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
 	CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
 	CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldStatic, ECollisionResponse::ECR_Block);
+	CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Block); // so we can hit characters
 
-	ProjectileMovementComponent = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovementComponent"));
+	ProjectileMovementComponent = CreateDefaultSubobject<USpartanProjectileMovementComponent>(TEXT("ProjectileMovementComponent"));
 	ProjectileMovementComponent->bRotationFollowsVelocity = true;
+
+	Damage = 20.f;
+	ShotKey = 0;
+}
+
+void AProjectile::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (Tracer)
+	{
+		OutAssets.Add(FSoftObjectPath(Tracer));
+	}
+}
+
+void AProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AProjectile, ShotKey, COND_InitialOnly);
 }
 
 
 void AProjectile::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Projectiles);
 	Super::BeginPlay();
 
+	if (GetOwner())
+	{
+		CollisionBox->IgnoreActorWhenMoving(GetOwner(), true); // don't shoot ourselves on the way out of the muzzle
+	}
+	UProjectileSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>();
+	if (Simulation && UProjectileSimulationSubsystem::IsFixedStep())
+	{
+		ProjectileMovementComponent->SetComponentTickEnabled(false); // flown in fixed steps, hits come through the same OnComponentHit
+		Simulation->Register(this);
+	}
+	if (HasAuthority())
+	{
+		CollisionBox->OnComponentHit.AddDynamic(this, &AProjectile::OnHit); // damage is applied on the server only
+		ApplyServerFidelity(UServerTickGovernorSubsystem::GetCurrentFidelity(GetWorld()));
+		MPShooterIris::ConfigureActor(this, MPShooterIris::EReplicatedClass::Projectile);
+	}
+	else if (ULatencyHarnessSubsystem::IsActive())
+	{
+		const APlayerController* LocalController = GetWorld()->GetFirstPlayerController();
+		ULatencyHarnessSubsystem::RecordStage(ELatencyHarnessStage::ObserverReplicated, FMatchJournal::GetPlayerId(GetInstigator()), ShotKey, FMatchJournal::GetPlayerId(LocalController));
+	}
+
 	if (Tracer)
 	{
+		MPSHOOTER_PERF_SCOPE(Effects);
 		TracerComponent = UGameplayStatics::SpawnEmitterAttached(Tracer, CollisionBox, FName(), GetActorLocation(), GetActorRotation(), EAttachLocation::KeepWorldPosition);
 	}
 	
 }
 
+void AProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	ULatencyHarnessSubsystem::RecordStage(ELatencyHarnessStage::Impact, FMatchJournal::GetPlayerId(GetInstigator()), ShotKey);
+	if (FMatchJournal::IsRecording())
+	{
+		const APawn* Victim = Cast<APawn>(OtherActor);
+		const float FlightMs = (GetWorld()->GetTimeSeconds() - CreationTime) * 1000.f;
+		FMatchJournal::Record(EMatchJournalEvent::Hit, GetWorld()->GetTimeSeconds(), FMatchJournal::GetPlayerId(GetInstigator()), Hit.ImpactPoint,
+			Victim ? Damage : 0.f, FMatchJournal::GetPlayerId(Victim), (uint16)FMath::Min(FlightMs, 65535.f));
+	}
+	if (OtherActor && OtherActor != GetOwner())
+	{
+		UGameplayStatics::ApplyDamage(OtherActor, Damage, GetInstigatorController(), this, UDamageType::StaticClass());
+	}
+	Destroy();
+}
+
 void AProjectile::Tick(float DeltaTime)
 {
+	LLM_SCOPE_BYTAG(MPShooter_Projectiles);
+	MPSHOOTER_PERF_SCOPE(ProjectileSim);
 	Super::Tick(DeltaTime);
 
 }
 
+void AProjectile::ApplyServerFidelity(const FServerFidelity& Fidelity)
+{
+	const AProjectile* Defaults = GetDefault<AProjectile>(GetClass());
+	SetNetUpdateFrequency(Defaults->GetNetUpdateFrequency() * Fidelity.NetRateScale);
+	// Only the per-frame path substeps this way; fixed step flights keep their step, a slower server runs more of them per frame
+	ProjectileMovementComponent->MaxSimulationTimeStep = FMath::Max(Defaults->ProjectileMovementComponent->MaxSimulationTimeStep, Fidelity.ProjectileMaxTimeStep);
+}
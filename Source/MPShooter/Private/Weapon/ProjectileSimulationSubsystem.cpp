@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/ProjectileSimulationSubsystem.h"
+#include "Weapon/Projectile.h"
+#include "Async/ParallelFor.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Tasks/Task.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Sim Steps (game thread waits on last frame's)"), STAT_MPShooter_ProjectileSimSteps, STATGROUP_MPShooter);
+
+static TAutoConsoleVariable<float> CVarProjectileFixedStepHz(
+	TEXT("MPShooter.Projectile.FixedStepHz"),
+	120.f,
+	TEXT("Projectiles fly in fixed steps at this rate, independent of the frame rate (0: UProjectileMovementComponent steps once per frame, the old behaviour). Read at spawn."));
+
+static TAutoConsoleVariable<int32> CVarProjectileSimParallel(
+	TEXT("MPShooter.Projectile.Parallel"),
+	1,
+	TEXT("Step the frame's projectiles in parallel on the task graph (1) or one after the other in a single task (0)."));
+
+bool UProjectileSimulationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UProjectileSimulationSubsystem::Deinitialize()
+{
+	WaitForSteps(); // the task sweeps this world
+	InFlight.Reset();
+	Super::Deinitialize();
+}
+
+TStatId UProjectileSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSimulationSubsystem, STATGROUP_Tickables);
+}
+
+bool UProjectileSimulationSubsystem::IsFixedStep()
+{
+	return CVarProjectileFixedStepHz.GetValueOnGameThread() > 0.f;
+}
+
+float UProjectileSimulationSubsystem::GetStepSeconds()
+{
+	return 1.f / FMath::Max(CVarProjectileFixedStepHz.GetValueOnGameThread(), 1.f);
+}
+
+void UProjectileSimulationSubsystem::Register(AProjectile* Projectile)
+{
+	FSimulatedProjectile& Simulated = Projectiles.AddDefaulted_GetRef();
+	Simulated.Projectile = Projectile;
+	Simulated.SpawnTime = GetWorld()->GetTimeSeconds();
+	Simulated.StepSeconds = GetStepSeconds();
+	InitBody(Simulated.Body, Projectile);
+}
+
+void UProjectileSimulationSubsystem::InitBody(FProjectileSimBody& Body, const AProjectile* Projectile)
+{
+	const UBoxComponent* CollisionBox = Projectile->GetCollisionBox();
+	const UProjectileMovementComponent* Movement = Projectile->GetProjectileMovement();
+	Body.Location = Projectile->GetActorLocation();
+	Body.Velocity = Movement->Velocity; // InitialSpeed along the muzzle, set when the component initialized
+	Body.GravityZ = Movement->GetGravityZ();
+	Body.StepsDone = 0;
+	Body.bHit = false;
+	Body.Shape = CollisionBox->GetCollisionShape();
+	Body.Channel = CollisionBox->GetCollisionObjectType();
+	Body.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(ProjectileSim), false, Projectile);
+	Body.QueryParams.AddIgnoredActor(Projectile->GetOwner()); // don't shoot ourselves on the way out of the muzzle
+	Body.ResponseParams = FCollisionResponseParams(CollisionBox->GetCollisionResponseToChannels());
+}
+
+void UProjectileSimulationSubsystem::Advance(const UWorld* World, FProjectileSimBody& Body, int32 TargetSteps, float StepSeconds)
+{
+	const FVector Acceleration(0.f, 0.f, Body.GravityZ);
+	for (; Body.StepsDone < TargetSteps && !Body.bHit; ++Body.StepsDone)
+	{
+		// Same integration as UProjectileMovementComponent's ComputeMoveDelta / ComputeVelocity
+		const FVector End = Body.Location + Body.Velocity * StepSeconds + Acceleration * (0.5f * FMath::Square(StepSeconds));
+		FHitResult Hit;
+		if (World->SweepSingleByChannel(Hit, Body.Location, End, Body.Velocity.ToOrientationQuat(), Body.Channel, Body.Shape, Body.QueryParams, Body.ResponseParams))
+		{
+			Body.Location = Hit.Location;
+			Body.Hit = Hit;
+			Body.bHit = true;
+		}
+		else
+		{
+			Body.Location = End;
+		}
+		Body.Velocity += Acceleration * StepSeconds;
+	}
+}
+
+void UProjectileSimulationSubsystem::WaitForSteps()
+{
+	if (StepsTask.IsValid())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MPShooter_ProjectileSimSteps);
+		StepsTask.Wait();
+		StepsTask = UE::Tasks::FTask();
+	}
+}
+
+void UProjectileSimulationSubsystem::ApplySteps()
+{
+	// Moves and hits, in spawn order.
+	for (int32 Index = 0; Index < InFlight.Num(); ++Index)
+	{
+		FSimulatedProjectile& Simulated = Projectiles[Index];
+		Simulated.Body = MoveTemp(InFlight[Index].Body);
+		AProjectile* Projectile = Simulated.Projectile.Get();
+		if (Projectile == nullptr || Simulated.bHitDispatched) continue;
+
+		if (Simulated.Body.bHit && Simulated.Body.Hit.GetComponent() == nullptr)
+		{
+			Simulated.Body.bHit = false; // what it hit was destroyed since the step, it flies on from there with the next batch
+		}
+		Projectile->SetActorLocationAndRotation(Simulated.Body.Location, Simulated.Body.Velocity.Rotation()); // rotation follows velocity
+		Projectile->GetProjectileMovement()->Velocity = Simulated.Body.bHit ? FVector::ZeroVector : Simulated.Body.Velocity;
+		if (Simulated.Body.bHit)
+		{
+			Simulated.bHitDispatched = true; // clients keep it where it hit until the server destroys it, like the movement component did
+			Projectile->DispatchBlockingHit(Projectile->GetCollisionBox(), Simulated.Body.Hit.GetComponent(), true, Simulated.Body.Hit); // AProjectile::OnHit on the server
+		}
+	}
+	InFlight.Reset();
+}
+
+void UProjectileSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (Projectiles.Num() == 0) return;
+
+	MPSHOOTER_PERF_SCOPE(ProjectileSim);
+
+	// 1. Last frame's steps. The task had the whole frame, so this normally doesn't wait.
+	WaitForSteps();
+	ApplySteps();
+	Projectiles.RemoveAll([](const FSimulatedProjectile& Simulated) { return !Simulated.Projectile.IsValid(); }); // keeps spawn order, hits apply in it
+	if (Projectiles.Num() == 0) return;
+
+	// 2. This frame's steps, up to now, applied next frame. No UObjects are touched in the task, only the world's scene queries.
+	UWorld* World = GetWorld();
+	const double Now = World->GetTimeSeconds();
+	InFlight.SetNum(Projectiles.Num());
+	for (int32 Index = 0; Index < Projectiles.Num(); ++Index)
+	{
+		FSimulatedProjectile& Simulated = Projectiles[Index];
+		FStep& Step = InFlight[Index];
+		Step.Body = MoveTemp(Simulated.Body);
+		Step.StepSeconds = Simulated.StepSeconds;
+		const int32 TargetSteps = FMath::FloorToInt32((Now - Simulated.SpawnTime) / Simulated.StepSeconds + UE_KINDA_SMALL_NUMBER);
+		Step.TargetSteps = Simulated.bHitDispatched ? Step.Body.StepsDone : FMath::Min(TargetSteps, Step.Body.StepsDone + MaxStepsPerFrame);
+	}
+	const EParallelForFlags Flags = CVarProjectileSimParallel.GetValueOnGameThread() != 0 ? EParallelForFlags::BackgroundPriority : EParallelForFlags::ForceSingleThread;
+	StepsTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, World, Flags]()
+	{
+		ParallelFor(InFlight.Num(), [this, World](int32 Index)
+		{
+			FStep& Step = InFlight[Index];
+			Advance(World, Step.Body, Step.TargetSteps, Step.StepSeconds);
+		}, Flags);
+	});
+}
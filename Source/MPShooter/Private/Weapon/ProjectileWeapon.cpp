@@ -4,8 +4,21 @@
 #include "Weapon/ProjectileWeapon.h"
 #include "Engine/SkeletalMeshSocket.h"
 #include "Weapon/Projectile.h"
+#include "Instrumentation/LatencyHarnessSubsystem.h"
+#include "Instrumentation/MatchJournal.h"
+#include "Instrumentation/MPShooterMemory.h"
 
 
+void AProjectileWeapon::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	Super::GetPreloadAssets(OutAssets);
+	if (ProjectileClass)
+	{
+		OutAssets.Add(FSoftObjectPath(ProjectileClass.Get()));
+		ProjectileClass->GetDefaultObject<AProjectile>()->GetPreloadAssets(OutAssets);
+	}
+}
+
 // Spawning the projectile.
 void AProjectileWeapon::Fire(const FVector& HitTarget)
 {
@@ -24,11 +37,14 @@ void AProjectileWeapon::Fire(const FVector& HitTarget)
 			FActorSpawnParameters SpawnParams;
 			SpawnParams.Owner = GetOwner();
 			SpawnParams.Instigator = InstigatorPawn;
+			SpawnParams.CustomPreSpawnInitalization = [Key = FireShotKey](AActor* Actor) { CastChecked<AProjectile>(Actor)->SetShotKey(Key); }; // in the first replicated bunch
 
 			UWorld* World = GetWorld();
 			if (World)
 			{
+				LLM_SCOPE_BYTAG(MPShooter_Projectiles);
 				World->SpawnActor<AProjectile>(ProjectileClass, SocketTransform.GetLocation(), TargetRotation, SpawnParams);
+				ULatencyHarnessSubsystem::RecordStage(ELatencyHarnessStage::ProjectileSpawn, FMatchJournal::GetPlayerId(InstigatorPawn), FireShotKey);
 			}
 		}
 	}
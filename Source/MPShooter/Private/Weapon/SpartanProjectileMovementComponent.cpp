@@ -0,0 +1,11 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/SpartanProjectileMovementComponent.h"
+#include "Instrumentation/MPShooterStats.h"
+
+void USpartanProjectileMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	MPSHOOTER_PERF_SCOPE(ProjectileSim);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
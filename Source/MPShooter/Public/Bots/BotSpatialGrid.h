@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+
+/**
+ * Uniform 2D grid over XY for "who is near here" queries, shared by every bot instead of each one iterating all actors.
+ * Rebuilt from scratch each time (sorted by cell, no per-cell containers), so it costs nothing while idle and never allocates once warm.
+ */
+struct MPSHOOTER_API FBotSpatialGrid
+{
+	void Reset(float InCellSize);
+	void Add(int32 Id, const FVector& Location);
+	void Build(); // after the Adds, before any Query
+
+	// Calls Visitor(Id, Location, DistSquared) for every entry within Radius (2D) of Center
+	template<typename VisitorType>
+	void Query(const FVector& Center, float Radius, VisitorType&& Visitor) const
+	{
+		const float RadiusSquared = FMath::Square(Radius);
+		const FIntPoint Min = GetCell(Center - FVector(Radius));
+		const FIntPoint Max = GetCell(Center + FVector(Radius));
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			{
+				const uint64 Key = MakeKey(FIntPoint(X, Y));
+				for (int32 Index = Algo::LowerBoundBy(Entries, Key, &FEntry::Key); Index < Entries.Num() && Entries[Index].Key == Key; ++Index)
+				{
+					const FEntry& Entry = Entries[Index];
+					const float DistSquared = FVector::DistSquared2D(Center, Entry.Location);
+					if (DistSquared <= RadiusSquared)
+					{
+						Visitor(Entry.Id, Entry.Location, DistSquared);
+					}
+				}
+			}
+		}
+	}
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+
+private:
+
+	struct FEntry
+	{
+		uint64 Key;
+		int32 Id;
+		FVector Location;
+	};
+
+	FORCEINLINE FIntPoint GetCell(const FVector& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+	}
+
+	static FORCEINLINE uint64 MakeKey(const FIntPoint& Cell)
+	{
+		return (uint64(uint32(Cell.X)) << 32) | uint64(uint32(Cell.Y));
+	}
+
+	TArray<FEntry> Entries;
+	float InvCellSize = 1.f / 2000.f;
+};
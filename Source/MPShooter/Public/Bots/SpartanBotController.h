@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "SpartanBotController.generated.h"
+
+/**
+ * Possesses a bot's ASpartanCharacter and owns its PlayerState (score, health in the GameState, respawn like a player).
+ * Has no logic and doesn't tick: USpartanBotSubsystem decides for every bot and drives the character through the player input handlers.
+ */
+UCLASS()
+class MPSHOOTER_API ASpartanBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+
+	ASpartanBotController();
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CollisionQueryParams.h"
+#include "Bots/BotSpatialGrid.h"
+#include "SpartanBotSubsystem.generated.h"
+
+class ASpartanBotController;
+class ASpartanCharacter;
+class AWeapon;
+
+/**
+ * Server only. Bots for filling servers and soak tests (-Bots=N on the command line, MPShooter.Bots.Add / .Remove at runtime).
+ * Each frame: one shared spatial grid of characters (and, less often, pickups) for target queries; decisions (target, pickup,
+ * path) time-sliced round robin under MPShooter.Bots.ThinkBudgetMs for all bots together; the visibility traces those decisions
+ * ask for run as one parallel batch; then every bot's input goes through the same ASpartanCharacter / UCombatComponent
+ * handlers a player's does. Cost goes to "stat MPShooter" and, with MPShooter.Bots.ReportInterval, Profiling/MPShooter/Bots.csv.
+ */
+UCLASS()
+class MPSHOOTER_API USpartanBotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void AddBots(int32 Count);
+	void RemoveBots(int32 Count);
+	FORCEINLINE int32 NumBots() const { return Bots.Num(); }
+
+	void WriteReport(const FString& Label); // average / max AI cost since the last report, then resets
+
+private:
+
+	struct FBot
+	{
+		TWeakObjectPtr<ASpartanBotController> Controller;
+		TWeakObjectPtr<ASpartanCharacter> Target;
+		TWeakObjectPtr<AWeapon> Pickup;
+		TArray<FVector> Path;
+		int32 PathIndex = 0;
+		FVector LastSeenTargetLocation = FVector::ZeroVector;
+		FRotator AimNoise = FRotator::ZeroRotator; // re-rolled every think, so bots miss a little
+		double NextThinkTime = 0.0;
+		double NextShotTime = 0.0;
+		bool bTargetVisible = false;
+		bool bFireHeld = false;
+	};
+
+	// One line of sight check asked for by a think, run with the rest of the frame's batch
+	struct FVisibilityTrace
+	{
+		int32 BotIndex;
+		FVector Start;
+		FVector End;
+		FCollisionQueryParams QueryParams; // ignores the bot, its weapon and the target
+		bool bVisible = false;
+	};
+
+	void BuildGrids(double Now);
+	void Think(int32 BotIndex, ASpartanCharacter* Character, double Now);
+	void RunVisibilityTraces();
+	void Act(FBot& Bot, ASpartanCharacter* Character, float DeltaTime, double Now);
+	void FindPath(FBot& Bot, ASpartanCharacter* Character, const FVector& Destination);
+	bool FindRoamDestination(const ASpartanCharacter* Character, float Radius, FVector& OutDestination) const;
+
+	TArray<FBot> Bots;
+	int32 NextThinkBot = 0; // round robin cursor, so a tight budget still gets round everyone
+
+	FBotSpatialGrid CharacterGrid;
+	TArray<TWeakObjectPtr<ASpartanCharacter>> GridCharacters; // grid ids index into these
+	FBotSpatialGrid PickupGrid;
+	TArray<TWeakObjectPtr<AWeapon>> GridPickups;
+	double NextPickupGridTime = 0.0;
+
+	TArray<FVisibilityTrace> VisibilityTraces; // reused every frame
+
+	// Since the last report
+	double FrameMsSum = 0.0;
+	double FrameMsMax = 0.0;
+	int32 FramesMeasured = 0;
+	int32 Thinks = 0;
+	int32 OverdueThinks = 0; // a bot that was due this frame but didn't fit the budget
+	double LastReportTime = 0.0;
+};
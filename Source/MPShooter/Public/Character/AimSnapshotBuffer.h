@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Simulated proxy aim (actor yaw + view pitch) as received, played back a little in the past so a low net update rate still animates smoothly.
+ * Samples are stamped with the server's movement timestamp (ACharacter::ReplicatedServerLastTransformUpdateTimeStamp, replicated because the
+ * character sets bNetworkAlwaysReplicateTransformUpdateTimestamp), so the spacing between samples is what it was on the server rather than
+ * whenever the packet happened to arrive. Samples without a newer timestamp only update the pitch.
+ */
+class MPSHOOTER_API FAimSnapshotBuffer
+{
+public:
+	struct FSnapshot
+	{
+		double RemoteTime;
+		float Yaw;
+		float Pitch;
+	};
+
+	static constexpr int32 Capacity = 16;
+
+	void Add(double RemoteTime, double LocalTime, float Yaw, float Pitch);
+	bool Sample(double LocalTime, float& OutYaw, float& OutPitch) const; // false until the first snapshot
+	void Reset();
+
+	FORCEINLINE bool IsEmpty() const { return Num == 0; }
+	FORCEINLINE float GetDelay() const { return Delay; }
+	FORCEINLINE float GetExtrapolatedTime() const { return LastExtrapolation; } // how far past the newest snapshot the last Sample had to guess
+
+private:
+	const FSnapshot& Get(int32 Index) const { return Snapshots[(Head + Index) % Capacity]; } // 0 = oldest
+	void UpdateDelay(double RemoteTime, double LocalTime);
+
+	FSnapshot Snapshots[Capacity];
+	int32 Head = 0;
+	int32 Num = 0;
+
+	double ClockOffset = 0.0; // local - remote for the least delayed snapshot, creeps up slowly so drift and latency changes get through
+	double LastLocalArrival = 0.0;
+	float IntervalMean = 0.f; // remote time between snapshots
+	float Jitter = 0.f; // how much the arrival spacing differs from the remote spacing
+	float Delay = 0.f;
+	mutable float LastExtrapolation = 0.f;
+};
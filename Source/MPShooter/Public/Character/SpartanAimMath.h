@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MPShooter/SpartanTypes/TurningInPlace.h"
+
+// Aim offset and turn in place, per character. Yaws are in degrees.
+struct FSpartanAimInput
+{
+	FVector Velocity = FVector::ZeroVector;
+	bool bIsInAir = false;
+	float AimYaw = 0.f;		// base aim rotation
+	float AimPitch = 0.f;
+	bool bRemotePitch = false; // pitch came over the network compressed to [0, 360)
+	float DeltaTime = 0.f;
+};
+
+struct FSpartanAimState
+{
+	float AO_Yaw = 0.f;
+	float Interp_AO_Yaw = 0.f;
+	float AO_Pitch = 0.f;
+	float StartingAimYaw = 0.f; // aim yaw when we stopped moving
+	ETurningInPlace TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+};
+
+// Running blend space inputs, per anim instance.
+struct FSpartanLocomotionState
+{
+	FRotator DeltaRotation = FRotator::ZeroRotator; // smoothed movement vs aim
+	float YawOffset = 0.f;
+	float CorrectiveRate = 1.f;
+};
+
+// Procedural fire recoil, per anim instance: a critically damped spring per axis (pitch, yaw in degrees), kicked once per shot.
+struct FSpartanRecoilState
+{
+	FVector2D Offset = FVector2D::ZeroVector;
+	FVector2D Velocity = FVector2D::ZeroVector; // degrees / s
+};
+
+/**
+ * The character's aim offset / turn in place and the anim instance's lean / yaw offset / recoil, as pure functions over the structs above.
+ * No actor access, so they can be benchmarked (MPShooter.BenchAimMath) and tested (MPShooter.AimMath automation tests) in isolation.
+ */
+struct FSpartanAimMath
+{
+	static constexpr float TurnRightThreshold = 70.f;
+	static constexpr float TurnLeftThreshold = -90.f;
+	static constexpr float TurnFinishedThreshold = 15.f;
+	static constexpr float TurnInterpSpeed = 4.f;
+	static constexpr float LeanInterpSpeed = 6.f;
+	static constexpr float LeanLimit = 90.f;
+	static constexpr float YawOffsetInterpSpeed = 6.f;
+	static constexpr float CorrectiveYawOffset = 45.f;
+
+	static FORCEINLINE float GroundSpeed(const FVector& Velocity)
+	{
+		return FVector(Velocity.X, Velocity.Y, 0.f).Size();
+	}
+
+	static FORCEINLINE float AimPitch(float Pitch, bool bRemotePitch)
+	{
+		// Map pitch from [270, 360) to [-90, 0), it's compressed to an unsigned range when replicated
+		if (Pitch > 90.f && bRemotePitch)
+		{
+			return FMath::GetMappedRangeValueClamped(FVector2D(270.f, 360.f), FVector2D(-90.f, 0.f), Pitch);
+		}
+		return Pitch;
+	}
+
+	static FORCEINLINE void TurnInPlace(FSpartanAimState& State, float AimYaw, float DeltaTime)
+	{
+		if (State.AO_Yaw > TurnRightThreshold)
+		{
+			State.TurningInPlace = ETurningInPlace::ETIP_Right;
+		}
+		else if (State.AO_Yaw < TurnLeftThreshold)
+		{
+			State.TurningInPlace = ETurningInPlace::ETIP_Left;
+		}
+		if (State.TurningInPlace != ETurningInPlace::ETIP_NotTurning)
+		{
+			State.Interp_AO_Yaw = FMath::FInterpTo(State.Interp_AO_Yaw, 0.f, DeltaTime, TurnInterpSpeed);
+			State.AO_Yaw = State.Interp_AO_Yaw;
+			if (FMath::Abs(State.AO_Yaw) < TurnFinishedThreshold) // turned far enough, aim from here
+			{
+				State.TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+				State.StartingAimYaw = AimYaw;
+			}
+		}
+	}
+
+	// Only called while a weapon is equipped
+	static FORCEINLINE FSpartanAimState UpdateAimOffset(const FSpartanAimState& Previous, const FSpartanAimInput& Input)
+	{
+		FSpartanAimState State = Previous;
+		const float Speed = GroundSpeed(Input.Velocity);
+		if (Speed == 0.f && !Input.bIsInAir) // standing still: aim offset against where we stopped, turn in place past the limits
+		{
+			State.AO_Yaw = FRotator::NormalizeAxis(Input.AimYaw - State.StartingAimYaw);
+			if (State.TurningInPlace == ETurningInPlace::ETIP_NotTurning)
+			{
+				State.Interp_AO_Yaw = State.AO_Yaw;
+			}
+			TurnInPlace(State, Input.AimYaw, Input.DeltaTime);
+		}
+		if (Speed > 0.f || Input.bIsInAir) // moving: the body follows the aim
+		{
+			State.StartingAimYaw = Input.AimYaw;
+			State.AO_Yaw = 0.f;
+			State.TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+		}
+		State.AO_Pitch = AimPitch(Input.AimPitch, Input.bRemotePitch);
+		return State;
+	}
+
+	static FORCEINLINE float UpdateLean(float Lean, float ActorYaw, float LastActorYaw, float DeltaTime)
+	{
+		if (DeltaTime <= 0.f) return Lean; // the yaw rate is undefined, keep the last lean instead of going NaN
+		const float Target = FRotator::NormalizeAxis(ActorYaw - LastActorYaw) / DeltaTime; // yaw rate, the delta alone is tiny
+		return FMath::Clamp(FMath::FInterpTo(Lean, Target, DeltaTime, LeanInterpSpeed), -LeanLimit, LeanLimit);
+	}
+
+	static FORCEINLINE void UpdateYawOffset(FSpartanLocomotionState& State, const FRotator& AimRotation, const FVector& Velocity, float DeltaTime)
+	{
+		const FRotator MovementRotation = FRotationMatrix::MakeFromX(Velocity).Rotator();
+		const FRotator Delta = (MovementRotation - AimRotation).GetNormalized();
+		State.DeltaRotation = FMath::RInterpTo(State.DeltaRotation, Delta, DeltaTime, YawOffsetInterpSpeed);
+		State.YawOffset = State.DeltaRotation.Yaw;
+		State.CorrectiveRate = FMath::Abs(State.YawOffset) > CorrectiveYawOffset ? FMath::Clamp(CorrectiveYawOffset / FMath::Abs(State.YawOffset), 0.5f, 1.0f) : 1.0f;
+	}
+
+	// Kick is the peak offset of a single shot from rest; closely spaced shots stack until MaxOffset.
+	static FORCEINLINE void AddRecoilImpulse(FSpartanRecoilState& State, const FVector2D& Kick, float Frequency)
+	{
+		State.Velocity += Kick * (Frequency * UE_EULERS_NUMBER); // a critically damped spring kicked with v from rest peaks at v / (w * e)
+	}
+
+	// Closed form step of x'' = -w^2 x - 2w x', stable at any frame time (no per-shot montage, just this)
+	static FORCEINLINE void UpdateRecoil(FSpartanRecoilState& State, float Frequency, float MaxOffset, float DeltaTime)
+	{
+		if (DeltaTime <= 0.f) return;
+		const float Decay = FMath::Exp(-Frequency * DeltaTime);
+		const FVector2D Rate = State.Velocity + State.Offset * Frequency;
+		State.Offset = (State.Offset + Rate * DeltaTime) * Decay;
+		State.Velocity = (State.Velocity - Rate * (Frequency * DeltaTime)) * Decay;
+		for (int32 Axis = 0; Axis < 2; ++Axis)
+		{
+			if (FMath::Abs(State.Offset[Axis]) > MaxOffset) // pinned at the limit, drop the velocity that would carry it past
+			{
+				State.Offset[Axis] = FMath::Clamp(State.Offset[Axis], -MaxOffset, MaxOffset);
+				State.Velocity[Axis] = State.Velocity[Axis] * State.Offset[Axis] > 0.f ? 0.f : State.Velocity[Axis];
+			}
+		}
+	}
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
 #include "MPShooter/SpartanTypes/TurningInPlace.h"
+#include "Character/SpartanAimMath.h"
 #include "SpartanAnimInstance.generated.h"
 
 
@@ -20,6 +21,12 @@ public:
 	virtual void NativeInitializeAnimation() override;
 	virtual void NativeUpdateAnimation(float DeltaTime) override;
 
+	void ResetForRespawn(); // so lean and yaw offset don't blend from where the pawn died
+
+	// One shot's worth of kick for the additive recoil layer; replaces restarting the fire montage every shot
+	void AddRecoilImpulse(bool bAimingShot);
+	void CancelRecoil(); // a predicted shot was rejected: stop climbing and settle back from wherever the kick got to
+
 private:
 
 	void UpdateIKState();
@@ -27,6 +34,7 @@ private:
 	void UpdateWeaponState();
 	void UpdateCharacterLean(float DeltaTime);
 	void CalculateYawOffset(float DeltaTime);
+	void UpdateRecoil(float DeltaTime);
 
 	UPROPERTY(BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	float CorrectiveRate;
@@ -59,7 +67,7 @@ private:
 
 	FRotator CharacterRotation;
 	FRotator CharacterRotationLastFrame;
-	FRotator DeltaRotation; //Used to smooth out blend space movement
+	FSpartanLocomotionState Locomotion; // smoothed yaw offset, copied to YawOffset/CorrectiveRate for the ABP
 
 	// FABRIK Hand IK, LeftHandTransform will have the position of our LeftHandSocket on the Weapon.
 	UPROPERTY(BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
@@ -69,5 +77,28 @@ private:
 	UPROPERTY(BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	ETurningInPlace TurningInPlace;
 
+	// Additive recoil layer inputs: Transform (Modify) Bone on the spine / right hand, or RecoilAlpha as the weight of an additive recoil pose
+	// Not wired yet: the anim blueprint doesn't read these, so MPShooter.ProceduralRecoil stays 0 and fire still plays FireWeaponMontage.
+	// Before turning it on, add the layer to the blueprint and compare MPShooter.BenchFireAnim with the cvar at 0 and at 1.
+	UPROPERTY(BlueprintReadOnly, Category = Recoil, meta = (AllowPrivateAccess = "true"))
+	float RecoilPitch;
+	UPROPERTY(BlueprintReadOnly, Category = Recoil, meta = (AllowPrivateAccess = "true"))
+	float RecoilYaw;
+	UPROPERTY(BlueprintReadOnly, Category = Recoil, meta = (AllowPrivateAccess = "true"))
+	float RecoilAlpha;
+
+	// Peak pitch / yaw (degrees) of a single shot from rest, yaw goes either way
+	UPROPERTY(EditDefaultsOnly, Category = Recoil)
+	FVector2D HipFireRecoilKick = FVector2D(2.5f, 1.f);
+	UPROPERTY(EditDefaultsOnly, Category = Recoil)
+	FVector2D AimingRecoilKick = FVector2D(1.2f, 0.4f);
+	// Spring frequency (rad/s): a single shot peaks after 1 / frequency and has settled after about 5 / frequency
+	UPROPERTY(EditDefaultsOnly, Category = Recoil, meta = (ClampMin = "1.0"))
+	float RecoilFrequency = 20.f;
+	UPROPERTY(EditDefaultsOnly, Category = Recoil, meta = (ClampMin = "0.1"))
+	float MaxRecoilOffset = 10.f;
+
+	FSpartanRecoilState Recoil;
+
 
 };
@@ -6,6 +6,8 @@
 #include "GameFramework/Character.h"
 #include "InputActionValue.h"
 #include "MPShooter/SpartanTypes/TurningInPlace.h"
+#include "Character/SpartanAimMath.h"
+#include "Character/AimSnapshotBuffer.h"
 #include "SpartanCharacter.generated.h"
 
 class UInputAction;
@@ -18,7 +20,8 @@ class MPSHOOTER_API ASpartanCharacter : public ACharacter
 
 public:
 
-	ASpartanCharacter();
+	ASpartanCharacter(const FObjectInitializer& ObjectInitializer);
+	friend class USpartanBotSubsystem; // bots press the same input handlers a player does
 	
 	virtual void Tick(float DeltaTime) override;
 
@@ -28,8 +31,21 @@ public:
 
 	virtual void PostInitializeComponents() override;
 
+	virtual void PostNetReceive() override; // Simulated proxies: feeds the replicated aim into AimSnapshots
+
+	// Server: routes damage (projectile impacts, hitscan via UGameplayStatics::ApplyPointDamage) into the GameState's combat stats
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
 	// ANIM MONTAGE
-	void PlayFireMontage(bool bAiming);
+	void PlayFireMontage(bool bAiming); // the fire montage, or an additive recoil kick with MPShooter.ProceduralRecoil 1
+	void StopFireMontage(); // Rolls back a predicted shot the server rejected
+
+	// Elimination and pooled respawn (server drives these, clients follow through the OnReps)
+	void Elim();
+	void EnterPool(); // hidden, no collision or tick, net-dormant
+	void LeavePool(const FTransform& SpawnTransform);
+
+	void ApplyServerFidelity(const struct FServerFidelity& Fidelity); // Server: net rate and (dedicated) anim rate, set by UServerTickGovernorSubsystem
 
 
 protected:
@@ -47,6 +63,8 @@ protected:
 	UPROPERTY(EditAnywhere, Category = Input)
 	UInputAction* EquipAction;
 	UPROPERTY(EditAnywhere, Category = Input)
+	UInputAction* SwapWeaponAction;
+	UPROPERTY(EditAnywhere, Category = Input)
 	UInputAction* CrouchAction;
 	UPROPERTY(EditAnywhere, Category = Input)
 	UInputAction* AimAction;
@@ -57,6 +75,7 @@ protected:
 	void Move(const FInputActionValue& Value);
 	void MouseLook(const FInputActionValue& Value);
 	void EquipButtonPressed();
+	void SwapWeaponButtonPressed();
 	void CrouchButtonPressed();
 	void AimButtonPressed();
 	void FireButtonPressed();
@@ -65,6 +84,7 @@ protected:
 
 	// Used to set aim offset variables
 	void AimOffset(float DeltaTime);
+	void UpdateRenderAim(); // RenderAimRotation for this frame
 
 	
 
@@ -78,8 +98,6 @@ private:
 	class UCameraComponent* FollowCamera;
 	UPROPERTY(VisibleAnywhere)
 	class USpringArmComponent* CameraBoom;
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	class UWidgetComponent* OverheadWidget;
 
 	UPROPERTY(ReplicatedUsing = OnRep_OverlappingWeapon)
 	class AWeapon* OverlappingWeapon; // (B) Makes this a replicated variable
@@ -87,35 +105,65 @@ private:
 	UFUNCTION()
 	void OnRep_OverlappingWeapon(AWeapon* LastWeapon); // (C) OnRep doesnt replicate Client -> Server, so you wont see the widget on the server, only client, so we need to handle scenario where server is client
 														// (E2) Adding input LastWeapon, and added it to our function call.
+	void UpdatePickupPrompt(); // Points the local player's shared pickup prompt at OverlappingWeapon
 	UPROPERTY(VisibleAnywhere)
 	class UCombatComponent* Combat;
 
+	// Server: loads the World Partition cells around us (clients stream around their own player controller)
+	UPROPERTY(VisibleAnywhere)
+	class UWorldPartitionStreamingSourceComponent* StreamingSource;
+
+	// Loading range and net cull distance on maps without a World Partition runtime grid; with one, the grid's loading range is used for both
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float StreamingLoadingRange;
+
 	UFUNCTION(Server, Reliable)  // Remote Procedure Call (Allows client to request server to do an action like pick up weapon.  Server handles/allows the pickup. //Reliable RPC means that confirmation of the packet between server and client will occur.  If it doesnt occur, packet will be reset.  Use sparingly.
 	void ServerEquipButtomPressed();
 
 	// Used to set the AO inputs on the character class, which we will make a Getter for for use in the AnimInstance
-	float AO_Yaw;
-	float Interp_AO_Yaw;
-	float AO_Pitch;
-	FRotator StartingAimRotation;
+	// AO yaw/pitch and TurningInPlace, updated by FSpartanAimMath
+	FSpartanAimState AimState;
 
-	// Use TurningInPlace ENUM for TIP functionality
-	ETurningInPlace TurningInPlace;
-	void TurnInPlace(float DeltaTime); // we include delta time just incase we want to do some.. interpolating..?
+	// Simulated proxies render aim and rotation from here, a little in the past, so the character can replicate at a low rate
+	FAimSnapshotBuffer AimSnapshots;
+	FRotator RenderAimRotation;
+	bool bRenderAimFromSnapshots;
 
 	UPROPERTY(EditAnywhere, Category = Combat)
 	class UAnimMontage* FireWeaponMontage;
 
+	UPROPERTY(ReplicatedUsing = OnRep_Eliminated)
+	bool bEliminated;
+	UFUNCTION()
+	void OnRep_Eliminated();
+	void ApplyEliminated(); // ragdoll, no capsule collision, no movement
+
+	UPROPERTY(ReplicatedUsing = OnRep_RespawnCount)
+	uint8 RespawnCount; // bumped on every pooled respawn so clients reset their local state too
+	UFUNCTION()
+	void OnRep_RespawnCount();
+	void ResetForRespawn(); // AO, turning in place, combat state, montages, ragdoll
+
+	FTransform MeshRelativeTransform; // to put the mesh back on the capsule after ragdoll
+	FName MeshCollisionProfile;
+
 public:
 
 	void SetOverlappingWeapon(AWeapon* Weapon); // (B) Public Setter for Overlapping Weapon
 	bool IsWeaponEquipped(); 
 	bool bIsAiming();
-	FORCEINLINE float GetAO_Yaw() const { return AO_Yaw; } // Getter for AO YAW
-	FORCEINLINE float GetAO_Pitch() const { return AO_Pitch; } // Getter for Pitch
+	void OnServerAimingChanged(bool bAiming); // Called by the movement component when a client move changes the aim flag
+	class USpartanMovementComponent* GetSpartanMovement() const;
+	FORCEINLINE float GetAO_Yaw() const { return AimState.AO_Yaw; } // Getter for AO YAW
+	FORCEINLINE float GetAO_Pitch() const { return AimState.AO_Pitch; } // Getter for Pitch
 	AWeapon* GetEquippedWeapon(); // Getter for EquippedWeapon used in FABRIK IK.
+	FORCEINLINE UCombatComponent* GetCombat() const { return Combat; }
+	FORCEINLINE bool IsEliminated() const { return bEliminated; }
 
-	FORCEINLINE ETurningInPlace GetTurningInPlace() const { return TurningInPlace; } // Getter for use in AnimInstance
+	FORCEINLINE const FRotator& GetRenderAimRotation() const { return RenderAimRotation; } // Base aim rotation, or the snapshot buffer's for simulated proxies
+	FORCEINLINE FRotator GetRenderActorRotation() const { return bRenderAimFromSnapshots ? FRotator(0.f, RenderAimRotation.Yaw, 0.f) : GetActorRotation(); }
+	FORCEINLINE const FAimSnapshotBuffer& GetAimSnapshots() const { return AimSnapshots; }
+	FORCEINLINE ETurningInPlace GetTurningInPlace() const { return AimState.TurningInPlace; } // Getter for use in AnimInstance
 
 
 
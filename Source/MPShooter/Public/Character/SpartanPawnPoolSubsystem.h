@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SpartanPawnPoolSubsystem.generated.h"
+
+class ASpartanCharacter;
+
+/**
+ * Server only. Keeps eliminated characters around (hidden and net-dormant) so respawning reuses them instead of
+ * destroying and spawning a new pawn with all its components and a fresh actor channel on every client.
+ */
+UCLASS()
+class MPSHOOTER_API USpartanPawnPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	void Release(ASpartanCharacter* Character); // Character must already be unpossessed
+	ASpartanCharacter* Acquire(TSubclassOf<ASpartanCharacter> CharacterClass); // null if nothing of that class is pooled
+
+	FORCEINLINE int32 GetNumPooled() const { return PooledCharacters.Num(); }
+
+private:
+
+	UPROPERTY()
+	TArray<ASpartanCharacter*> PooledCharacters;
+};
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShotValidationSubsystem.generated.h"
+
+class UCombatComponent;
+
+struct FShotValidationJob
+{
+	FVector TraceStart = FVector::ZeroVector;
+	FVector TraceEnd = FVector::ZeroVector;
+	FCollisionQueryParams QueryParams;
+	bool bPrecheckPassed = false; // cheap game thread checks (weapon equipped, range)
+	bool bAccepted = false;
+};
+
+/**
+ * Server only. ServerFire RPCs are queued here and validated once per frame as a batch: the line-of-sight traces
+ * run in parallel while the game thread waits (so they all see the same world), then results are applied in the
+ * order the shots arrived.
+ */
+UCLASS()
+class MPSHOOTER_API UShotValidationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void QueueShot(UCombatComponent* Combat, const FVector_NetQuantize& TraceHitTarget, uint16 PredictionKey);
+
+	// Runs the traces for every job that passed its precheck. Public so the benchmark command can drive it.
+	static void RunValidationTraces(UWorld* World, TArray<FShotValidationJob>& Jobs, bool bParallel);
+
+	// The precheck (UCombatComponent::IsFireInRange) and the muzzle to target trace setup. False if the precheck fails.
+	static bool PrepareJob(const UCombatComponent* Combat, const FVector& TraceHitTarget, FShotValidationJob& Job);
+	static void TraceJob(const UWorld* World, FShotValidationJob& Job, float Tolerance); // thread safe
+	static float GetTolerance();
+
+private:
+
+	struct FQueuedShot
+	{
+		TWeakObjectPtr<UCombatComponent> Combat;
+		FVector_NetQuantize TraceHitTarget;
+		uint16 PredictionKey;
+	};
+
+	TArray<FQueuedShot> QueuedShots;
+	TArray<FShotValidationJob> Jobs; // Reused every frame
+};
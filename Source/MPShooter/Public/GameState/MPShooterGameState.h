@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "MPShooterGameState.generated.h"
+
+// One player's health, armor and score. Only entries that change are sent.
+USTRUCT()
+struct FPlayerCombatStats : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	APlayerState* PlayerState = nullptr;
+	UPROPERTY()
+	float Health = 0.f;
+	UPROPERTY()
+	float Armor = 0.f;
+	UPROPERTY()
+	int32 Kills = 0;
+	UPROPERTY()
+	int32 Deaths = 0;
+};
+
+USTRUCT()
+struct FPlayerCombatStatsArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FPlayerCombatStats> Items;
+
+	FPlayerCombatStats* Find(const APlayerState* PlayerState);
+	const FPlayerCombatStats* Find(const APlayerState* PlayerState) const;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FPlayerCombatStats, FPlayerCombatStatsArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FPlayerCombatStatsArray> : public TStructOpsTypeTraitsBase2<FPlayerCombatStatsArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Holds per-player combat stats for the whole match in a single fast array, instead of replicated floats on every character.
+ * AGameStateBase, to go with AMPShooterGameModeBase (AGameState expects an AGameMode and its match states).
+ */
+UCLASS()
+class MPSHOOTER_API AMPShooterGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+
+	AMPShooterGameState();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void AddPlayerState(APlayerState* PlayerState) override;
+	virtual void RemovePlayerState(APlayerState* PlayerState) override;
+
+	// Server only. Armor soaks ArmorAbsorption of the damage until it runs out. Returns the health actually removed.
+	float ApplyDamage(APlayerState* Victim, APlayerState* DamageInstigator, float Damage, bool& bOutKilled);
+	void ResetPlayerHealth(APlayerState* PlayerState); // Full health and starting armor, keeps the score
+	void RestoreScore(APlayerState* PlayerState, int32 Kills, int32 Deaths); // Server: from a match snapshot
+	void RestoreHealth(APlayerState* PlayerState, float Health, float Armor);
+
+	const FPlayerCombatStats* GetCombatStats(const APlayerState* PlayerState) const { return CombatStats.Find(PlayerState); }
+
+protected:
+
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	float MaxHealth;
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	float StartingArmor;
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	float ArmorAbsorption; // 0..1
+
+private:
+
+	UPROPERTY(Replicated)
+	FPlayerCombatStatsArray CombatStats;
+};
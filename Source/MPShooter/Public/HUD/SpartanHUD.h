@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "SpartanHUD.generated.h"
+
+class ASpartanCharacter;
+
+/**
+ * Per local player HUD. Draws every character nameplate in a single canvas pass instead of one widget component per character.
+ */
+UCLASS()
+class MPSHOOTER_API ASpartanHUD : public AHUD
+{
+	GENERATED_BODY()
+
+public:
+
+	ASpartanHUD();
+
+	virtual void DrawHUD() override;
+
+	// One prompt per local player, following whichever weapon we currently overlap. Null hides it.
+	void SetPickupPromptTarget(class AWeapon* Weapon);
+
+protected:
+
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	class UFont* NameplateFont;
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	FLinearColor NameplateColor;
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	float NameplateMaxDistance; // Beyond this distance (cm) nameplates are culled.
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	float NameplateHeightOffset; // Added above the top of the capsule.
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	float NameplateOcclusionGrace; // Characters not rendered within this many seconds count as occluded.
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	float NameplateTextRefreshInterval; // How often cached text is compared against the source string.
+	UPROPERTY(EditAnywhere, Category = Nameplates)
+	bool bShowNetRole; // Debug: show the remote net role instead of the player name (what the old overhead widget showed).
+
+	UPROPERTY(EditAnywhere, Category = Pickup)
+	TSubclassOf<class UUserWidget> PickupPromptClass; // If unset, PickupPromptText is drawn on the canvas instead.
+	UPROPERTY(EditAnywhere, Category = Pickup)
+	FText PickupPromptText;
+	UPROPERTY(EditAnywhere, Category = Pickup)
+	FVector PickupPromptOffset; // World offset from the weapon's origin
+
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float HitMarkerDuration;
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float HitMarkerSize;
+
+private:
+
+	struct FNameplateEntry
+	{
+		FString SourceString;
+		FText Text;
+		float TextWidth = 0.f;
+		float NextRefreshTime = 0.f;
+		uint64 LastSeenFrame = 0; // GFrameCounter
+	};
+
+	struct FVisibleNameplate
+	{
+		FVector2D ScreenPosition;
+		float DistanceSquared;
+		float TextWidth;
+		FText Text; // shares the cached text, no string copy
+	};
+
+	void DrawNameplates();
+	void DrawCombatStatus(); // local health/armor and hit markers
+	void UpdatePickupPrompt();
+	void RefreshNameplateText(ASpartanCharacter* Character, FNameplateEntry& Entry);
+	void BuildNameplateString(ASpartanCharacter* Character, FString& OutString) const;
+
+	TMap<TWeakObjectPtr<ASpartanCharacter>, FNameplateEntry> NameplateCache;
+	TArray<FVisibleNameplate> VisibleNameplates; // Reused every frame
+
+	UPROPERTY()
+	UUserWidget* PickupPrompt; // Created once on first use, then only repositioned
+	TWeakObjectPtr<AWeapon> PickupPromptTarget;
+};
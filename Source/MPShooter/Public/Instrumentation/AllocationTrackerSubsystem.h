@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Task.h"
+#include "UObject/UObjectArray.h"
+#include "AllocationTrackerSubsystem.generated.h"
+
+/**
+ * Counts UObject constructions/destructions per class per frame and logs each GC pause next to what gameplay allocated since the
+ * previous one. Enable with MPShooter.TrackAllocations 1 (or -TrackAllocations), read with MPShooter.AllocReport.
+ * GC pauses are appended to Saved/Profiling/MPShooter/GC.csv.
+ */
+UCLASS()
+class MPSHOOTER_API UAllocationTrackerSubsystem : public UGameInstanceSubsystem, public FUObjectArray::FUObjectCreateListener, public FUObjectArray::FUObjectDeleteListener
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FUObjectCreateListener / FUObjectDeleteListener, called from any thread
+	virtual void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override;
+	virtual void NotifyUObjectDeleted(const UObjectBase* Object, int32 Index) override;
+	virtual void OnUObjectArrayShutdown() override;
+
+	void SetTracking(bool bEnable);
+	void Reset();
+	void DumpReport() const;
+
+	static UAllocationTrackerSubsystem* Get() { return Instance; }
+	static bool IsTracking() { return Instance && Instance->bTracking; }
+
+private:
+
+	bool TickFrame(float DeltaTime);
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	struct FClassAllocStats
+	{
+		FName ClassName;
+		uint64 Created = 0;
+		uint64 Destroyed = 0;
+		uint32 CreatedThisFrame = 0;
+		uint32 MaxCreatedInFrame = 0;
+		uint64 CreatedSinceGC = 0;
+	};
+
+	static UAllocationTrackerSubsystem* Instance;
+
+	mutable FCriticalSection StatsLock;
+	TMap<const UClass*, FClassAllocStats> ClassStats; // key is never dereferenced, the class may be gone by the time we report
+	uint32 ObjectsCreatedThisFrame = 0;
+	uint32 ObjectsDestroyedThisFrame = 0;
+	uint64 ObjectsCreatedSinceGC = 0;
+	uint64 ObjectsDestroyedSinceGC = 0;
+
+	uint64 FramesTracked = 0;
+	uint32 MaxObjectsCreatedInFrame = 0;
+	uint64 TotalObjectsCreated = 0;
+
+	double GCStartTime = 0.0;
+	uint32 NumGCs = 0;
+	double GCPauseMsSum = 0.0;
+	double GCPauseMsMax = 0.0;
+	UE::Tasks::FTask GCCsvTask; // GC.csv rows are appended off the game thread, one after the other
+
+	bool bTracking = false;
+	FTSTicker::FDelegateHandle FrameTickHandle;
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
+
+/**
+ * Fails (log, or ensure with MPShooter.AllocBudgetAssert 1) when the code inside the scope constructs more than Budget UObjects.
+ * Only what the scope's own path constructs counts: objects made on the game thread while it is the innermost open scope, not
+ * those of a nested scope, of other threads or of the package loader. Only measures while enabled (the tracker turns budgets on
+ * with itself), so it costs nothing otherwise.
+ */
+class MPSHOOTER_API FUObjectAllocationBudgetScope
+{
+public:
+
+	FUObjectAllocationBudgetScope(const TCHAR* InName, int32 InBudget);
+	~FUObjectAllocationBudgetScope();
+
+	static void SetEnabled(bool bEnable);
+	static bool IsEnabled();
+	static void ResetViolations();
+	static void DumpViolations();
+	static uint32 GetViolations(const TCHAR* InName, int32* OutWorst = nullptr); // since the last reset
+
+private:
+
+	friend class FUObjectBudgetListener;
+
+	const TCHAR* Name;
+	int32 Budget;
+	int32 Created = 0;
+	FUObjectAllocationBudgetScope* Outer = nullptr;
+	bool bActive;
+};
+
+#define MPSHOOTER_UOBJECT_BUDGET_SCOPE(Name, Budget) FUObjectAllocationBudgetScope UObjectBudget_##Name(TEXT(#Name), Budget)
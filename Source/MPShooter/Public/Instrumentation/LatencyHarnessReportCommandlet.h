@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LatencyHarnessReportCommandlet.generated.h"
+
+/**
+ * Joins the stage timestamps written by ULatencyHarnessSubsystem and prints latency percentiles per stage.
+ * UnrealEditor-Cmd MPShooter.uproject -run=LatencyHarnessReport [-Dir=<dir>] [-Label=<run name>] [-CSV=<summary csv>]
+ */
+UCLASS()
+class MPSHOOTER_API ULatencyHarnessReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	ULatencyHarnessReportCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
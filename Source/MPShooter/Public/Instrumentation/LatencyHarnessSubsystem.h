@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "LatencyHarnessSubsystem.generated.h"
+
+enum class ELatencyHarnessStage : uint8
+{
+	ClientInput,		// shooter's client, FireButtonPressed
+	ServerFire,			// server, ServerFire received
+	ProjectileSpawn,	// server, AProjectile spawned for the shot
+	ObserverReplicated,	// every other client, the projectile's BeginPlay
+	Impact,				// server, projectile hit
+
+	Count
+};
+
+/**
+ * Fire-to-impact latency harness, enabled with -LatencyHarness (see Scripts/RunLatencyHarness.sh).
+ * Server: arms every character with a weapon and quits after -HarnessDuration seconds.
+ * Clients (-nullrhi): aim at the nearest other character and fire through UCombatComponent::FireButtonPressed every -HarnessFireInterval.
+ * Every process timestamps the stages it sees with FPlatformTime (one monotonic clock for all processes on the machine) and writes
+ * them to Saved/LatencyHarness; -run=LatencyHarnessReport joins them by shooter and prediction key and prints percentiles.
+ */
+UCLASS()
+class MPSHOOTER_API ULatencyHarnessSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	static FORCEINLINE bool IsActive() { return Instance != nullptr; }
+	static void RecordStage(ELatencyHarnessStage Stage, uint32 ShooterId, uint16 Key, uint32 ObserverId = 0);
+
+	static FString GetOutputDirectory();
+
+private:
+
+	bool Tick(float DeltaTime);
+	void TickServer(UWorld* World);
+	void TickClient(UWorld* World);
+	void FlushEvents();
+
+	struct FStageEvent
+	{
+		double Time;
+		uint32 ShooterId;
+		uint32 ObserverId;
+		uint16 Key;
+		ELatencyHarnessStage Stage;
+	};
+
+	static ULatencyHarnessSubsystem* Instance;
+
+	TArray<FStageEvent> Events;
+	FString OutputPath;
+	FTSTicker::FDelegateHandle TickHandle;
+
+	double StartTime = 0.0;
+	double LastFireTime = 0.0;
+	double LastFlushTime = 0.0;
+	float Duration = 60.f;
+	float FireInterval = 0.25f;
+	bool bFireHeld = false;
+};
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed bucket latency histogram (1 ms buckets up to 1 s, plus one overflow bucket). No allocations, cheap to keep per client.
+ */
+struct MPSHOOTER_API FLatencyHistogram
+{
+	static constexpr int32 NumBuckets = 1000;
+	static constexpr double BucketMs = 1.0;
+
+	void Add(double Ms);
+	void Reset();
+
+	double GetPercentile(double Percentile) const; // Percentile in [0, 100], resolved to the bucket's upper edge
+	FORCEINLINE uint32 GetCount() const { return Count; }
+	FORCEINLINE double GetAverage() const { return Count > 0 ? SumMs / Count : 0.0; }
+	FORCEINLINE double GetMax() const { return MaxMs; }
+
+	FString ToString() const; // "n=.. avg=.. p50=.. p90=.. p99=.. max=.."
+
+private:
+
+	uint32 Buckets[NumBuckets + 1] = {};
+	uint32 Count = 0;
+	double SumMs = 0.0;
+	double MaxMs = 0.0;
+};
@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The CSV files our reports and benches append to. The header goes in when the file is started; a file started with a
+ * different header (columns added or moved since) is renamed to <Name>.<UTC time>.csv and a new one is started, so every row
+ * lines up with the header above it. Thread safe, the file is opened per call.
+ */
+struct MPSHOOTER_API FMPShooterCsv
+{
+	static FString GetPath(const TCHAR* FileName); // Profiling/MPShooter/<FileName>
+	static FString Now(); // UTC, ISO 8601, for the Time column
+
+	// Header without a line terminator, Rows with one after each row
+	static bool Append(const FString& Path, const FString& Header, const FString& Rows);
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MPShooterMemReportCommandlet.generated.h"
+
+/**
+ * Loads a map (optional) and writes the MPShooter memory report, see FMPShooterMemoryReport.
+ * UnrealEditor-Cmd MPShooter.uproject -run=MPShooterMemReport [-Map=/Game/Maps/BlasterMap] [-Out=<path>] [-llm]
+ */
+UCLASS()
+class MPSHOOTER_API UMPShooterMemReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UMPShooterMemReportCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// LLM tags for our gameplay code, shown under "MPShooter" in 'stat LLMFULL' and the LLM CSV (-llm -llmcsv).
+LLM_DECLARE_TAG_API(MPShooter, MPSHOOTER_API);
+LLM_DECLARE_TAG_API(MPShooter_Characters, MPSHOOTER_API);
+LLM_DECLARE_TAG_API(MPShooter_Combat, MPSHOOTER_API);
+LLM_DECLARE_TAG_API(MPShooter_Weapons, MPSHOOTER_API);
+LLM_DECLARE_TAG_API(MPShooter_Projectiles, MPSHOOTER_API);
+LLM_DECLARE_TAG_API(MPShooter_HUD, MPSHOOTER_API);
+LLM_DECLARE_TAG_API(MPShooter_Animation, MPSHOOTER_API);
+
+/**
+ * Per-tag LLM totals and per-class instance counts/bytes for our gameplay classes, written as CSV.
+ * Console: MPShooter.MemReport [path], MPShooter.MemReportInterval <seconds> to append a row set periodically.
+ * Commandlet: -run=MPShooterMemReport [-Map=<package>] [-Out=<path>]
+ * Rows are appended, so one file tracks growth over a long dedicated server session.
+ *
+ * Gather walks every UObject and serializes each tracked one on the game thread, a hitch of its own: the interval is for soak runs,
+ * not servers people are playing on. Tag totals only cover what's allocated inside our LLM scopes (constructors, spawns we make,
+ * the game mode's pawn spawns, weapons loaded with a level); the render and physics state the engine creates when it registers
+ * a level's components stays in the engine's tags. The class rows count every instance however it was made.
+ */
+struct MPSHOOTER_API FMPShooterMemoryReport
+{
+	struct FRow
+	{
+		FString Kind; // "Tag" or "Class"
+		FString Name;
+		FString Tag;
+		int32 Count = 0; // instances, 0 for tags
+		int64 Bytes = 0;
+	};
+
+	static void Gather(TArray<FRow>& OutRows);
+	static bool AppendCsv(const FString& Path, const TArray<FRow>& Rows);
+	static FString GetDefaultCsvPath();
+};
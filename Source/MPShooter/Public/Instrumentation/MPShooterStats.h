@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("MPShooter"), STATGROUP_MPShooter, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_MPShooter_CharacterTick, STATGROUP_MPShooter, MPSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update"), STAT_MPShooter_AnimUpdate, STATGROUP_MPShooter, MPSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Sim"), STAT_MPShooter_ProjectileSim, STATGROUP_MPShooter, MPSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Fire Effects"), STAT_MPShooter_Effects, STATGROUP_MPShooter, MPSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HUD"), STAT_MPShooter_HUD, STATGROUP_MPShooter, MPSHOOTER_API);
+
+// Hot paths we keep our own running totals for, so benchmarks can read them without the stats system (Test/Shipping builds).
+enum class EMPShooterPerfScope : uint8
+{
+	CharacterTick,
+	AnimUpdate,
+	ProjectileSim,
+	Effects,
+	HUD,
+
+	Count
+};
+
+struct MPSHOOTER_API FMPShooterPerfCounters
+{
+	// Only touched from the game thread.
+	static bool bEnabled;
+	static uint64 Cycles[(int32)EMPShooterPerfScope::Count];
+	static uint32 Calls[(int32)EMPShooterPerfScope::Count];
+
+	static void Reset();
+	static const TCHAR* GetName(EMPShooterPerfScope Scope);
+};
+
+class FMPShooterPerfScope
+{
+public:
+	explicit FMPShooterPerfScope(EMPShooterPerfScope InScope)
+		: Scope(InScope)
+		, StartCycles(FMPShooterPerfCounters::bEnabled ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FMPShooterPerfScope()
+	{
+		if (StartCycles != 0)
+		{
+			FMPShooterPerfCounters::Cycles[(int32)Scope] += FPlatformTime::Cycles64() - StartCycles;
+			FMPShooterPerfCounters::Calls[(int32)Scope]++;
+		}
+	}
+
+private:
+	EMPShooterPerfScope Scope;
+	uint64 StartCycles;
+};
+
+// Feeds both "stat MPShooter" and the benchmark counters.
+#define MPSHOOTER_PERF_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_MPShooter_##Name); \
+	FMPShooterPerfScope PerfScope_##Name(EMPShooterPerfScope::Name)
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Pipe.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MatchJournal.generated.h"
+
+enum class EMatchJournalEvent : uint8
+{
+	Fire,			// server received a shot. Value: shooter ping (ms)
+	FireRejected,	// shot failed validation
+	Hit,			// projectile impact. Value: damage, Aux: flight time (ms), Target: victim (0 = world)
+	Kill,			// Target: victim
+	Equip,
+	AimStart,
+	AimStop,
+	Travel,			// match start (Aux 1) / end (Aux 0)
+
+	Count
+};
+
+// One fixed size record. Written as-is, so keep the layout stable and bump FMatchJournalHeader::Version when it changes.
+struct FMatchJournalRecord
+{
+	float Time;			// world seconds
+	uint32 PlayerId;	// APlayerState::GetPlayerId, 0 if none
+	uint32 Target;
+	float Value;
+	FVector3f Location;
+	uint16 Aux;
+	uint8 Type;			// EMatchJournalEvent
+	uint8 Pad;
+};
+static_assert(sizeof(FMatchJournalRecord) == 32, "Match journal records are fixed size on disk");
+
+struct FMatchJournalHeader
+{
+	static constexpr uint32 MagicValue = 0x4A50504D; // "MPPJ"
+	static constexpr uint32 CurrentVersion = 1;
+
+	uint32 Magic = MagicValue;
+	uint32 Version = CurrentVersion;
+	uint32 RecordSize = sizeof(FMatchJournalRecord);
+	uint32 Pad = 0;
+	int64 StartUtcTicks = 0;
+	TCHAR MapName[52] = {};
+};
+static_assert(sizeof(FMatchJournalHeader) == 128, "Records stay aligned after the header");
+
+/**
+ * Binary journal of combat events, recorded from the game thread only. Record() appends to a chunk without locks; full chunks
+ * (and the partial one, a few times a second and at Stop) are handed to a task pipe that appends them to the file in order.
+ * Read it back with -run=MatchJournal -File=<path>.
+ */
+class MPSHOOTER_API FMatchJournal
+{
+public:
+
+	static constexpr int32 RecordsPerChunk = 2048; // 64 KB
+
+	static bool Start(const FString& Path, const FString& MapName);
+	static void Stop();
+	static FORCEINLINE bool IsRecording() { return bRecording; }
+
+	static void Record(EMatchJournalEvent Type, float Time, uint32 PlayerId, const FVector& Location, float Value = 0.f, uint32 Target = 0, uint16 Aux = 0);
+	static void Flush(); // hands the partial chunk to the writer
+
+	static uint32 GetPlayerId(const AActor* PawnOrController); // 0 for anything without a player state
+
+	static FString GetDefaultDirectory();
+
+private:
+
+	struct FChunk
+	{
+		int32 Num = 0;
+		FMatchJournalRecord Records[RecordsPerChunk];
+	};
+
+	static void Submit(FChunk* Chunk);
+
+	static bool bRecording;
+	static FChunk* CurrentChunk; // game thread, owned until submitted
+	static IFileHandle* FileHandle;
+	static UE::Tasks::FPipe* WritePipe;
+};
+
+/**
+ * Server: starts a journal for every match world when MPShooter.MatchJournal is set, and closes it when the world goes away.
+ */
+UCLASS()
+class MPSHOOTER_API UMatchJournalSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+private:
+
+	bool TickFlush(float DeltaTime);
+
+	FTSTicker::FDelegateHandle FlushTickHandle;
+	bool bOwnsJournal = false;
+};
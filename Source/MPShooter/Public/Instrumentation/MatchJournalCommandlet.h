@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MatchJournalCommandlet.generated.h"
+
+/**
+ * Streams a match journal (memory mapped, no map or game classes loaded) and prints aggregate stats.
+ * UnrealEditor-Cmd MPShooter.uproject -run=MatchJournal [-File=<path.mpj>] [-CSV=<per player csv>]
+ * Without -File the newest journal in Saved/MatchJournals is used.
+ */
+UCLASS()
+class MPSHOOTER_API UMatchJournalCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UMatchJournalCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "ReplaySubsystem.generated.h"
+
+/**
+ * Records matches through the DemoNetDriver and plays them back as a client benchmark.
+ * Recording: MPShooter.RecordMatchReplays 1 on the server.
+ * Benchmark: -ReplayBenchmark=<ReplayName> [-BenchmarkFPS=60] [-BenchmarkCSV=<path>] -nullrhi
+ */
+UCLASS()
+class MPSHOOTER_API UReplaySubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void StartBenchmark(const FString& InReplayName, float FixedFPS, const FString& InCsvPath);
+	FORCEINLINE bool IsBenchmarkRunning() const { return bBenchmarkRunning; }
+
+private:
+
+	void OnWorldInitializedActors(const FActorsInitializedParams& Params);
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+	void StartMatchRecording(UWorld* World);
+	void RestoreCheckpointDelay(); // puts demo.CheckpointUploadDelayInSeconds back once the match recording is over
+
+	bool TickBenchmark(float DeltaTime);
+	void SampleFrame();
+	void FinishBenchmark(bool bCompleted);
+	void WriteBenchmarkCsv(bool bCompleted) const;
+
+	FDelegateHandle WorldInitHandle;
+	FDelegateHandle WorldCleanupHandle;
+	TWeakObjectPtr<UWorld> RecordingWorld;
+	TOptional<float> SavedCheckpointDelay; // the value before we set our interval
+	FTSTicker::FDelegateHandle BenchmarkTickHandle;
+
+	FString BenchmarkReplayName;
+	FString BenchmarkCsvPath;
+	float BenchmarkFPS = 60.f;
+	bool bBenchmarkRunning = false;
+	bool bPlaybackStarted = false;
+	double BenchmarkStartTime = 0.0;
+
+	// Totals over every sampled frame of the playback.
+	int32 FramesSampled = 0;
+	double GameThreadMsSum = 0.0;
+	double GameThreadMsMax = 0.0;
+	double ScopeMsSum[(int32)EMPShooterPerfScope::Count] = {};
+	double ScopeMsMax[(int32)EMPShooterPerfScope::Count] = {};
+	uint64 ScopeCallsSum[(int32)EMPShooterPerfScope::Count] = {};
+};
@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "MPShooterGameModeBase.generated.h"
 
+class ASpartanCharacter;
+
 /**
  * 
  */
@@ -13,5 +15,19 @@ UCLASS()
 class MPSHOOTER_API AMPShooterGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
+
+public:
+
+	AMPShooterGameModeBase();
+
+	virtual void PlayerEliminated(ASpartanCharacter* EliminatedCharacter, AController* VictimController, AController* AttackerController);
+	void RespawnPlayer(AController* Controller, ASpartanCharacter* EliminatedCharacter);
+
+protected:
+
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override; // RestartPlayer's spawns, under the Characters LLM tag
+
+	UPROPERTY(EditDefaultsOnly, Category = Respawn)
+	float RespawnDelay;
 	
 };
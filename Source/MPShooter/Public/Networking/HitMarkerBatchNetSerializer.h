@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Iris/Serialization/NetSerializerConfig.h"
+#include "HitMarkerBatchNetSerializer.generated.h"
+
+// Iris counterpart of FHitMarkerBatch::NetSerialize: the same 23 bits on the wire
+USTRUCT()
+struct FHitMarkerBatchNetSerializerConfig : public FNetSerializerConfig
+{
+	GENERATED_BODY()
+};
+
+#if UE_WITH_IRIS
+#include "Iris/Serialization/NetSerializer.h"
+
+namespace UE::Net
+{
+	UE_NET_DECLARE_SERIALIZER(FHitMarkerBatchNetSerializer, MPSHOOTER_API);
+}
+#endif
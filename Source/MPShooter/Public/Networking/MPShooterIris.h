@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Iris filtering / prioritization for our replicated actors. Everything here is a no-op on the generic replication path,
+ * so callers don't need to know which one the net driver is running (net.Iris.UseIrisReplication).
+ */
+namespace MPShooterIris
+{
+	enum class EReplicatedClass : uint8
+	{
+		Character,
+		Weapon,
+		Projectile
+	};
+
+	MPSHOOTER_API bool IsUsingIris(const UObject* WorldContextObject); // the world's game net driver
+
+	// Server, from BeginPlay: spatial filter (the actor's NetCullDistance) and the class's prioritizer
+	MPSHOOTER_API void ConfigureActor(AActor* Actor, EReplicatedClass Class);
+
+	// Server: an equipped weapon replicates together with its owner instead of being scheduled on its own
+	MPSHOOTER_API void SetReplicatesWith(AActor* Parent, AActor* Child, bool bDependent);
+}
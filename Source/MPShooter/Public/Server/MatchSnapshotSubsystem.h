@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Tasks/Task.h"
+#include "MPShooter/SpartanTypes/InventorySlot.h"
+#include "MatchSnapshotSubsystem.generated.h"
+
+class AWeapon;
+
+// One player's place in the match. Keyed by unique net id (player name for bots), since a restarted server hands out new player states.
+struct FMatchSnapshotPlayer
+{
+	FString Key;
+	FVector3f Location = FVector3f::ZeroVector;
+	FRotator3f ControlRotation = FRotator3f::ZeroRotator;
+	float Health = 0.f;
+	float Armor = 0.f;
+	int32 Kills = 0;
+	int32 Deaths = 0;
+	int16 Weapons[(int32)EInventorySlot::EIS_MAX] = { INDEX_NONE, INDEX_NONE }; // into FMatchSnapshot::Weapons
+	uint8 ActiveSlot = 0;
+	uint8 bAlive = 0; // dead players come back through the usual respawn, only their score is restored
+};
+
+struct FMatchSnapshotWeapon
+{
+	uint16 ClassIndex = 0; // into FMatchSnapshot::Classes
+	FName PlacedName; // level placed weapons are found by name, spawned ones are spawned again (NAME_None)
+	uint8 State = 0; // EWeaponState
+	FVector3f Location = FVector3f::ZeroVector;
+	FRotator3f Rotation = FRotator3f::ZeroRotator;
+	FVector3f LinearVelocity = FVector3f::ZeroVector; // dropped weapons still tumbling
+};
+
+struct FMatchSnapshotProjectile
+{
+	uint16 ClassIndex = 0;
+	FVector3f Location = FVector3f::ZeroVector;
+	FVector3f Velocity = FVector3f::ZeroVector;
+};
+
+// Everything a restarted server needs to carry on with the match. Serialized with operator<<, bump CurrentVersion when the layout changes.
+struct FMatchSnapshot
+{
+	static constexpr uint32 MagicValue = 0x53534D50; // "PMSS"
+	static constexpr uint32 CurrentVersion = 1;
+
+	FString MapName; // long package name, the server travels there first if it booted somewhere else
+	float WorldTime = 0.f;
+	int64 UtcTicks = 0;
+	TArray<FString> Classes; // weapon and projectile class paths, records refer to them by index
+	TArray<FMatchSnapshotPlayer> Players;
+	TArray<FMatchSnapshotWeapon> Weapons;
+	TArray<FMatchSnapshotProjectile> Projectiles;
+
+	bool Serialize(FArchive& Ar); // false if it isn't a snapshot of this version
+	uint16 AddClass(const UClass* Class);
+};
+
+/**
+ * Dedicated server only. Every MPShooter.Snapshot.Interval seconds the match (characters, their inventories, every weapon with
+ * its EWeaponState, projectiles in flight, scores) is captured on the game thread into a compact binary snapshot, which a task
+ * writes to Saved/MatchSnapshots. A server started with -RestoreSnapshot goes straight to the snapshot's map and puts the match
+ * back: weapons and projectiles right away, each player's character, inventory and score when they reconnect (or their bot is
+ * added again) within MPShooter.Snapshot.PendingPlayerTimeout. Capture, write and restore times go to "stat MPShooter" and Profiling/MPShooter/Snapshot.csv.
+ */
+UCLASS()
+class MPSHOOTER_API UMatchSnapshotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	friend class FMatchSnapshotRoundTripTest; // Capture and Restore without a dedicated server
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void SaveSnapshot(bool bWait); // captures now; bWait blocks until the file is written (before stopping a server for a patch)
+	FString GetSnapshotPath() const;
+
+private:
+
+	void Capture(FMatchSnapshot& Snapshot) const;
+	void Restore(const FMatchSnapshot& Snapshot);
+	void RestorePendingPlayers();
+	void ExpirePendingPlayers(double Now);
+	void OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString);
+	void AbandonRestoreTravel(const TCHAR* Reason);
+
+	static FString GetPlayerKey(const class APlayerState* PlayerState);
+
+	// A restored player who hasn't come back yet; also carried into every new snapshot until they do
+	struct FPendingPlayer
+	{
+		FMatchSnapshotPlayer Record;
+		TWeakObjectPtr<AWeapon> Weapons[(int32)EInventorySlot::EIS_MAX];
+		double ExpireTime = 0.0; // MPShooter.Snapshot.PendingPlayerTimeout after the restore, then they're dropped
+	};
+	TMap<FString, FPendingPlayer> PendingPlayers;
+	double NextPendingCheckTime = 0.0;
+
+	// Set while this world travels to the snapshot's map; a travel that fails or never happens puts RestoreState back to Done
+	double RestoreTravelDeadline = 0.0;
+	FDelegateHandle TravelFailureHandle;
+
+	bool bActive = false; // dedicated server, gameplay map
+	double NextSnapshotTime = 0.0;
+	UE::Tasks::FTask WriteTask; // one write in flight at a time, a snapshot that comes due during a slow write is skipped
+	int32 SkippedSnapshots = 0;
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ServerTickGovernorSubsystem.generated.h"
+
+// What the governor runs the server at. Level 0 is full fidelity, the last level is every setting at its configured bound.
+struct FServerFidelity
+{
+	float TickRate = 0.f; // NetServerMaxTickRate
+	float NetRateScale = 1.f; // characters' and projectiles' NetUpdateFrequency
+	float AnimTickInterval = 0.f; // dedicated server character meshes, 0 = every frame
+	float ProjectileMaxTimeStep = 0.f; // projectile substep length, 0 = the component's own
+};
+
+/**
+ * Dedicated server only. Measures game, physics and replication time every frame and trades fidelity for a stable frame rate:
+ * when the frame stays over budget it steps down a level (lower tick rate, net rates, anim rate, fewer projectile substeps),
+ * and only steps back up once the next level up is predicted to fit comfortably, for a while. Bounds, thresholds and the
+ * hold times are MPShooter.Governor.* cvars. Decisions go to "stat MPShooter" and Profiling/MPShooter/Governor.csv.
+ */
+UCLASS()
+class MPSHOOTER_API UServerTickGovernorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	FORCEINLINE int32 GetLevel() const { return Level; }
+	FORCEINLINE const FServerFidelity& GetFidelity() const { return Fidelity; }
+
+	// For actors spawned while the governor has the server turned down; full fidelity without a governor
+	static FServerFidelity GetCurrentFidelity(const UWorld* World);
+
+	static constexpr int32 NumLevels = 5;
+
+private:
+
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush();
+	void OnPhysicsStart();
+	void OnPhysicsEnd();
+
+	FServerFidelity GetFidelityForLevel(int32 ForLevel) const;
+	void SetLevel(int32 NewLevel, const TCHAR* Reason);
+	void ApplyFidelity();
+	void WriteCsv(int32 OldLevel, const TCHAR* Reason) const;
+
+	// Tick functions around the physics tick groups, only there to timestamp them
+	struct FPhysicsMarkerTickFunction : public FTickFunction
+	{
+		UServerTickGovernorSubsystem* Governor = nullptr;
+		bool bStart = false;
+		virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+		virtual FString DiagnosticMessage() override { return TEXT("ServerTickGovernor physics marker"); }
+	};
+	FPhysicsMarkerTickFunction PhysicsStartMarker;
+	FPhysicsMarkerTickFunction PhysicsEndMarker;
+
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+
+	// This frame, in seconds (FPlatformTime)
+	double FrameStartTime = 0.0;
+	double PhysicsStartTime = 0.0;
+	double PhysicsMs = 0.0;
+	double PostActorTickTime = 0.0;
+
+	// Smoothed over a few frames, milliseconds
+	float GameMs = 0.f;
+	float PhysicsMsAvg = 0.f;
+	float NetMs = 0.f;
+
+	float OverBudgetTime = 0.f; // how long the frame has been over the high water mark
+	float UnderBudgetTime = 0.f; // how long the next level up would have fit under the low water mark
+	int32 Level = 0;
+	FServerFidelity Fidelity;
+	int32 FullTickRate = 0; // NetServerMaxTickRate as configured, level 0
+};
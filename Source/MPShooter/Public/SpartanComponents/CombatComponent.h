@@ -4,12 +4,42 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Instrumentation/LatencyHistogram.h"
+#include "MPShooter/SpartanTypes/InventorySlot.h"
+#include "Engine/StreamableManager.h"
 #include "CombatComponent.generated.h"
 
-#define TRACE_LENGTH 80000;
+#define TRACE_LENGTH 80000
 
 class AWeapon;
 
+// Everything our shots hit this frame, sent to the shooter as one unreliable update. Bit-packed on the wire.
+USTRUCT()
+struct FHitMarkerBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 NumHits = 0;
+	UPROPERTY()
+	uint8 NumKills = 0;
+	UPROPERTY()
+	uint16 TotalDamage = 0; // whole points
+
+	void Add(float Damage, bool bKilled);
+	FORCEINLINE bool IsEmpty() const { return NumHits == 0; }
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitMarkerBatch> : public TStructOpsTypeTraitsBase2<FHitMarkerBatch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class MPSHOOTER_API UCombatComponent : public UActorComponent
 {
@@ -19,37 +49,119 @@ public:
 	
 	UCombatComponent();
 	friend class ASpartanCharacter;
+	friend class UShotValidationSubsystem;
+	friend class ULatencyHarnessSubsystem; // scripted clients fire through FireButtonPressed
+	friend class UMatchSnapshotSubsystem; // puts the weapons back in their slots after a restore
 
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	
-	void EquipWeapon(AWeapon* WeaponToEquip);
+	void EquipWeapon(AWeapon* WeaponToEquip); // Server: into the held slot if it's empty, else holstered in the free slot, else replaces the held weapon
+	void DropEquippedWeapon(); // Server, the holstered weapon (if any) comes out
+	void DropAllWeapons(); // Server
+	void SwapWeapons(); // Predicted on the owning client, only the slot index goes to the server
+	FORCEINLINE AWeapon* GetWeaponInSlot(EInventorySlot Slot) const { return WeaponSlots[(int32)Slot]; }
+	FORCEINLINE EInventorySlot GetActiveSlot() const { return ActiveSlot; }
+	void ResetCombatState(); // Respawn: not aiming, not firing, nothing pending
+
+	// Only the locally controlled player's component has one (from its first shot on), nullptr everywhere else
+	struct FFireLatency
+	{
+		FLatencyHistogram InputToMuzzle; // input -> muzzle flash on our own screen
+		FLatencyHistogram InputToConfirm; // input -> server result
+	};
+	FORCEINLINE const FFireLatency* GetFireLatency() const { return FireLatency.Get(); }
+	FORCEINLINE uint32 GetRejectedShots() const { return RejectedShots; }
+
+	void AddHitMarker(float Damage, bool bKilled); // Server: batched and flushed to the owning client once per frame
+	FORCEINLINE const FHitMarkerBatch& GetLastHitMarkers() const { return LastHitMarkers; }
+	FORCEINLINE float GetLastHitMarkerTime() const { return LastHitMarkerTime; }
+	void ResetFireLatency();
 
 protected:
 	
 	virtual void BeginPlay() override;
 
-	void SetAiming(bool bIsAiming);
-	UFUNCTION(Server, Reliable) //reliable resends packet if confirmation not received.  Large overhead.
-	void ServerSetAiming(bool bIsAiming);
+	void SetAiming(bool bIsAiming); // Predicted through USpartanMovementComponent's saved moves, no RPC needed
+
 	UFUNCTION()
-	void OnRep_EquippedWeapon();
+	void OnRep_WeaponSlots();
+	UFUNCTION()
+	void OnRep_ActiveSlot();
+	void SetActiveSlot(EInventorySlot Slot);
+	void ApplyActiveSlot(); // EquippedWeapon = the active slot's weapon; the other one goes to the holster. Local only, nothing replicates.
+	void AttachWeaponToSocket(AWeapon* Weapon, FName SocketName);
+	void RefreshWeaponPreloads();
+
+	UFUNCTION(Server, Reliable)
+	void ServerSetActiveSlot(EInventorySlot Slot);
+	UFUNCTION(Client, Reliable)
+	void ClientCorrectActiveSlot(EInventorySlot Slot); // the server had nothing in the slot we predicted, or changed it itself (drop, restore)
+	UFUNCTION(Client, Reliable)
+	void ClientStopAiming(); // the server took our weapon away; aiming is the owner's predicted move flag, so only the owner can clear it
 
 	void FireButtonPressed(bool bPressed);
 
+	// PredictionKey is 0 for shots that were not predicted (listen server host, prediction disabled)
 	UFUNCTION(Server, Reliable)
-	void ServerFire(const FVector_NetQuantize& TraceHitTarget);
+	void ServerFire(const FVector_NetQuantize& TraceHitTarget, uint16 PredictionKey);
 
-	UFUNCTION(NetMulticast, Reliable)
-	void MulticastFire(const FVector_NetQuantize& TraceHitTarget);
+	bool IsFireInRange(const FVector& TraceHitTarget) const; // a weapon equipped and the target within trace range of the character
+	bool ValidateFire(const FVector& TraceHitTarget) const; // IsFireInRange and nothing solid between the muzzle and the target
+	void ApplyValidatedShot(const FVector_NetQuantize& TraceHitTarget, uint16 PredictionKey, bool bAccepted); // Called by UShotValidationSubsystem once the frame's batch is traced
 
-	void TraceUnderCrosshairs(FHitResult& TraceHitResult);
+	// Tells the shooter whether its predicted shot stood. A rejected shot has its cosmetics rolled back.
+	UFUNCTION(Client, Unreliable)
+	void ClientFireResult(uint16 PredictionKey, bool bAccepted, const FVector_NetQuantize& TraceHitTarget);
+
+	void RollbackPredictedFire();
+
+	UFUNCTION(Client, Unreliable)
+	void ClientHitMarkers(const FHitMarkerBatch& HitMarkers);
+
+	// Montage + weapon fire. On the server this also spawns the projectile; elsewhere it is cosmetic only.
+	void PlayFire(const FVector& TraceHitTarget);
+
+	// Server: sends the shot's cosmetics to each connection that can see or hear it, instead of multicasting to everyone.
+	void SendFireCosmetics(const FVector& TraceHitTarget);
+
+	enum class EFireCosmeticRelevance : uint8
+	{
+		None,
+		Nearby, // coarse "gunfire nearby" only
+		Full
+	};
+	EFireCosmeticRelevance GetFireCosmeticRelevance(const FVector& ViewLocation, const FVector& ViewDirection, const FVector& ShotOrigin, const FVector& ShotTarget) const;
+
+	UFUNCTION(Client, Unreliable)
+	void ClientFireCosmetic(class ASpartanCharacter* Shooter, const FVector_NetQuantize& TraceHitTarget);
+
+	UFUNCTION(Client, Unreliable)
+	void ClientGunfireNearby(const FVector_NetQuantize& ShotOrigin);
+
+	void TraceUnderCrosshairs(FHitResult& TraceHitResult); // players: the screen center; bots: along the control rotation
 
 private:
 
 	class ASpartanCharacter* Character;
-	UPROPERTY(ReplicatedUsing = OnRep_EquippedWeapon)
-	AWeapon* EquippedWeapon;
+	UPROPERTY()
+	AWeapon* EquippedWeapon; // WeaponSlots[ActiveSlot], derived on every machine
+
+	// Slots only replicate on pickup/drop; a swap sends ActiveSlot and nothing else (the weapons stay net-dormant). ActiveSlot skips the
+	// owner, whose swaps are predicted: an old value arriving after a quick double swap would put the wrong weapon back in its hands.
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponSlots)
+	TArray<AWeapon*> WeaponSlots;
+	UPROPERTY(ReplicatedUsing = OnRep_ActiveSlot)
+	EInventorySlot ActiveSlot;
+
+	UPROPERTY(EditAnywhere, Category = Inventory)
+	FName HandSocketName;
+	UPROPERTY(EditAnywhere, Category = Inventory)
+	FName HolsterSocketName;
+
+	// Keeps every inventory weapon's mesh, animations and projectile class loaded while it's holstered
+	TSharedPtr<FStreamableHandle> PreloadHandles[(int32)EInventorySlot::EIS_MAX];
+	TWeakObjectPtr<AWeapon> PreloadedWeapons[(int32)EInventorySlot::EIS_MAX];
 
 	UPROPERTY(Replicated)
 	bool bAiming;
@@ -59,4 +171,35 @@ private:
 	float AimWalkSpeed;
 
 	bool bFireButtonPressed;
+
+	// Owning client: shots sent to the server that haven't been acknowledged yet
+	struct FPendingFireShot
+	{
+		uint16 PredictionKey;
+		double InputTime; // FPlatformTime::Seconds() when the fire input was handled
+		bool bPredicted;
+	};
+	TArray<FPendingFireShot> PendingShots;
+	uint16 LastFirePredictionKey;
+	double HostFireInputTime; // listen server host's own shot, waiting for the validation batch
+
+	TUniquePtr<FFireLatency> FireLatency; // two 1001 bucket histograms, not worth carrying on every simulated proxy and bot
+	FFireLatency* GetOrCreateFireLatency(); // nullptr unless a local player controls us
+	uint32 RejectedShots;
+
+	FHitMarkerBatch PendingHitMarkers; // server
+	FHitMarkerBatch LastHitMarkers; // owning client, read by the HUD
+	float LastHitMarkerTime;
+
+	// Fire cosmetic interest filter (server side, distances in cm)
+	UPROPERTY(EditAnywhere, Category = "Fire Cosmetics")
+	float FireCosmeticAlwaysRadius; // Inside this everyone gets full cosmetics, whichever way they face
+	UPROPERTY(EditAnywhere, Category = "Fire Cosmetics")
+	float FireCosmeticViewRadius; // Full cosmetics if the shot is inside the observer's view cone
+	UPROPERTY(EditAnywhere, Category = "Fire Cosmetics")
+	float FireCosmeticViewConeDegrees; // Full cone angle
+	UPROPERTY(EditAnywhere, Category = "Fire Cosmetics")
+	float GunfireAudibleRadius; // Beyond the full radii but inside this, observers only get ClientGunfireNearby
+	UPROPERTY(EditAnywhere, Category = "Fire Cosmetics")
+	class USoundBase* DistantGunfireSound;
 };
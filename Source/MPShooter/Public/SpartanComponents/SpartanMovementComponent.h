@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "SpartanMovementComponent.generated.h"
+
+/**
+ * Character movement that carries the aiming flag inside the saved moves, so the aim walk speed is predicted
+ * by the client and replayed by the server on the same move instead of waiting on an RPC.
+ */
+UCLASS()
+class MPSHOOTER_API USpartanMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	USpartanMovementComponent();
+
+	virtual float GetMaxSpeed() const override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+	void SetWantsToAim(bool bNewWantsToAim);
+	FORCEINLINE bool WantsToAim() const { return bWantsToAim; }
+
+	UPROPERTY(EditAnywhere, Category = "Character Movement: Walking")
+	float AimWalkSpeed; // Replaces MaxWalkSpeed while aiming (set from UCombatComponent)
+
+	static uint32 GetServerCorrectionCount(); // Since process start or the last reset, used to compare prediction under latency
+	static void ResetServerCorrectionCount();
+
+private:
+
+	friend class FSavedMove_Spartan;
+
+	uint8 bWantsToAim : 1;
+};
+
+class FSavedMove_Spartan : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	uint8 bSavedWantsToAim : 1;
+};
+
+class FNetworkPredictionData_Client_Spartan : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Spartan(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -16,11 +16,18 @@ public:
 	AProjectile();
 
 	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 protected:
 
 	virtual void BeginPlay() override;
 
+	UFUNCTION()
+	virtual void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+
+	UPROPERTY(EditAnywhere, Category = Combat)
+	float Damage;
+
 private:
 
 	UPROPERTY(EditAnywhere)
@@ -33,8 +40,16 @@ private:
 	class UParticleSystem* Tracer;
 	class UParticleSystemComponent* TracerComponent;
 
-public:	
+	UPROPERTY(Replicated)
+	uint16 ShotKey; // prediction key of the shot that fired us, 0 if it wasn't predicted
 
+public:	
 
+	FORCEINLINE void SetShotKey(uint16 Key) { ShotKey = Key; }
+	FORCEINLINE uint16 GetShotKey() const { return ShotKey; }
+	void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const; // Tracer effect, preloaded by weapons that fire us
+	void ApplyServerFidelity(const struct FServerFidelity& Fidelity); // Server: net rate and substep length, set by UServerTickGovernorSubsystem
+	FORCEINLINE class UBoxComponent* GetCollisionBox() const { return CollisionBox; }
+	FORCEINLINE class UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovementComponent; }
 
 };
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CollisionQueryParams.h"
+#include "CollisionShape.h"
+#include "Tasks/Task.h"
+#include "ProjectileSimulationSubsystem.generated.h"
+
+class AProjectile;
+
+// One projectile's flight, stepped at the fixed rate from its spawn time. Plain data so the steps can run off the game thread.
+struct FProjectileSimBody
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float GravityZ = 0.f;
+	int32 StepsDone = 0;
+	bool bHit = false;
+	FHitResult Hit;
+
+	// Collision, copied from the projectile's box
+	FCollisionShape Shape;
+	ECollisionChannel Channel = ECC_WorldDynamic;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+};
+
+/**
+ * Fixed-step projectile flight (MPShooter.Projectile.FixedStepHz, 0 = the old per-frame UProjectileMovementComponent).
+ * Every projectile is integrated and swept in fixed steps counted from its spawn time, so the positions it sweeps through,
+ * and so what it hits, don't depend on the frame rate; a slow frame just runs more steps.
+ *
+ * Double buffered: each frame the steps up to that frame's time are launched as a task (parallel over the projectiles, no
+ * UObject access, only scene queries, which run alongside the game thread the way the world's async traces do), and the
+ * game thread goes on. The next frame applies them, moves and hits in spawn order, and launches the next batch. Projectiles are
+ * drawn one frame behind their simulation and hits are dispatched one frame after the step they belong to; where they hit is
+ * unchanged. The game thread only waits if the last frame's batch hasn't finished yet ("Projectile Sim Steps" in stat MPShooter).
+ * Character movement is not part of this: it still runs on the game thread in the character tick.
+ */
+UCLASS()
+class MPSHOOTER_API UProjectileSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static bool IsFixedStep();
+	static float GetStepSeconds();
+
+	void Register(AProjectile* Projectile); // BeginPlay, with the movement component's initial velocity
+	static void InitBody(FProjectileSimBody& Body, const AProjectile* Projectile);
+
+	// Runs steps until TargetSteps are done or something is hit. Thread safe with respect to the game thread's reads of the world.
+	static void Advance(const UWorld* World, FProjectileSimBody& Body, int32 TargetSteps, float StepSeconds);
+
+	static constexpr int32 MaxStepsPerFrame = 32; // after a hitch the rest catch up over the next frames
+
+private:
+
+	void WaitForSteps();
+	void ApplySteps();
+
+	struct FSimulatedProjectile
+	{
+		TWeakObjectPtr<AProjectile> Projectile;
+		FProjectileSimBody Body;
+		double SpawnTime = 0.0;
+		float StepSeconds = 0.f; // the rate at spawn, changing the cvar doesn't bend flights already under way
+		bool bHitDispatched = false;
+	};
+
+	TArray<FSimulatedProjectile> Projectiles;
+
+	struct FStep
+	{
+		FProjectileSimBody Body;
+		int32 TargetSteps = 0;
+		float StepSeconds = 0.f;
+	};
+
+	// The batch in flight: the bodies of Projectiles[0 .. Num), moved out for the task and moved back by ApplySteps.
+	// Projectiles registered meanwhile are appended after them and join the next batch.
+	TArray<FStep> InFlight;
+	UE::Tasks::FTask StepsTask;
+};
@@ -16,6 +16,7 @@ class MPSHOOTER_API AProjectileWeapon : public AWeapon
 	
 public:
 	virtual void Fire(const FVector& HitTarget) override;
+	virtual void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
 
 private:
 	UPROPERTY(EditAnywhere)
@@ -0,0 +1,11 @@
+#pragma once
+
+UENUM(BlueprintType)
+enum class EInventorySlot : uint8
+{
+	EIS_Primary UMETA(DisplayName = "Primary"),
+	EIS_Secondary UMETA(DisplayName = "Secondary"),
+
+	EIS_MAX UMETA(DisplayName = "DefaultMax") // number of slots
+
+};
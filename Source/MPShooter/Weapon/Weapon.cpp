@@ -3,19 +3,167 @@
 
 #include "Weapon.h"
 #include "Components/SphereComponent.h"
-#include "Components/WidgetComponent.h"
 #include "Character/SpartanCharacter.h"
 #include "Net/UnrealNetwork.h"
 #include "Animation/AnimationAsset.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Instrumentation/MPShooterCsv.h"
+#include "Instrumentation/MPShooterStats.h"
+#include "Instrumentation/MPShooterMemory.h"
+#include "Networking/MPShooterIris.h"
+#include "RenderCore.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dropped Weapons Awake"), STAT_MPShooter_AwakeWeapons, STATGROUP_MPShooter);
+
+// Dropped weapons settling: how many replicate at once and how long until the last one has gone dormant again, with the game
+// thread time and the bandwidth while they fall. Compare runs with different weapon counts or dropped update rates.
+namespace DropStress
+{
+	struct FSession
+	{
+		TWeakObjectPtr<UWorld> World;
+		TArray<TWeakObjectPtr<AWeapon>> Weapons;
+		FString Label;
+		float MaxSeconds = 0.f;
+		float Elapsed = 0.f;
+		float SecondElapsed = 0.f;
+		int32 Frames = 0;
+		int32 PeakAwake = 0;
+		int32 PeakSimulating = 0;
+		float HalfAsleepSeconds = -1.f;
+		double GameThreadMsSum = 0.0;
+		double GameThreadMsMax = 0.0;
+		uint64 OutBytes = 0;
+		int32 Seconds = 0;
+	};
+
+	static FSession Session;
+	static FTSTicker::FDelegateHandle TickHandle;
+
+	static void Finish(int32 StillAwake)
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+
+		const int32 Frames = FMath::Max(Session.Frames, 1);
+		const double GameThreadMs = Session.GameThreadMsSum / Frames;
+		const double OutKBps = Session.OutBytes / 1024.0 / FMath::Max(Session.Seconds, 1);
+		const float AllAsleepSeconds = StillAwake == 0 ? Session.Elapsed : -1.f; // -1: some were still replicating at the time limit
+
+		UE_LOG(LogTemp, Display, TEXT("DropStress [%s] %d weapons: %d replicating at most (%d simulating), half dormant after %.2f s, all after %.2f s (%d still awake), game thread %.3f ms avg, %.3f ms max, out %.2f KB/s"),
+			*Session.Label, Session.Weapons.Num(), Session.PeakAwake, Session.PeakSimulating, Session.HalfAsleepSeconds, AllAsleepSeconds, StillAwake, GameThreadMs, Session.GameThreadMsMax, OutKBps);
+
+		FMPShooterCsv::Append(FMPShooterCsv::GetPath(TEXT("DropStress.csv")), TEXT("Time,Label,Weapons,Frames,PeakAwake,PeakSimulating,HalfDormantSeconds,AllDormantSeconds,StillAwake,GameThreadMs,GameThreadMaxMs,OutKBps"),
+			FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%.3f,%.3f,%d,%.4f,%.4f,%.3f") LINE_TERMINATOR, *FMPShooterCsv::Now(), *Session.Label, Session.Weapons.Num(),
+			Session.Frames, Session.PeakAwake, Session.PeakSimulating, Session.HalfAsleepSeconds, AllAsleepSeconds, StillAwake, GameThreadMs, Session.GameThreadMsMax, OutKBps));
+		Session = FSession();
+	}
+
+	static bool Tick(float DeltaTime)
+	{
+		UWorld* World = Session.World.Get();
+		if (World == nullptr)
+		{
+			TickHandle.Reset();
+			Session = FSession();
+			return false;
+		}
+
+		// The core ticker runs at the start of the frame, GGameThreadTime is the one the weapons just fell in
+		const double FrameMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+		Session.GameThreadMsSum += FrameMs;
+		Session.GameThreadMsMax = FMath::Max(Session.GameThreadMsMax, FrameMs);
+		Session.Frames++;
+		Session.Elapsed += DeltaTime;
+		Session.SecondElapsed += DeltaTime;
+		if (Session.SecondElapsed >= 1.f)
+		{
+			Session.SecondElapsed -= 1.f;
+			const UNetDriver* NetDriver = World->GetNetDriver();
+			Session.OutBytes += NetDriver ? NetDriver->OutBytesPerSecond : 0; // the driver's counter rolls over once a second
+			Session.Seconds++;
+		}
+
+		int32 Awake = 0;
+		int32 Simulating = 0;
+		for (const TWeakObjectPtr<AWeapon>& Weapon : Session.Weapons)
+		{
+			if (!Weapon.IsValid() || Weapon->GetWeaponState() != EWeaponState::EWS_Dropped) continue; // picked up meanwhile
+			Awake += Weapon->NetDormancy == DORM_Awake ? 1 : 0;
+			Simulating += Weapon->GetWeaponMesh()->IsAnyRigidBodyAwake() ? 1 : 0;
+		}
+		Session.PeakAwake = FMath::Max(Session.PeakAwake, Awake);
+		Session.PeakSimulating = FMath::Max(Session.PeakSimulating, Simulating);
+		if (Session.HalfAsleepSeconds < 0.f && Session.PeakAwake > 0 && Awake * 2 <= Session.PeakAwake)
+		{
+			Session.HalfAsleepSeconds = Session.Elapsed;
+		}
+		if ((Awake == 0 && Session.PeakAwake > 0) || Session.Elapsed >= Session.MaxSeconds)
+		{
+			Finish(Awake);
+			return false;
+		}
+		return true;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdDropStress(
+	TEXT("MPShooter.DropStress"),
+	TEXT("Server: spawns N copies (default 200) of the first weapon class in the level above the origin, drops them all at once and measures until they've all gone dormant again (at most S seconds, default 30): peak replicating and simulating weapons, time to half and all dormant, game thread time and bandwidth. Args: N S label. Appends to Profiling/MPShooter/DropStress.csv."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || World->GetNetMode() == NM_Client) return;
+		const int32 NumWeapons = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 200;
+
+		TActorIterator<AWeapon> FirstWeapon(World);
+		if (!FirstWeapon)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DropStress: no weapon in the level to copy"));
+			return;
+		}
+		if (DropStress::TickHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(DropStress::TickHandle);
+			DropStress::TickHandle.Reset();
+		}
+		DropStress::Session = DropStress::FSession();
+		DropStress::Session.World = World;
+		DropStress::Session.MaxSeconds = Args.Num() > 1 ? FMath::Max(FCString::Atof(*Args[1]), 1.f) : 30.f;
+		DropStress::Session.Label = Args.Num() > 2 ? Args[2] : TEXT("");
+
+		UClass* WeaponClass = FirstWeapon->GetClass();
+		LLM_SCOPE_BYTAG(MPShooter_Weapons);
+		const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt((float)NumWeapons));
+		FRandomStream Random(NumWeapons);
+		for (int32 Index = 0; Index < NumWeapons; ++Index)
+		{
+			const FVector Location(Index % GridSize * 150.f, Index / GridSize * 150.f, 500.f + Random.FRand() * 300.f);
+			AWeapon* Weapon = World->SpawnActor<AWeapon>(WeaponClass, Location, Random.GetUnitVector().Rotation());
+			if (Weapon)
+			{
+				Weapon->Dropped();
+				DropStress::Session.Weapons.Add(Weapon);
+			}
+		}
+		UE_LOG(LogTemp, Display, TEXT("DropStress: dropped %d x %s, measuring until they're dormant again"), DropStress::Session.Weapons.Num(), *WeaponClass->GetName());
+		DropStress::TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&DropStress::Tick));
+	}));
 
 
 
 AWeapon::AWeapon()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Weapons);
  	
 	PrimaryActorTick.bCanEverTick = false;
 	bReplicates = true;
+	bReplicateUsingRegisteredSubObjectList = true; // required by Iris, no difference on the generic path
+	NetDormancy = DORM_Initial; // Placed pickups start dormant, we wake them up with FlushNetDormancy whenever replicated state changes.
 
 	WeaponMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("WeaponMesh"));
 	SetRootComponent(WeaponMesh);
@@ -23,32 +171,42 @@ AWeapon::AWeapon()
 	WeaponMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Block);
 	WeaponMesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Ignore);
 	WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	WeaponMesh->BodyInstance.bGenerateWakeEvents = true; // Dropped weapons stop replicating movement once their body sleeps
+
+	DroppedNetUpdateFrequency = 10.f;
+	FireShotKey = 0;
 
 	AreaSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
 	AreaSphere->SetupAttachment(RootComponent);
 	AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore); // (A) We want Collision handled on the Server
 	AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
-	PickupWidget->SetupAttachment(RootComponent);
+}
 
+void AWeapon::Serialize(FArchive& Ar)
+{
+	LLM_SCOPE_BYTAG(MPShooter_Weapons);
+	Super::Serialize(Ar);
 }
 
 void AWeapon::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(MPShooter_Weapons);
 	Super::BeginPlay();
 
-	if (PickupWidget)
-	{
-		PickupWidget->SetVisibility(false);
-	}
-
 	if (HasAuthority()) // Checks Local Role, if it is Authority, returns true
 	{
+		if (!IsNetStartupActor())
+		{
+			SetNetDormancy(DORM_DormantAll); // Spawned weapons still get their initial bunch, then go dormant like placed ones.
+		}
 		AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
 		AreaSphere->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap); // (A) Sets Collision Response on Server (Authority)
 		AreaSphere->OnComponentBeginOverlap.AddDynamic(this, &AWeapon::OnSphereOverlap);
 		AreaSphere->OnComponentEndOverlap.AddDynamic(this, &AWeapon::OnSphereEndOverlap);
+		WeaponMesh->OnComponentSleep.AddDynamic(this, &AWeapon::OnWeaponMeshSleep);
+		WeaponMesh->OnComponentWake.AddDynamic(this, &AWeapon::OnWeaponMeshWake);
+		MPShooterIris::ConfigureActor(this, MPShooterIris::EReplicatedClass::Weapon);
 	}
 	
 }
@@ -86,31 +244,115 @@ void AWeapon::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActo
 
 void AWeapon::SetWeaponState(EWeaponState State)
 {
+	WakeForReplication();
 	WeaponState = State;
+	ApplyWeaponState();
+}
+
+void AWeapon::OnRep_WeaponState()
+{
+	ApplyWeaponState();
+}
+
+void AWeapon::ApplyWeaponState() // Runs on the server from SetWeaponState and on clients from OnRep
+{
+	LLM_SCOPE_BYTAG(MPShooter_Weapons);
 	switch (WeaponState)
 	{
 	case EWeaponState::EWS_Equipped:
-		ShowPickupWidget(false);
+		SetPhysicsEnabled(false);
 		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	break;
+		break;
+	case EWeaponState::EWS_Dropped:
+		SetPhysicsEnabled(true); // clients simulate too, so replicated physics has a body to correct
+		if (HasAuthority())
+		{
+			AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly); // can be picked up again
+		}
+		break;
+	default:
+		break;
 	}
 }
 
-void AWeapon::OnRep_WeaponState()
+void AWeapon::SetPhysicsEnabled(bool bEnabled)
 {
-	switch (WeaponState)
+	if (bEnabled)
 	{
-	case EWeaponState::EWS_Equipped:
-			ShowPickupWidget(false);
-			AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		WeaponMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		WeaponMesh->SetEnableGravity(true);
+		WeaponMesh->SetSimulatePhysics(true);
+		if (HasAuthority())
+		{
+			SetReplicateMovement(true);
+			SetPhysicsReplicationAwake(true);
+		}
+	}
+	else
+	{
+		if (HasAuthority() && IsReplicatingMovement())
+		{
+			SetPhysicsReplicationAwake(false);
+			SetReplicateMovement(false); // attachment to the hand replicates on its own
+		}
+		WeaponMesh->SetSimulatePhysics(false);
+		WeaponMesh->SetEnableGravity(false);
+		WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	}
 }
 
-void AWeapon::ShowPickupWidget(bool bShowWidget)
+void AWeapon::SetPhysicsReplicationAwake(bool bAwake)
 {
-	if (PickupWidget)
+	if (bAwake)
 	{
-		PickupWidget->SetVisibility(bShowWidget);
+		if (NetDormancy != DORM_Awake)
+		{
+			INC_DWORD_STAT(STAT_MPShooter_AwakeWeapons);
+		}
+		SetNetUpdateFrequency(DroppedNetUpdateFrequency); // tumbling pickups don't need character rates
+		SetNetDormancy(DORM_Awake);
+	}
+	else if (NetDormancy == DORM_Awake)
+	{
+		DEC_DWORD_STAT(STAT_MPShooter_AwakeWeapons);
+		SetNetUpdateFrequency(GetDefault<AWeapon>(GetClass())->GetNetUpdateFrequency());
+		ForceNetUpdate();
+		SetNetDormancy(DORM_DormantAll); // the channel sends the final resting transform before it goes dormant
+	}
+}
+
+void AWeapon::OnWeaponMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	if (WeaponState == EWeaponState::EWS_Dropped)
+	{
+		SetPhysicsReplicationAwake(false);
+	}
+}
+
+void AWeapon::OnWeaponMeshWake(UPrimitiveComponent* WakingComponent, FName BoneName)
+{
+	if (WeaponState == EWeaponState::EWS_Dropped)
+	{
+		SetPhysicsReplicationAwake(true); // something knocked it, replicate again until it settles
+	}
+}
+
+void AWeapon::Dropped()
+{
+	if (!HasAuthority()) return;
+
+	FDetachmentTransformRules DetachRules(EDetachmentRule::KeepWorld, true);
+	WeaponMesh->DetachFromComponent(DetachRules);
+	SetWeaponState(EWeaponState::EWS_Dropped);
+	MPShooterIris::SetReplicatesWith(GetOwner(), this, false);
+	SetOwner(nullptr);
+}
+
+void AWeapon::WakeForReplication()
+{
+	if (HasAuthority() && NetDormancy != DORM_Awake)
+	{
+		FlushNetDormancy(); // Sends pending changes (state, owner, attachment) on the next net update, then the weapon drops back to dormant.
 	}
 }
 
@@ -122,3 +364,31 @@ void AWeapon::Fire(const FVector& HitTarget)
 	}
 }
 
+void AWeapon::StopFireAnimation()
+{
+	if (FireAnimation && WeaponMesh->IsPlaying())
+	{
+		WeaponMesh->Stop();
+	}
+}
+
+void AWeapon::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (WeaponMesh->GetSkeletalMeshAsset())
+	{
+		OutAssets.Add(FSoftObjectPath(WeaponMesh->GetSkeletalMeshAsset()));
+	}
+	if (FireAnimation)
+	{
+		OutAssets.Add(FSoftObjectPath(FireAnimation));
+	}
+}
+
+FVector AWeapon::GetMuzzleLocation() const
+{
+	if (WeaponMesh->DoesSocketExist(FName("MuzzleFlash")))
+	{
+		return WeaponMesh->GetSocketLocation(FName("MuzzleFlash"));
+	}
+	return GetActorLocation();
+}
@@ -27,9 +27,12 @@ public:
 
 	virtual void Tick(float DeltaTime) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void Serialize(FArchive& Ar) override; // level-placed weapons load under the Weapons LLM tag
 
-	void ShowPickupWidget(bool ShowWidget); // (B)
 	virtual void Fire(const FVector& HitTarget);
+	void StopFireAnimation();
+	FVector GetMuzzleLocation() const; // MuzzleFlash socket, or the weapon origin if the mesh has none
+	virtual void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const; // Loaded and held while the weapon is in an inventory
 
 protected:
 	
@@ -65,20 +68,38 @@ private:
 
 	UFUNCTION()
 	void OnRep_WeaponState();
+	void ApplyWeaponState();
 
-	UPROPERTY(VisibleAnywhere, Category = "Weapon Properties")
-	class UWidgetComponent* PickupWidget;
+	void SetPhysicsEnabled(bool bEnabled);
+	void SetPhysicsReplicationAwake(bool bAwake); // Server: awake = movement replicates at DroppedNetUpdateFrequency, asleep = dormant
+
+	UFUNCTION()
+	void OnWeaponMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+	UFUNCTION()
+	void OnWeaponMeshWake(UPrimitiveComponent* WakingComponent, FName BoneName);
+
+	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
+	float DroppedNetUpdateFrequency;
 
 	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
 	class UAnimationAsset* FireAnimation;
 
+protected:
+
+	uint16 FireShotKey; // Server: prediction key of the shot being fired, stamped on its projectile
+
 
 
 public:
 
 	void SetWeaponState(EWeaponState State);
+	void Dropped(); // Server: detach, clear the owner and let physics take it
+	void WakeForReplication(); // Call on the server before changing anything that replicates (owner, attachment, movement).
 	FORCEINLINE USphereComponent* GetAreaSphere() const { return AreaSphere; }
+	FORCEINLINE EWeaponState GetWeaponState() const { return WeaponState; }
+	FORCEINLINE bool CanBePickedUp() const { return WeaponState != EWeaponState::EWS_Equipped; } // Used by the HUD pickup prompt
 	FORCEINLINE USkeletalMeshComponent* GetWeaponMesh() const { return WeaponMesh; } // Get Weapon Mesh for FABRIK IK in AnimInstance
+	FORCEINLINE void SetFireShotKey(uint16 Key) { FireShotKey = Key; }
 
 
 };